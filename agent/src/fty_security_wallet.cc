@@ -37,6 +37,8 @@
 #include <fty_log.h>
 #include <thread>
 #include "src/secw_security_wallet_server.h"
+#include "src/secw_socket_worker_pool_server.h"
+#include "src/secw_storage_format.h"
 
 static void usage()
 {
@@ -44,6 +46,8 @@ static void usage()
     puts("  -v|--verbose        verbose test output");
     puts("  -h|--help           this information");
     puts("  -c|--config         path to config file");
+    puts("  --to-json IN OUT    convert a database or mapping file to JSON and exit");
+    puts("  --to-binary IN OUT  convert a database or mapping file to binary and exit");
 }
 
 int main(int argc, char* argv[])
@@ -70,6 +74,14 @@ int main(int argc, char* argv[])
                 if (param)
                     config_file = param;
                 ++argn;
+            } else if (streq(argv[argn], "--to-json") || streq(argv[argn], "--to-binary")) {
+                if (argn + 2 >= argc) {
+                    usage();
+                    return EXIT_FAILURE;
+                }
+                secw::convertStorageFile(argv[argn + 1], argv[argn + 2],
+                    streq(argv[argn], "--to-json") ? secw::StorageFormat::JSON : secw::StorageFormat::BINARY);
+                return 0;
             }
         }
 
@@ -77,11 +89,22 @@ int main(int argc, char* argv[])
         std::string secw_actor_name(SECURITY_WALLET_AGENT);
         std::string endpoint(DEFAULT_ENDPOINT);
         std::string socketPath(DEFAULT_SOCKET);
+        std::string socketWorkers(DEFAULT_SOCKET_WORKERS);
         std::string storage_database_path(DEFAULT_STORAGE_DATABASE_PATH);
         std::string storage_access_path(DEFAULT_STORAGE_CONFIGURATION_PATH);
+        std::string storage_durability(DEFAULT_STORAGE_DURABILITY);
+        std::string storage_max_delay(DEFAULT_STORAGE_MAX_DELAY);
+        std::string storage_journal_max_size(DEFAULT_STORAGE_JOURNAL_MAX_SIZE);
+        std::string storage_fsync(DEFAULT_STORAGE_FSYNC);
+        std::string storage_fsync_period(DEFAULT_STORAGE_FSYNC_PERIOD);
+        std::string storage_format(DEFAULT_STORAGE_FORMAT);
+        std::string storage_lazy_load(DEFAULT_STORAGE_LAZY_LOAD);
+        std::string storage_load_threads(DEFAULT_STORAGE_LOAD_THREADS);
+        std::string storage_watch_configuration(DEFAULT_STORAGE_WATCH_CONFIG);
 
         std::string mapping_actor_name(MAPPING_AGENT);
         std::string storage_mapping_path(DEFAULT_STORAGE_MAPPING_PATH);
+        std::string storage_mapping_format(DEFAULT_STORAGE_MAPPING_FORMAT);
 
         // char *log_config = NULL;
         if (config_file) {
@@ -92,17 +115,38 @@ int main(int argc, char* argv[])
 
             endpoint              = config.getEntry("secw-malamute/endpoint", DEFAULT_ENDPOINT);
             socketPath            = config.getEntry("secw-socket/socket", DEFAULT_SOCKET);
+            socketWorkers         = config.getEntry("secw-socket/workers", DEFAULT_SOCKET_WORKERS);
             secw_actor_name       = config.getEntry("secw-malamute/address", SECURITY_WALLET_AGENT);
             storage_database_path = config.getEntry("secw-storage/database", DEFAULT_STORAGE_DATABASE_PATH);
             storage_access_path   = config.getEntry("secw-storage/configuration", DEFAULT_STORAGE_CONFIGURATION_PATH);
-
-            mapping_actor_name   = config.getEntry("mapping-malamute/address", MAPPING_AGENT);
-            storage_mapping_path = config.getEntry("mapping-storage/database", MAPPING_AGENT);
+            storage_durability    = config.getEntry("secw-storage/durability", DEFAULT_STORAGE_DURABILITY);
+            storage_max_delay     = config.getEntry("secw-storage/max_delay", DEFAULT_STORAGE_MAX_DELAY);
+            storage_journal_max_size =
+                config.getEntry("secw-storage/journal_max_size", DEFAULT_STORAGE_JOURNAL_MAX_SIZE);
+            storage_fsync         = config.getEntry("secw-storage/fsync", DEFAULT_STORAGE_FSYNC);
+            storage_fsync_period  = config.getEntry("secw-storage/fsync_period", DEFAULT_STORAGE_FSYNC_PERIOD);
+            storage_format        = config.getEntry("secw-storage/format", DEFAULT_STORAGE_FORMAT);
+            storage_lazy_load     = config.getEntry("secw-storage/lazy_load", DEFAULT_STORAGE_LAZY_LOAD);
+            storage_load_threads  = config.getEntry("secw-storage/load_threads", DEFAULT_STORAGE_LOAD_THREADS);
+            storage_watch_configuration =
+                config.getEntry("secw-storage/watch_configuration", DEFAULT_STORAGE_WATCH_CONFIG);
+
+            mapping_actor_name     = config.getEntry("mapping-malamute/address", MAPPING_AGENT);
+            storage_mapping_path   = config.getEntry("mapping-storage/database", MAPPING_AGENT);
+            storage_mapping_format = config.getEntry("mapping-storage/format", DEFAULT_STORAGE_MAPPING_FORMAT);
         }
 
-        log_debug(SECURITY_WALLET_AGENT ": storage_access_path '%s'", storage_access_path.c_str());
+        log_debug(SECURITY_WALLET_AGENT ": storage_access_path '%s' (watched %s)", storage_access_path.c_str(),
+            storage_watch_configuration.c_str());
         log_debug(SECURITY_WALLET_AGENT ": storage_database_path '%s'", storage_database_path.c_str());
+        log_debug(SECURITY_WALLET_AGENT ": storage_durability '%s' (max delay %s ms)", storage_durability.c_str(),
+            storage_max_delay.c_str());
+        log_debug(SECURITY_WALLET_AGENT ": storage_fsync '%s' (period %s ms)", storage_fsync.c_str(),
+            storage_fsync_period.c_str());
+        log_debug(SECURITY_WALLET_AGENT ": storage_format '%s' (lazy load %s, %s load threads)", storage_format.c_str(),
+            storage_lazy_load.c_str(), storage_load_threads.c_str());
         log_debug(SECURITY_WALLET_AGENT ": storage_mapping_path '%s'.", storage_mapping_path.c_str());
+        log_debug(SECURITY_WALLET_AGENT ": storage_mapping_format '%s'.", storage_mapping_format.c_str());
 
         if (verbose) {
             ftylog_setVerboseMode(ftylog_getInstance());
@@ -127,21 +171,44 @@ int main(int argc, char* argv[])
         mlm::MlmStreamClient notificationStream(
             SECURITY_WALLET_AGENT, SECW_NOTIFICATIONS, 1000, paramsSecw.at("ENDPOINT"));
 
+        // how the modifications are saved
+        secw::StorageOptions storageOptions;
+        storageOptions.durability     = secw::StorageOptions::durabilityFromString(storage_durability);
+        storageOptions.maxDelay       = std::chrono::milliseconds(std::stoul(storage_max_delay));
+        storageOptions.journalMaxSize = std::stoul(storage_journal_max_size);
+        storageOptions.fsyncPolicy    = secw::FsyncPolicy(secw::FsyncPolicy::modeFromString(storage_fsync),
+            std::chrono::milliseconds(std::stoul(storage_fsync_period)));
+        storageOptions.format         = secw::storageFormatFromString(storage_format);
+        storageOptions.lazyLoad       = (storage_lazy_load == "true");
+        storageOptions.loadThreads    = std::stoul(storage_load_threads);
+
+        storageOptions.watchConfiguration = (storage_watch_configuration == "true");
+
         // create the server
         secw::SecurityWalletServer serverSecw(paramsSecw.at("STORAGE_CONFIGURATION_PATH"),
             paramsSecw.at("STORAGE_DATABASE_PATH"), notificationStream, paramsSecw.at("ENDPOINT_SRR"),
-            paramsSecw.at("AGENT_NAME_SRR"));
+            paramsSecw.at("AGENT_NAME_SRR"), storageOptions);
+
+        // requests are executed by a pool of workers: one per core by default
+        size_t nbWorkers = std::stoul(socketWorkers);
+        if (nbWorkers == 0) {
+            nbWorkers = std::max(1u, std::thread::hardware_concurrency());
+        }
+        log_debug(SECURITY_WALLET_AGENT ": %zu socket workers", nbWorkers);
 
-        fty::SocketBasicServer agentSecw(serverSecw, socketPath);
+        secw::SocketWorkerPoolServer agentSecw(serverSecw, socketPath, nbWorkers);
 
-        std::thread agentSecwThread(&fty::SocketBasicServer::run, &agentSecw);
+        std::thread agentSecwThread(&secw::SocketWorkerPoolServer::run, &agentSecw);
 
         // set configuration parameters for CAM
         Arguments paramsCam;
 
-        paramsCam["STORAGE_MAPPING_PATH"] = storage_mapping_path;
-        paramsCam["AGENT_NAME"]           = mapping_actor_name;
-        paramsCam["ENDPOINT"]             = endpoint;
+        paramsCam["STORAGE_MAPPING_PATH"]   = storage_mapping_path;
+        paramsCam["STORAGE_MAPPING_FORMAT"] = storage_mapping_format;
+        paramsCam["STORAGE_FSYNC"]          = storage_fsync;
+        paramsCam["STORAGE_FSYNC_PERIOD"]   = storage_fsync_period;
+        paramsCam["AGENT_NAME"]             = mapping_actor_name;
+        paramsCam["ENDPOINT"]               = endpoint;
 
         // start broker agent
         zactor_t* cam_server = zactor_new(fty_credential_asset_mapping_mlm_agent, static_cast<void*>(&paramsCam));
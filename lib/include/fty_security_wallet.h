@@ -27,11 +27,22 @@
 #define SECURITY_WALLET_AGENT              "security-wallet"
 #define DEFAULT_STORAGE_DATABASE_PATH      "/var/lib/fty/fty-security-wallet/database.json"
 #define DEFAULT_STORAGE_CONFIGURATION_PATH "/etc/fty/fty-security-wallet/configuration.json"
+#define DEFAULT_STORAGE_DURABILITY         "sync"
+#define DEFAULT_STORAGE_MAX_DELAY          "100"
+#define DEFAULT_STORAGE_JOURNAL_MAX_SIZE   "1048576"
+#define DEFAULT_STORAGE_FSYNC              "always"
+#define DEFAULT_STORAGE_FSYNC_PERIOD       "1000"
+#define DEFAULT_STORAGE_FORMAT             "json"
+#define DEFAULT_STORAGE_LAZY_LOAD          "false"
+#define DEFAULT_STORAGE_LOAD_THREADS       "0"
+#define DEFAULT_STORAGE_WATCH_CONFIG       "true"
 #define DEFAULT_ENDPOINT                   "ipc://@/malamute"
 #define DEFAULT_SOCKET                     "/tmp/secw.socket"
+#define DEFAULT_SOCKET_WORKERS             "0"
 #define SECW_NOTIFICATIONS                 "_SECW_NOTIFICATIONS"
 #define MAPPING_AGENT                      "credential-asset-mapping"
 #define DEFAULT_STORAGE_MAPPING_PATH       "/etc/fty/fty-security-wallet/mapping.json"
+#define DEFAULT_STORAGE_MAPPING_FORMAT     "json"
 
 //  Public classes
 #include "cam_accessor.h"
@@ -62,6 +62,43 @@ using StartedCallback = std::function<void()>;
 
 class ClientAccessor;
 
+/// @brief Several requests of a consumer sent in one round trip, see ConsumerAccessor::sendBatch()
+///
+/// Each add function returns the index of its result. After the send, each get function
+/// returns the result of its request, or throws the exception of the request if it failed:
+/// the other requests are not affected.
+class ConsumerBatch
+{
+public:
+    size_t addPortfolioList();
+    size_t addConsumerUsages(const std::string& portfolioName = "default");
+    size_t addListDocumentsWithPrivateData(const std::string& portfolio, const UsageId& usageId = "");
+    size_t addDocumentWithPrivateData(const std::string& portfolio, const Id& id);
+    size_t addDocumentWithPrivateDataByName(const std::string& portfolio, const std::string& name);
+
+    /// Number of requests
+    size_t size() const
+    {
+        return m_requests.size();
+    }
+
+    std::vector<std::string> getPortfolioList(size_t index) const;
+    std::set<UsageId>        getConsumerUsages(size_t index) const;
+    std::vector<DocumentPtr> getListDocumentsWithPrivateData(size_t index) const;
+    DocumentPtr              getDocumentWithPrivateData(size_t index) const;
+
+private:
+    std::vector<std::vector<std::string>> m_requests;
+    std::vector<std::vector<std::string>> m_replies; ///< empty until the batch is sent
+
+    size_t add(std::vector<std::string> request);
+
+    /// Reply of the request, throw if it is an error
+    const std::vector<std::string>& getReply(size_t index) const;
+
+    friend class ConsumerAccessor;
+};
+
 /// @brief Give consumer access:
 /// A consumer has a list of usageId define by the server configuration.
 /// A consumer can read to documents which have a usageId in the list of the customer usageId.
@@ -93,6 +130,33 @@ public:
     std::vector<DocumentPtr> getListDocumentsWithPrivateData(
         const std::string& portfolio, const UsageId& usageId = "") const;
 
+    /// Get the List Documents With Private Data, only with the requested parts
+    /// @param portfolio name
+    /// @param usageId (empty for all)
+    /// @param projection parts of the documents: the documents without all the parts are partial
+    /// @return std::vector<DocumentPtr>
+    std::vector<DocumentPtr> getListDocumentsWithPrivateData(
+        const std::string& portfolio, const UsageId& usageId, const Projection& projection) const;
+
+    /// Get the List Documents With Private Data, requested by pages: each reply stays small
+    /// @param portfolio name
+    /// @param usageId (empty for all)
+    /// @param pageSize number of documents by request
+    /// @param projection parts of the documents (optional)
+    /// @return std::vector<DocumentPtr>
+    std::vector<DocumentPtr> getListDocumentsWithPrivateData(const std::string& portfolio, const UsageId& usageId,
+        size_t pageSize, const Projection& projection = Projection()) const;
+
+    /// Get a page of the List Documents With Private Data, ordered by id
+    /// @param portfolio name
+    /// @param usageId (empty for all)
+    /// @param limit maximum number of documents of the page
+    /// @param[in|out] cursor: empty for the first page, empty after the last page
+    /// @param projection parts of the documents (optional)
+    /// @return std::vector<DocumentPtr>
+    std::vector<DocumentPtr> getPageDocumentsWithPrivateData(const std::string& portfolio, const UsageId& usageId,
+        size_t limit, std::string& cursor, const Projection& projection = Projection()) const;
+
     /// Get the List Documents With Private Data from a list of id.
     ///
     /// If a document cannot be retrived (bad id or none access right), this document will not be on the list.
@@ -103,18 +167,55 @@ public:
     std::vector<DocumentPtr> getListDocumentsWithPrivateData(
         const std::string& portfolio, const std::vector<Id>& ids) const;
 
+    /// Get the Documents With Private Data from a list of id, in one request
+    /// @param portfolio name
+    /// @param list of id requested
+    /// @param projection parts of the documents (optional)
+    /// @return DocumentsByIds: the documents which have been retrieved and the status of each id.
+    DocumentsByIds getDocumentsWithPrivateData(
+        const std::string& portfolio, const std::vector<Id>& ids, const Projection& projection = Projection()) const;
+
     /// Get a Document With Private Data object
     /// @param portfolio name
     /// @param id of the document
     /// @return DocumentPtr on the document.
     DocumentPtr getDocumentWithPrivateData(const std::string& portfolio, const Id& id) const;
 
+    /// Get a Document With Private Data object, only with the requested parts
+    /// @param portfolio name
+    /// @param id of the document
+    /// @param projection parts of the document: the document without all the parts is partial
+    /// @return DocumentPtr on the document.
+    DocumentPtr getDocumentWithPrivateData(
+        const std::string& portfolio, const Id& id, const Projection& projection) const;
+
+    /// Get a Document With Private Data object, without transfer if the cached one is current
+    /// @param portfolio name
+    /// @param id of the document
+    /// @param cachedDocument document previously received by the caller (nullptr if none)
+    /// @return cachedDocument if it has the current version, else the current document.
+    DocumentPtr getDocumentWithPrivateData(
+        const std::string& portfolio, const Id& id, const DocumentPtr& cachedDocument) const;
+
     /// Get a Document With Private Data object
     /// @param portfolio name
     /// @param name of the document
     /// @return DocumentPtr on the document.
     DocumentPtr getDocumentWithPrivateDataByName(const std::string& portfolio, const std::string& name) const;
 
+    /// Get a Document With Private Data object, without transfer if the cached one is current
+    /// @param portfolio name
+    /// @param name of the document
+    /// @param cachedDocument document previously received by the caller (nullptr if none)
+    /// @return cachedDocument if it has the current version, else the current document.
+    DocumentPtr getDocumentWithPrivateDataByName(
+        const std::string& portfolio, const std::string& name, const DocumentPtr& cachedDocument) const;
+
+    /// Send the requests of the batch in one round trip, the replies are read from the batch.
+    /// The wallet must support the BATCH command.
+    /// @param batch requests, then replies
+    void sendBatch(ConsumerBatch& batch) const;
+
     /// Set callback for update notification
     /// @param callback
     void setCallbackOnUpdate(UpdatedCallback updatedCallback = nullptr);
@@ -21,11 +21,15 @@
 
 #pragma once
 
+#include "secw_document_id.h"
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace cxxtools {
 class SerializationInfo;
@@ -36,12 +40,16 @@ class Portfolio;
 class Document;
 
 /// Some typedef to make the code more clear
-using Id           = std::string;
-using UsageId      = std::string;
-using Type         = std::string;
-using Tag          = std::string;
-using DocumentType = std::string;
-using DocumentPtr  = std::shared_ptr<Document>;
+using Id               = std::string;
+using UsageId          = std::string;
+using Type             = std::string;
+using Tag              = std::string;
+using DocumentType     = std::string;
+using DocumentPtr      = std::shared_ptr<Document>;
+using ConstDocumentPtr = std::shared_ptr<const Document>;
+
+/// Tag or usage, stored once for all the documents of the process
+using InternedString = std::shared_ptr<const std::string>;
 
 /// FctDocumentFactory is returning a shared ptr of Doccument after building it using default contructor
 using FctDocumentFactory = std::function<DocumentPtr()>;
@@ -54,6 +62,57 @@ static constexpr const char* DOC_TAGS_ENTRY    = "secw_doc_tags";
 static constexpr const char* DOC_USAGES_ENTRY  = "secw_doc_usages";
 static constexpr const char* DOC_PUBLIC_ENTRY  = "secw_doc_public";
 static constexpr const char* DOC_PRIVATE_ENTRY = "secw_doc_private";
+static constexpr const char* DOC_PARTIAL_ENTRY = "secw_doc_partial";
+static constexpr const char* DOC_VERSION_ENTRY = "secw_doc_version";
+
+/// Parts of a document given by the list and get commands: the id and the type are always given.
+/// A document given without its name, tags, usages or public part is partial.
+struct Projection
+{
+    bool name        = true;
+    bool tags        = true;
+    bool usages      = true;
+    bool publicPart  = true;
+    bool privatePart = true; ///< never given by the commands without secret
+
+    /// Name, tags and usages
+    static Projection header();
+
+    /// Parse a comma separated list of parts: name, tags, usages, header (the 3 previous), public, private.
+    /// Empty for all the parts.
+    /// @exceptions SecwBadCommandArgumentException on an unknown part
+    static Projection fromString(const std::string& text);
+
+    /// Empty for all the parts
+    std::string toString() const;
+
+    bool isPartial() const;
+};
+
+/// Documents modified in a portfolio since a generation, see GET_CHANGES_SINCE
+struct DocumentChanges
+{
+    std::string     generation;         ///< generation including these changes, for the next request
+    bool            fullResync = false; ///< the changes are not known: all the documents must be listed again
+    std::vector<Id> created;
+    std::vector<Id> updated;
+    std::vector<Id> deleted;
+};
+
+/// Status of each id of a request by ids, see GET_WITH_SECRET_BY_IDS
+enum class DocumentStatus : uint8_t
+{
+    FOUND = 0,
+    DOES_NOT_EXIST,
+    ILLEGAL_ACCESS
+};
+
+/// Documents requested by ids
+struct DocumentsByIds
+{
+    std::vector<DocumentPtr>    documents; ///< found documents, in the order of the ids
+    std::vector<DocumentStatus> statuses;  ///< status of each requested id, in the order of the ids
+};
 
 /// Document: Public interface
 class Document
@@ -64,6 +123,9 @@ class Document
 public:
     bool isContainingPrivateData() const;
 
+    /// Tell if some parts of the document were not requested (see Projection): it cannot be inserted or updated
+    bool isPartial() const;
+
     const std::string& getName() const;
     void               setName(const std::string& name);
 
@@ -75,8 +137,21 @@ public:
     void              removeUsage(const UsageId& id);
     std::set<UsageId> getUsageIds() const;
 
+    /// Tags and usages without copy of the strings, sorted by text
+    const std::vector<InternedString>& getInternedTags() const;
+    const std::vector<InternedString>& getInternedUsageIds() const;
+
     const DocumentType& getType() const;
-    const Id&           getId() const;
+
+    /// Text of the id, built at each call
+    Id getId() const;
+
+    /// Id without conversion to text
+    const DocumentId& getDocumentId() const;
+
+    /// Version of the document in the wallet: 1 at its creation, incremented by each update.
+    /// 0 for a document never stored or stored by a former version of the wallet.
+    uint64_t getVersion() const;
 
     /// Clone any document - useful to apply modification before to update
     /// @return shared ptr on a document
@@ -100,6 +175,11 @@ public:
     /// @param[in|out] cxxtools::SerializationInfo
     void fillSerializationInfoWithoutSecret(cxxtools::SerializationInfo& si) const;
 
+    /// Append the serialization of the parts of the document given by the projection.
+    /// @param[in|out] cxxtools::SerializationInfo
+    /// @param[in] projection
+    void fillSerializationInfo(cxxtools::SerializationInfo& si, const Projection& projection) const;
+
     /// Append the serialization of the document for SRR.
     /// @param[in|out] cxxtools::SerializationInfo
     /// @param[in] enctyption key use to encrypt private part
@@ -108,12 +188,12 @@ public:
     /// Compare the non secret part of 2 documents
     /// @param[in] Other DocumentPtr
     /// @return true if non secret information are the same
-    bool isNonSecretEquals(const DocumentPtr& other) const;
+    bool isNonSecretEquals(const ConstDocumentPtr& other) const;
 
     /// Compare the secret part of 2 documents
     /// @param[in] Other DocumentPtr
     /// @return true if secret information are the same
-    bool isSecretEquals(const DocumentPtr& other) const;
+    bool isSecretEquals(const ConstDocumentPtr& other) const;
 
     /// Return a document Ptr from a serilization from SRR
     /// @return DocumentPtr
@@ -143,16 +223,18 @@ protected:
     {
     }
 
-    std::string       m_name = "";
-    DocumentType      m_type = "";
-    Id                m_id   = "";
-    std::set<Tag>     m_tags;
-    std::set<UsageId> m_usages;
+    std::string                 m_name    = "";
+    DocumentType                m_type    = "";
+    DocumentId                  m_id;
+    uint64_t                    m_version = 0;
+    std::vector<InternedString> m_tags;   ///< sorted by text
+    std::vector<InternedString> m_usages; ///< sorted by text
 
     // This map is use to define the supported type and how to build them
     static std::map<DocumentType, FctDocumentFactory> m_documentFactoryFuntions;
 
     bool m_containPrivateData = true;
+    bool m_partial            = false;
 
     virtual void fillSerializationInfoPrivateDoc(cxxtools::SerializationInfo& si) const = 0;
     virtual void fillSerializationInfoPublicDoc(cxxtools::SerializationInfo& si) const  = 0;
@@ -161,9 +243,11 @@ protected:
     virtual void updatePublicDocFromSerializationInfo(const cxxtools::SerializationInfo& si)  = 0;
 
 private:
-    void fillSerializationInfoHeaderDoc(cxxtools::SerializationInfo& si) const;
+    void fillSerializationInfoHeaderDoc(
+        cxxtools::SerializationInfo& si, const Projection& projection = Projection()) const;
 
-    void updateHeaderFromSerializationInfo(const cxxtools::SerializationInfo& si);
+    // the missing entries are accepted for a partial document
+    void updateHeaderFromSerializationInfo(const cxxtools::SerializationInfo& si, bool partial = false);
 };
 
 // save as fillSerializationInfoWithSecret
@@ -171,6 +255,14 @@ void operator<<=(cxxtools::SerializationInfo& si, const Document& doc);
 void operator<<=(cxxtools::SerializationInfo& si, const DocumentPtr& doc);
 void operator>>=(const cxxtools::SerializationInfo& si, DocumentPtr& doc);
 
+void operator<<=(cxxtools::SerializationInfo& si, const DocumentChanges& changes);
+void operator>>=(const cxxtools::SerializationInfo& si, DocumentChanges& changes);
+
+void operator<<=(cxxtools::SerializationInfo& si, const std::vector<DocumentStatus>& statuses);
+void operator>>=(const cxxtools::SerializationInfo& si, std::vector<DocumentStatus>& statuses);
+
+void operator>>=(const cxxtools::SerializationInfo& si, DocumentsByIds& documents);
+
 void operator<<=(std::string& str, const Document& doc);
 void operator<<=(std::string& str, const DocumentPtr& doc);
 void operator<<=(std::string& str, const std::vector<DocumentPtr>& docs);
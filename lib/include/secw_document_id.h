@@ -0,0 +1,126 @@
+/*  =========================================================================
+    secw_document_id - Identifier of a document in 16 bytes
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace secw {
+
+/// @brief Identifier of a document in 16 bytes
+///
+/// The ids created by the wallet are random UUIDs: they are kept in binary and converted
+/// to their canonical text (lowercase, with dashes) only for the protocol and the storage.
+/// Any other id, created by hand or by a former version, is kept as a text shared by the
+/// copies of the id: the text of an id never changes.
+class DocumentId
+{
+public:
+    /// Empty id
+    DocumentId() = default;
+
+    explicit DocumentId(std::string_view text);
+
+    DocumentId(const DocumentId& other);
+    DocumentId(DocumentId&& other) noexcept;
+    DocumentId& operator=(const DocumentId& other);
+    DocumentId& operator=(DocumentId&& other) noexcept;
+    ~DocumentId();
+
+    /// Random UUID (version 4), from a generator owned by the calling thread
+    static DocumentId generate();
+
+    /// Compact id of the text, without building any string.
+    /// Return false if the text is not a lowercase UUID of variant 1 (RFC 4122): the id is kept as text.
+    static bool parseCompact(std::string_view text, DocumentId& id);
+
+    /// Hash of an id kept as text, the same as DocumentId(text).hash()
+    static uint64_t hashText(std::string_view text);
+
+    std::string toString() const;
+
+    bool empty() const
+    {
+        return (m_high == 0) && (m_low == 0);
+    }
+
+    bool isCompact() const
+    {
+        return (m_low >> 62) == COMPACT_VARIANT;
+    }
+
+    /// Text of an id which is not compact, empty for a compact one
+    std::string_view getText() const;
+
+    uint64_t hash() const;
+
+    bool operator==(const DocumentId& other) const
+    {
+        // 2 copies of a text share it, 2 ids with the same text may not
+        if (isText() && other.isText()) {
+            return getText() == other.getText();
+        }
+
+        return (m_high == other.m_high) && (m_low == other.m_low);
+    }
+
+    bool operator!=(const DocumentId& other) const
+    {
+        return !(*this == other);
+    }
+
+    /// Order of the texts of the ids
+    bool operator<(const DocumentId& other) const;
+
+private:
+    struct Text;
+
+    // variant 1 of RFC 4122 in the 2 upper bits of m_low: the compact ids
+    static constexpr const uint64_t COMPACT_VARIANT = 2;
+
+    // m_low of an id kept as text, never the one of a compact id
+    static constexpr const uint64_t TEXT_TAG = 1;
+
+    // compact: bytes 0 to 7 of the UUID, text: address of the Text, empty: 0
+    uint64_t m_high = 0;
+
+    // compact: bytes 8 to 15 of the UUID, text: TEXT_TAG, empty: 0
+    uint64_t m_low = 0;
+
+    bool isText() const
+    {
+        return m_low == TEXT_TAG;
+    }
+
+    Text* text() const
+    {
+        return reinterpret_cast<Text*>(uintptr_t(m_high));
+    }
+
+    void release();
+
+    // canonical text of a compact id
+    void format(char* text) const;
+};
+
+} // namespace secw
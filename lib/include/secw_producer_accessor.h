@@ -88,6 +88,33 @@ public:
     std::vector<DocumentPtr> getListDocumentsWithoutPrivateData(
         const std::string& portfolio, const UsageId& usageId = "") const;
 
+    /// Get the List Documents Without Private Data, only with the requested parts
+    /// @param portfolio name
+    /// @param usageId (empty for all)
+    /// @param projection parts of the documents: the documents without all the parts are partial
+    /// @return std::vector<DocumentPtr>
+    std::vector<DocumentPtr> getListDocumentsWithoutPrivateData(
+        const std::string& portfolio, const UsageId& usageId, const Projection& projection) const;
+
+    /// Get the List Documents Without Private Data, requested by pages: each reply stays small
+    /// @param portfolio name
+    /// @param usageId (empty for all)
+    /// @param pageSize number of documents by request
+    /// @param projection parts of the documents (optional)
+    /// @return std::vector<DocumentPtr>
+    std::vector<DocumentPtr> getListDocumentsWithoutPrivateData(const std::string& portfolio, const UsageId& usageId,
+        size_t pageSize, const Projection& projection = Projection()) const;
+
+    /// Get a page of the List Documents Without Private Data, ordered by id
+    /// @param portfolio name
+    /// @param usageId (empty for all)
+    /// @param limit maximum number of documents of the page
+    /// @param[in|out] cursor: empty for the first page, empty after the last page
+    /// @param projection parts of the documents (optional)
+    /// @return std::vector<DocumentPtr>
+    std::vector<DocumentPtr> getPageDocumentsWithoutPrivateData(const std::string& portfolio, const UsageId& usageId,
+        size_t limit, std::string& cursor, const Projection& projection = Projection()) const;
+
     /// Get the List Documents Without Private Data from a list of id.
     /// If a document cannot be retrived (bad id), this document will not be on the list.
     /// @param portfolio name
@@ -96,18 +123,40 @@ public:
     std::vector<DocumentPtr> getListDocumentsWithoutPrivateData(
         const std::string& portfolio, const std::vector<Id>& ids) const;
 
+    /// Get the Documents Without Private Data from a list of id, in one request
+    /// @param portfolio name
+    /// @param list of id requested
+    /// @param projection parts of the documents (optional)
+    /// @return DocumentsByIds: the documents which have been retrieved and the status of each id.
+    DocumentsByIds getDocumentsWithoutPrivateData(
+        const std::string& portfolio, const std::vector<Id>& ids, const Projection& projection = Projection()) const;
+
     /// Get a Document Without Private Data object
     /// @param portfolio name
     /// @param id of the document
     /// @return DocumentPtr on the document.
     DocumentPtr getDocumentWithoutPrivateData(const std::string& portfolio, const Id& id) const;
 
+    /// Get a Document Without Private Data object, only with the requested parts
+    /// @param portfolio name
+    /// @param id of the document
+    /// @param projection parts of the document: the document without all the parts is partial
+    /// @return DocumentPtr on the document.
+    DocumentPtr getDocumentWithoutPrivateData(
+        const std::string& portfolio, const Id& id, const Projection& projection) const;
+
     /// Get a Document Without Private Data object
     /// @param portfolio name
     /// @param name of the document
     /// @return DocumentPtr on the document.
     DocumentPtr getDocumentWithoutPrivateDataByName(const std::string& portfolio, const std::string& name) const;
 
+    /// Get the documents modified since a generation, to update a copy of the portfolio
+    /// @param portfolio name
+    /// @param generation of the previous call, empty for the first one
+    /// @return DocumentChanges: if fullResync is set, all the documents must be listed again
+    DocumentChanges getChangesSince(const std::string& portfolio, const std::string& generation) const;
+
     /// Insert a new document into the server database
     /// @param portfolio name
     /// @param document
@@ -124,6 +173,22 @@ public:
     /// @param id of the document to be removed
     void deleteDocument(const std::string& portfolio, const Id& id) const;
 
+    /// Insert new documents into the server database, all or nothing: on error, none is inserted
+    /// @param portfolio name
+    /// @param documents
+    /// @return Ids of the new documents, in the order of the documents
+    std::vector<Id> insertNewDocuments(const std::string& portfolio, const std::vector<DocumentPtr>& docs) const;
+
+    /// Update documents into the server database, all or nothing. The documents must exist into the database.
+    /// @param portfolio name
+    /// @param documents
+    void updateDocuments(const std::string& portfolio, const std::vector<DocumentPtr>& docs) const;
+
+    /// Delete documents from the server database, all or nothing. The documents must exist into the database.
+    /// @param portfolio name
+    /// @param ids of the documents to be removed
+    void deleteDocuments(const std::string& portfolio, const std::vector<Id>& ids) const;
+
     /// Set callback for update notification
     /// @param callback
     void setCallbackOnUpdate(UpdatedCallback updatedCallback = nullptr);
@@ -39,8 +39,9 @@
 using namespace std::placeholders;
 
 namespace cam {
-CredentialAssetMappingServer::CredentialAssetMappingServer(const std::string& storagePath)
-    : m_activeMapping(storagePath)
+CredentialAssetMappingServer::CredentialAssetMappingServer(
+    const std::string& storagePath, secw::StorageFormat storageFormat, const secw::FsyncPolicy& fsyncPolicy)
+    : m_activeMapping(storagePath, storageFormat, fsyncPolicy)
 {
     // initiate the commands handlers
     m_supportedCommands[CREATE_MAPPING] = std::bind(&CredentialAssetMappingServer::handleCreateMapping, this, _1, _2);
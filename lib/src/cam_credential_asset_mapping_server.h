@@ -43,7 +43,9 @@ class CredentialAssetMappingServer final : public fty::SyncServer
 {
 
 public:
-    explicit CredentialAssetMappingServer(const std::string& storagePath);
+    explicit CredentialAssetMappingServer(const std::string& storagePath,
+        secw::StorageFormat      storageFormat = secw::StorageFormat::JSON,
+        const secw::FsyncPolicy& fsyncPolicy   = secw::FsyncPolicy());
 
     std::vector<std::string> handleRequest(const Sender& sender, const std::vector<std::string>& payload) override;
 
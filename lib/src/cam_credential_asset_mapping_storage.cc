@@ -21,8 +21,6 @@
 
 #include "cam_credential_asset_mapping_storage.h"
 #include "cam_helpers.h"
-#include <cxxtools/jsondeserializer.h>
-#include <cxxtools/jsonserializer.h>
 #include <fstream>
 #include <fty_log.h>
 #include <iostream>
@@ -31,8 +29,11 @@
 
 namespace cam {
 
-CredentialAssetMappingStorage::CredentialAssetMappingStorage(const std::string& databasePath)
+CredentialAssetMappingStorage::CredentialAssetMappingStorage(
+    const std::string& databasePath, secw::StorageFormat format, const secw::FsyncPolicy& fsyncPolicy)
     : m_pathDatabase(databasePath)
+    , m_format(format)
+    , m_snapshotWriter(databasePath, fsyncPolicy)
 {
     // Load database
     log_info(" Loading mapping from %s ...", m_pathDatabase.c_str());
@@ -44,11 +45,9 @@ CredentialAssetMappingStorage::CredentialAssetMappingStorage(const std::string&
         if (fileExist) {
             std::ifstream input;
 
-            input.open(m_pathDatabase);
+            input.open(m_pathDatabase, std::ios::binary);
 
-            cxxtools::SerializationInfo rootSi;
-            cxxtools::JsonDeserializer  deserializer(input);
-            deserializer.deserialize(rootSi);
+            cxxtools::SerializationInfo rootSi = secw::readStorage(input);
 
             uint8_t version = 0;
             rootSi.getMember("version") >>= version;
@@ -83,6 +82,11 @@ CredentialAssetMappingStorage::CredentialAssetMappingStorage(const std::string&
         log_error("Error while saving into mapping file %s\n %s", m_pathDatabase.c_str(), e.what());
         exit(EXIT_FAILURE);
     }
+
+    m_fsyncTimer.reset(new secw::FsyncTimer(fsyncPolicy, [this]() {
+        std::unique_lock<std::mutex> lock(m_writeLock);
+        m_snapshotWriter.syncPending();
+    }));
 }
 
 void CredentialAssetMappingStorage::save() const
@@ -102,14 +106,11 @@ void CredentialAssetMappingStorage::save() const
 
     rootSi.addMember("mappings") <<= list;
 
-    // open the file
-    std::ofstream output(m_pathDatabase.c_str());
-
-    cxxtools::JsonSerializer serializer(output);
-    serializer.beautify(true);
-    serializer.serialize(rootSi);
-
-    output.close();
+    // replace the file => a crash keeps the former mapping
+    std::unique_lock<std::mutex> lock(m_writeLock);
+    m_snapshotWriter.write([this, &rootSi](std::ostream& output) {
+        secw::writeStorage(output, rootSi, m_format);
+    });
 }
 
 const CredentialAssetMapping& CredentialAssetMappingStorage::getMapping(
@@ -22,7 +22,10 @@
 #pragma once
 
 #include "cam_credential_asset_mapping.h"
+#include "secw_snapshot_writer.h"
+#include "secw_storage_format.h"
 #include <memory>
+#include <mutex>
 
 namespace cam {
 using Hash = std::string;
@@ -30,7 +33,10 @@ using Hash = std::string;
 class CredentialAssetMappingStorage
 {
 public:
-    explicit CredentialAssetMappingStorage(const std::string& databasePath);
+    /// The mapping file is synchronized on the disk with the same policy as the wallet
+    explicit CredentialAssetMappingStorage(const std::string& databasePath,
+        secw::StorageFormat      format      = secw::StorageFormat::JSON,
+        const secw::FsyncPolicy& fsyncPolicy = secw::FsyncPolicy());
     void save() const;
 
     const CredentialAssetMapping& getMapping(
@@ -55,8 +61,18 @@ public:
 
 private:
     std::string                            m_pathDatabase;
+    secw::StorageFormat                    m_format;
     std::map<Hash, CredentialAssetMapping> m_mappings;
 
+    // keep statistics => modified by save
+    mutable secw::SnapshotWriter m_snapshotWriter;
+
+    // one write of the file at a time: the fsync timer runs in its own thread
+    mutable std::mutex m_writeLock;
+
+    // last member => stopped before the writer is destroyed
+    std::unique_ptr<secw::FsyncTimer> m_fsyncTimer;
+
     static Hash computeHash(const AssetId& assetId, const ServiceId& serviceId, const Protocol& protocol);
 };
 
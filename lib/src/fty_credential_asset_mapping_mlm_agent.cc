@@ -36,8 +36,25 @@ void fty_credential_asset_mapping_mlm_agent(zsock_t* pipe, void* args)
 
     const Arguments& arguments = *static_cast<Arguments*>(args);
 
+    // the format is optional, JSON by default
+    secw::StorageFormat format = secw::StorageFormat::JSON;
+    if (arguments.count("STORAGE_MAPPING_FORMAT") > 0) {
+        format = secw::storageFormatFromString(arguments.at("STORAGE_MAPPING_FORMAT"));
+    }
+
+    // the fsync policy is optional, the mapping is always synchronized by default
+    secw::FsyncPolicy fsyncPolicy;
+    if (arguments.count("STORAGE_FSYNC") > 0) {
+        std::chrono::milliseconds period(1000);
+        if (arguments.count("STORAGE_FSYNC_PERIOD") > 0) {
+            period = std::chrono::milliseconds(std::stoul(arguments.at("STORAGE_FSYNC_PERIOD")));
+        }
+
+        fsyncPolicy = secw::FsyncPolicy(secw::FsyncPolicy::modeFromString(arguments.at("STORAGE_FSYNC")), period);
+    }
+
     // create the server
-    cam::CredentialAssetMappingServer server(arguments.at("STORAGE_MAPPING_PATH"));
+    cam::CredentialAssetMappingServer server(arguments.at("STORAGE_MAPPING_PATH"), format, fsyncPolicy);
 
     // launch the agent
     mlm::MlmBasicMailboxServer agent(pipe, server, arguments.at("AGENT_NAME"), arguments.at("ENDPOINT"));
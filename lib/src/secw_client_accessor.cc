@@ -21,6 +21,7 @@
 
 #include "secw_client_accessor.h"
 #include "secw_helpers.h"
+#include "secw_security_wallet_server.h"
 #include <fty_log.h>
 #include <iomanip>
 #include <sstream>
@@ -57,16 +58,67 @@ std::vector<std::string> ClientAccessor::sendCommand(
 
     std::vector<std::string> receivedFrames = m_requestClient.syncRequestWithReply(payload);
 
+    checkReply(receivedFrames);
+    return receivedFrames;
+}
+
+std::vector<std::vector<std::string>> ClientAccessor::sendBatch(
+    const std::vector<std::vector<std::string>>& commands) const
+{
+    if (commands.empty()) {
+        return {};
+    }
+
+    // each command is preceded by its number of frames
+    std::vector<std::string> frames;
+    for (const std::vector<std::string>& command : commands) {
+        frames.push_back(std::to_string(command.size()));
+        frames.insert(frames.end(), command.begin(), command.end());
+    }
+
+    std::vector<std::string> receivedFrames = sendCommand(SecurityWalletServer::BATCH, frames);
+
+    // same for the replies
+    std::vector<std::vector<std::string>> replies;
+
+    size_t index = 0;
+    while (index < receivedFrames.size()) {
+        const std::string& nbFramesText = receivedFrames[index];
+
+        if (nbFramesText.empty() || (nbFramesText.size() > 9) ||
+            (nbFramesText.find_first_not_of("0123456789") != std::string::npos)) {
+            throw SecwProtocolErrorException("Bad number of frames <" + nbFramesText + "> in batch reply");
+        }
+
+        size_t nbFrames = size_t(std::stoul(nbFramesText));
+        index++;
+
+        if (nbFrames > receivedFrames.size() - index) {
+            throw SecwProtocolErrorException("Truncated reply in batch");
+        }
+
+        replies.emplace_back(receivedFrames.begin() + long(index), receivedFrames.begin() + long(index + nbFrames));
+        index += nbFrames;
+    }
+
+    if (replies.size() != commands.size()) {
+        throw SecwProtocolErrorException("Bad number of replies in batch");
+    }
+
+    return replies;
+}
+
+void ClientAccessor::checkReply(const std::vector<std::string>& frames)
+{
     // check if the first frame we get is an error
-    if (receivedFrames[0] == "ERROR") {
+    if (!frames.empty() && (frames[0] == "ERROR")) {
         // It's an error and we will throw directly the exceptions
-        if (receivedFrames.size() == 2) {
-            SecwException::throwSecwException(receivedFrames.at(1));
+        if (frames.size() == 2) {
+            SecwException::throwSecwException(frames.at(1));
         } else {
             throw SecwProtocolErrorException("Missing data for error");
         }
     }
-    return receivedFrames;
 }
 
 void ClientAccessor::updateNotificationThread()
@@ -45,6 +45,13 @@ public:
 
     std::vector<std::string> sendCommand(const std::string& command, const std::vector<std::string>& frames) const;
 
+    /// Several commands (command and parameters) in one request: a reply by command, in order.
+    /// The replies are not checked: a reply may be an error, see checkReply().
+    std::vector<std::vector<std::string>> sendBatch(const std::vector<std::vector<std::string>>& commands) const;
+
+    /// Throw the exception of the reply if it is an error
+    static void checkReply(const std::vector<std::string>& frames);
+
     void setCallbackOnUpdate(UpdatedCallback updatedCallback = nullptr);
     void setCallbackOnCreate(CreatedCallback createdCallback = nullptr);
     void setCallbackOnDelete(DeletedCallback deletedCallback = nullptr);
@@ -35,56 +35,191 @@
 #include <cxxtools/serializationinfo.h>
 
 namespace secw {
-ConsumerAccessor::ConsumerAccessor(fty::SocketSyncClient& requestClient)
+// only a complete document received from the wallet can be compared with the current version
+static bool isComparable(const DocumentPtr& cachedDocument)
 {
-    m_clientAccessor = std::make_shared<ClientAccessor>(requestClient);
+    return cachedDocument && (cachedDocument->getVersion() != 0) && cachedDocument->isContainingPrivateData() &&
+           !cachedDocument->isPartial();
 }
 
-ConsumerAccessor::ConsumerAccessor(fty::SocketSyncClient& requestClient, mlm::MlmStreamClient& subscriberClient)
+// the cached document if the server tells it is current, else the document of the reply
+static DocumentPtr getDocumentFromReply(const std::vector<std::string>& frames, const DocumentPtr& cachedDocument)
 {
-    m_clientAccessor = std::make_shared<ClientAccessor>(requestClient, subscriberClient);
+    // the first frame should contain the data
+    if (frames.size() < 1) {
+        throw SecwProtocolErrorException("Empty answer from server");
+    }
+
+    if (frames.at(0) == SecurityWalletServer::NOT_MODIFIED) {
+        return cachedDocument;
+    }
+
+    cxxtools::SerializationInfo si = deserialize(frames.at(0));
+
+    DocumentPtr document;
+
+    si >>= document;
+
+    return document;
 }
 
-std::vector<std::string> ConsumerAccessor::getPortfolioList() const
+// value of the first frame of the reply
+template <typename T>
+static T getValueFromReply(const std::vector<std::string>& frames)
 {
-    std::vector<std::string> frames = m_clientAccessor->sendCommand(SecurityWalletServer::GET_PORTFOLIO_LIST, {});
-
     if (frames.size() < 1) {
         throw SecwProtocolErrorException("Empty answer from server");
     }
 
     cxxtools::SerializationInfo si = deserialize(frames.at(0));
 
-    std::vector<std::string> portfolioNames;
+    T value;
 
-    si >>= portfolioNames;
+    si >>= value;
 
-    return portfolioNames;
+    return value;
 }
 
-std::set<UsageId> ConsumerAccessor::getConsumerUsages(const std::string& portfolioName) const
+size_t ConsumerBatch::add(std::vector<std::string> request)
+{
+    m_requests.push_back(std::move(request));
+    m_replies.clear();
+
+    return m_requests.size() - 1;
+}
+
+size_t ConsumerBatch::addPortfolioList()
+{
+    return add({SecurityWalletServer::GET_PORTFOLIO_LIST});
+}
+
+size_t ConsumerBatch::addConsumerUsages(const std::string& portfolioName)
+{
+    return add({SecurityWalletServer::GET_CONSUMER_USAGES, portfolioName});
+}
+
+size_t ConsumerBatch::addListDocumentsWithPrivateData(const std::string& portfolio, const UsageId& usageId)
+{
+    return add({SecurityWalletServer::GET_LIST_WITH_SECRET, portfolio, usageId});
+}
+
+size_t ConsumerBatch::addDocumentWithPrivateData(const std::string& portfolio, const Id& id)
+{
+    return add({SecurityWalletServer::GET_WITH_SECRET, portfolio, id});
+}
+
+size_t ConsumerBatch::addDocumentWithPrivateDataByName(const std::string& portfolio, const std::string& name)
+{
+    return add({SecurityWalletServer::GET_WITH_SECRET_BY_NAME, portfolio, name});
+}
+
+const std::vector<std::string>& ConsumerBatch::getReply(size_t index) const
+{
+    if (index >= m_replies.size()) {
+        throw SecwProtocolErrorException("No reply for the request " + std::to_string(index) + " of the batch");
+    }
+
+    ClientAccessor::checkReply(m_replies[index]);
+
+    return m_replies[index];
+}
+
+std::vector<std::string> ConsumerBatch::getPortfolioList(size_t index) const
+{
+    return getValueFromReply<std::vector<std::string>>(getReply(index));
+}
+
+std::set<UsageId> ConsumerBatch::getConsumerUsages(size_t index) const
+{
+    return getValueFromReply<std::set<UsageId>>(getReply(index));
+}
+
+std::vector<DocumentPtr> ConsumerBatch::getListDocumentsWithPrivateData(size_t index) const
+{
+    return getValueFromReply<std::vector<DocumentPtr>>(getReply(index));
+}
+
+DocumentPtr ConsumerBatch::getDocumentWithPrivateData(size_t index) const
+{
+    return getValueFromReply<DocumentPtr>(getReply(index));
+}
+
+ConsumerAccessor::ConsumerAccessor(fty::SocketSyncClient& requestClient)
+{
+    m_clientAccessor = std::make_shared<ClientAccessor>(requestClient);
+}
+
+ConsumerAccessor::ConsumerAccessor(fty::SocketSyncClient& requestClient, mlm::MlmStreamClient& subscriberClient)
 {
-    std::set<UsageId> usages;
+    m_clientAccessor = std::make_shared<ClientAccessor>(requestClient, subscriberClient);
+}
 
+std::vector<std::string> ConsumerAccessor::getPortfolioList() const
+{
+    std::vector<std::string> frames = m_clientAccessor->sendCommand(SecurityWalletServer::GET_PORTFOLIO_LIST, {});
+
+    return getValueFromReply<std::vector<std::string>>(frames);
+}
+
+std::set<UsageId> ConsumerAccessor::getConsumerUsages(const std::string& portfolioName) const
+{
     std::vector<std::string> frames =
         m_clientAccessor->sendCommand(SecurityWalletServer::GET_CONSUMER_USAGES, {portfolioName});
 
+    return getValueFromReply<std::set<UsageId>>(frames);
+}
+
+std::vector<DocumentPtr> ConsumerAccessor::getListDocumentsWithPrivateData(
+    const std::string& portfolio, const UsageId& usageId) const
+{
+    return getListDocumentsWithPrivateData(portfolio, usageId, Projection());
+}
+
+std::vector<DocumentPtr> ConsumerAccessor::getListDocumentsWithPrivateData(
+    const std::string& portfolio, const UsageId& usageId, const Projection& projection) const
+{
+    // the former servers do not know the projection: it is sent only when needed
+    std::vector<std::string> params = {portfolio, usageId};
+    if (!projection.toString().empty()) {
+        params.insert(params.end(), {"", "", projection.toString()});
+    }
+
+    std::vector<std::string> frames = m_clientAccessor->sendCommand(SecurityWalletServer::GET_LIST_WITH_SECRET, params);
+
+    // the first frame should contain the data
     if (frames.size() < 1) {
         throw SecwProtocolErrorException("Empty answer from server");
     }
 
     cxxtools::SerializationInfo si = deserialize(frames.at(0));
 
-    si >>= usages;
+    std::vector<DocumentPtr> documents;
+
+    si >>= documents;
 
-    return usages;
+    return documents;
 }
 
 std::vector<DocumentPtr> ConsumerAccessor::getListDocumentsWithPrivateData(
-    const std::string& portfolio, const UsageId& usageId) const
+    const std::string& portfolio, const UsageId& usageId, size_t pageSize, const Projection& projection) const
 {
-    std::vector<std::string> frames =
-        m_clientAccessor->sendCommand(SecurityWalletServer::GET_LIST_WITH_SECRET, {portfolio, usageId});
+    std::vector<DocumentPtr> documents;
+    std::string              cursor;
+
+    do {
+        std::vector<DocumentPtr> page =
+            getPageDocumentsWithPrivateData(portfolio, usageId, pageSize, cursor, projection);
+        documents.insert(documents.end(), page.begin(), page.end());
+    } while (!cursor.empty());
+
+    return documents;
+}
+
+std::vector<DocumentPtr> ConsumerAccessor::getPageDocumentsWithPrivateData(const std::string& portfolio,
+    const UsageId& usageId, size_t limit, std::string& cursor, const Projection& projection) const
+{
+    std::vector<std::string> frames = m_clientAccessor->sendCommand(SecurityWalletServer::GET_LIST_WITH_SECRET,
+        {portfolio, usageId, std::to_string(limit), cursor, projection.toString()});
 
     // the first frame should contain the data
     if (frames.size() < 1) {
@@ -97,12 +232,21 @@ std::vector<DocumentPtr> ConsumerAccessor::getListDocumentsWithPrivateData(
 
     si >>= documents;
 
+    // the second frame is the cursor of the next page, absent if all the documents are returned
+    cursor = (frames.size() >= 2) ? frames.at(1) : "";
+
     return documents;
 }
 
 std::vector<DocumentPtr> ConsumerAccessor::getListDocumentsWithPrivateData(
     const std::string& portfolio, const std::vector<Id>& ids) const
 {
+    try {
+        return getDocumentsWithPrivateData(portfolio, ids).documents;
+    } catch (const SecwUnsupportedCommandException&) {
+        // former server => one request by id
+    }
+
     std::vector<DocumentPtr> docs;
 
     for (const Id& id : ids) {
@@ -119,10 +263,44 @@ std::vector<DocumentPtr> ConsumerAccessor::getListDocumentsWithPrivateData(
     return docs;
 }
 
-DocumentPtr ConsumerAccessor::getDocumentWithPrivateData(const std::string& portfolio, const Id& id) const
+DocumentsByIds ConsumerAccessor::getDocumentsWithPrivateData(
+    const std::string& portfolio, const std::vector<Id>& ids, const Projection& projection) const
 {
+    std::vector<std::string> params = {portfolio, projection.toString()};
+    params.insert(params.end(), ids.begin(), ids.end());
+
     std::vector<std::string> frames =
-        m_clientAccessor->sendCommand(SecurityWalletServer::GET_WITH_SECRET, {portfolio, id});
+        m_clientAccessor->sendCommand(SecurityWalletServer::GET_WITH_SECRET_BY_IDS, params);
+
+    // the first frame should contain the data
+    if (frames.size() < 1) {
+        throw SecwProtocolErrorException("Empty answer from server");
+    }
+
+    cxxtools::SerializationInfo si = deserialize(frames.at(0));
+
+    DocumentsByIds documents;
+
+    si >>= documents;
+
+    return documents;
+}
+
+DocumentPtr ConsumerAccessor::getDocumentWithPrivateData(const std::string& portfolio, const Id& id) const
+{
+    return getDocumentWithPrivateData(portfolio, id, Projection());
+}
+
+DocumentPtr ConsumerAccessor::getDocumentWithPrivateData(
+    const std::string& portfolio, const Id& id, const Projection& projection) const
+{
+    // the former servers do not know the projection: it is sent only when needed
+    std::vector<std::string> params = {portfolio, id};
+    if (!projection.toString().empty()) {
+        params.push_back(projection.toString());
+    }
+
+    std::vector<std::string> frames = m_clientAccessor->sendCommand(SecurityWalletServer::GET_WITH_SECRET, params);
 
     // the first frame should contain the data
     if (frames.size() < 1) {
@@ -138,6 +316,19 @@ DocumentPtr ConsumerAccessor::getDocumentWithPrivateData(const std::string& port
     return document;
 }
 
+DocumentPtr ConsumerAccessor::getDocumentWithPrivateData(
+    const std::string& portfolio, const Id& id, const DocumentPtr& cachedDocument) const
+{
+    if (!isComparable(cachedDocument) || (cachedDocument->getId() != id)) {
+        return getDocumentWithPrivateData(portfolio, id);
+    }
+
+    std::vector<std::string> frames = m_clientAccessor->sendCommand(
+        SecurityWalletServer::GET_WITH_SECRET, {portfolio, id, "", std::to_string(cachedDocument->getVersion())});
+
+    return getDocumentFromReply(frames, cachedDocument);
+}
+
 DocumentPtr ConsumerAccessor::getDocumentWithPrivateDataByName(
     const std::string& portfolio, const std::string& name) const
 {
@@ -158,6 +349,25 @@ DocumentPtr ConsumerAccessor::getDocumentWithPrivateDataByName(
     return document;
 }
 
+DocumentPtr ConsumerAccessor::getDocumentWithPrivateDataByName(
+    const std::string& portfolio, const std::string& name, const DocumentPtr& cachedDocument) const
+{
+    if (!isComparable(cachedDocument) || (cachedDocument->getName() != name)) {
+        return getDocumentWithPrivateDataByName(portfolio, name);
+    }
+
+    // the id tells if the name was given to another document
+    std::vector<std::string> frames = m_clientAccessor->sendCommand(SecurityWalletServer::GET_WITH_SECRET_BY_NAME,
+        {portfolio, name, "", std::to_string(cachedDocument->getVersion()), cachedDocument->getId()});
+
+    return getDocumentFromReply(frames, cachedDocument);
+}
+
+void ConsumerAccessor::sendBatch(ConsumerBatch& batch) const
+{
+    batch.m_replies = m_clientAccessor->sendBatch(batch.m_requests);
+}
+
 void ConsumerAccessor::setCallbackOnUpdate(UpdatedCallback updatedCallback)
 {
     m_clientAccessor->setCallbackOnUpdate(updatedCallback);
@@ -32,7 +32,9 @@
 #include "secw_internal_certificate.h"
 #include "secw_snmpv1.h"
 #include "secw_snmpv3.h"
+#include "secw_string_pool.h"
 #include "secw_user_and_password.h"
+#include <algorithm>
 #include <cxxtools/jsondeserializer.h>
 #include <cxxtools/jsonserializer.h>
 
@@ -52,6 +54,140 @@ std::map<DocumentType, FctDocumentFactory> Document::m_documentFactoryFuntions =
 };
 // clang-format on
 
+// position of the value in values sorted by text
+static std::vector<InternedString>::iterator findSorted(std::vector<InternedString>& values, const std::string& value)
+{
+    return std::lower_bound(values.begin(), values.end(), value, [](const InternedString& item, const Tag& text) {
+        return *item < text;
+    });
+}
+
+static void insertSorted(std::vector<InternedString>& values, const std::string& value)
+{
+    auto it = findSorted(values, value);
+    if ((it == values.end()) || (**it != value)) {
+        values.insert(it, StringPool::intern(value));
+    }
+}
+
+static void eraseSorted(std::vector<InternedString>& values, const std::string& value)
+{
+    auto it = findSorted(values, value);
+    if ((it != values.end()) && (**it == value)) {
+        values.erase(it);
+    }
+}
+
+static std::set<std::string> toSet(const std::vector<InternedString>& values)
+{
+    std::set<std::string> set;
+    for (const InternedString& value : values) {
+        set.emplace_hint(set.end(), *value);
+    }
+
+    return set;
+}
+
+// same serialization as a std::set, without building it
+static void serializeSorted(cxxtools::SerializationInfo& si, const std::vector<InternedString>& values)
+{
+    si.setTypeName("set");
+
+    for (const InternedString& value : values) {
+        si.addMember("") <<= *value;
+    }
+
+    si.setCategory(cxxtools::SerializationInfo::Array);
+}
+
+// parts of a projection, in the order of the serialization
+// clang-format off
+static const std::vector<std::pair<std::string, bool Projection::*>> PROJECTION_PARTS =
+{
+    { "name", &Projection::name },
+    { "tags", &Projection::tags },
+    { "usages", &Projection::usages },
+    { "public", &Projection::publicPart },
+    { "private", &Projection::privatePart }
+};
+// clang-format on
+
+/*-----------------------------------------------------------------------------*/
+/*   Projection                                                                */
+/*-----------------------------------------------------------------------------*/
+Projection Projection::header()
+{
+    Projection projection;
+    projection.publicPart  = false;
+    projection.privatePart = false;
+
+    return projection;
+}
+
+Projection Projection::fromString(const std::string& text)
+{
+    if (text.empty()) {
+        return Projection();
+    }
+
+    Projection projection;
+    for (const auto& part : PROJECTION_PARTS) {
+        projection.*(part.second) = false;
+    }
+
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find(',', begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+
+        const std::string name = text.substr(begin, end - begin);
+
+        auto it = std::find_if(PROJECTION_PARTS.begin(), PROJECTION_PARTS.end(), [&name](const auto& part) {
+            return part.first == name;
+        });
+
+        if (name == "header") {
+            projection.name   = true;
+            projection.tags   = true;
+            projection.usages = true;
+        } else if (it != PROJECTION_PARTS.end()) {
+            projection.*(it->second) = true;
+        } else {
+            throw SecwBadCommandArgumentException("Bad projection part <" + name + ">");
+        }
+
+        begin = end + 1;
+    }
+
+    return projection;
+}
+
+std::string Projection::toString() const
+{
+    std::string text;
+    bool        isFull = true;
+
+    for (const auto& part : PROJECTION_PARTS) {
+        if (this->*(part.second)) {
+            text += (text.empty() ? "" : ",") + part.first;
+        } else {
+            isFull = false;
+        }
+    }
+
+    return isFull ? "" : text;
+}
+
+bool Projection::isPartial() const
+{
+    return !name || !tags || !usages || !publicPart;
+}
+
+/*-----------------------------------------------------------------------------*/
+/*   Document                                                                  */
+/*-----------------------------------------------------------------------------*/
 // Public
 const std::string& Document::getName() const
 {
@@ -65,34 +201,40 @@ void Document::setName(const std::string& name)
 
 void Document::addTag(const Tag& tag)
 {
-    m_tags.insert(tag);
+    insertSorted(m_tags, tag);
 }
 
 void Document::removeTag(const Tag& tag)
 {
-    if (m_tags.count(tag) > 0) {
-        m_tags.erase(tag);
-    }
+    eraseSorted(m_tags, tag);
 }
 
 std::set<Tag> Document::getTags() const
 {
-    return m_tags;
+    return toSet(m_tags);
 }
 
 void Document::addUsage(const UsageId& id)
 {
-    m_usages.insert(id);
+    insertSorted(m_usages, id);
 }
 
 void Document::removeUsage(const UsageId& id)
 {
-    if (m_usages.count(id) > 0) {
-        m_usages.erase(id);
-    }
+    eraseSorted(m_usages, id);
 }
 
 std::set<UsageId> Document::getUsageIds() const
+{
+    return toSet(m_usages);
+}
+
+const std::vector<InternedString>& Document::getInternedTags() const
+{
+    return m_tags;
+}
+
+const std::vector<InternedString>& Document::getInternedUsageIds() const
 {
     return m_usages;
 }
@@ -102,16 +244,31 @@ const DocumentType& Document::getType() const
     return m_type;
 }
 
-const Id& Document::getId() const
+Id Document::getId() const
+{
+    return m_id.toString();
+}
+
+const DocumentId& Document::getDocumentId() const
 {
     return m_id;
 }
 
+uint64_t Document::getVersion() const
+{
+    return m_version;
+}
+
 bool Document::isContainingPrivateData() const
 {
     return m_containPrivateData;
 }
 
+bool Document::isPartial() const
+{
+    return m_partial;
+}
+
 bool Document::isSupportedType(const DocumentType& type)
 {
     return (m_documentFactoryFuntions.count(type) > 0);
@@ -141,6 +298,19 @@ void Document::fillSerializationInfoWithSecret(cxxtools::SerializationInfo& si)
     fillSerializationInfoPrivateDoc(si.addMember(DOC_PRIVATE_ENTRY));
 }
 
+void Document::fillSerializationInfo(cxxtools::SerializationInfo& si, const Projection& projection) const
+{
+    fillSerializationInfoHeaderDoc(si, projection);
+
+    if (projection.publicPart) {
+        fillSerializationInfoPublicDoc(si.addMember(DOC_PUBLIC_ENTRY));
+    }
+
+    if (projection.privatePart) {
+        fillSerializationInfoPrivateDoc(si.addMember(DOC_PRIVATE_ENTRY));
+    }
+}
+
 void Document::fillSerializationInfoSRR(cxxtools::SerializationInfo& si, const std::string& encryptionKey) const
 {
     fillSerializationInfoHeaderDoc(si);
@@ -171,7 +341,7 @@ DocumentPtr Document::createFromSRR(const cxxtools::SerializationInfo& si, const
         const cxxtools::SerializationInfo& privateSection = si.getMember(DOC_PRIVATE_ENTRY);
 
         doc       = Document::m_documentFactoryFuntions.at(type)();
-        doc->m_id = id;
+        doc->m_id = DocumentId(id);
 
         // log_debug("Create document '%s' matching with '%s'", doc->getType().c_str(), type.c_str());
 
@@ -207,7 +377,7 @@ DocumentPtr Document::createFromSRR(const cxxtools::SerializationInfo& si, const
     return doc;
 }
 
-bool Document::isNonSecretEquals(const DocumentPtr& other) const
+bool Document::isNonSecretEquals(const ConstDocumentPtr& other) const
 {
     std::string doc1, doc2;
 
@@ -244,7 +414,7 @@ bool Document::isNonSecretEquals(const DocumentPtr& other) const
     return (doc1 == doc2);
 }
 
-bool Document::isSecretEquals(const DocumentPtr& other) const
+bool Document::isSecretEquals(const ConstDocumentPtr& other) const
 {
     if (m_type != other->getType())
         return false;
@@ -287,33 +457,73 @@ bool Document::isSecretEquals(const DocumentPtr& other) const
 }
 
 // Private
-void Document::fillSerializationInfoHeaderDoc(cxxtools::SerializationInfo& si) const
+void Document::fillSerializationInfoHeaderDoc(cxxtools::SerializationInfo& si, const Projection& projection) const
 {
     si.addMember(DOC_ID_ENTRY) <<= getId();
-    si.addMember(DOC_NAME_ENTRY) <<= getName();
+
+    if (projection.name) {
+        si.addMember(DOC_NAME_ENTRY) <<= getName();
+    }
+
     si.addMember(DOC_TYPE_ENTRY) <<= getType();
-    si.addMember(DOC_TAGS_ENTRY) <<= getTags();
-    si.addMember(DOC_USAGES_ENTRY) <<= getUsageIds();
+
+    // the documents never stored keep their former serialization
+    if (m_version != 0) {
+        si.addMember(DOC_VERSION_ENTRY) <<= m_version;
+    }
+
+    if (projection.tags) {
+        serializeSorted(si.addMember(DOC_TAGS_ENTRY), m_tags);
+    }
+
+    if (projection.usages) {
+        serializeSorted(si.addMember(DOC_USAGES_ENTRY), m_usages);
+    }
+
+    // a partial document stays partial: the server rejects it
+    if (m_partial || projection.isPartial()) {
+        si.addMember(DOC_PARTIAL_ENTRY) <<= true;
+    }
 }
 
-void Document::updateHeaderFromSerializationInfo(const cxxtools::SerializationInfo& si)
+void Document::updateHeaderFromSerializationInfo(const cxxtools::SerializationInfo& si, bool partial)
 {
     try {
         // We don't read the id because will portfolio insertion process is gonna do it
         // We don't read the type because it is define by the object type
-        si.getMember(DOC_NAME_ENTRY) >>= m_name;
+        if (!partial || si.findMember(DOC_NAME_ENTRY)) {
+            si.getMember(DOC_NAME_ENTRY) >>= m_name;
+        }
     } catch (const std::exception& e) {
         throw SecwInvalidDocumentFormatException(DOC_NAME_ENTRY);
     }
 
     try {
-        si.getMember(DOC_TAGS_ENTRY) >>= m_tags;
+        // optional: the former versions of the wallet do not give it
+        const cxxtools::SerializationInfo* versionEntry = si.findMember(DOC_VERSION_ENTRY);
+        if (versionEntry != nullptr) {
+            *versionEntry >>= m_version;
+        }
+    } catch (const std::exception& e) {
+        throw SecwInvalidDocumentFormatException(DOC_VERSION_ENTRY);
+    }
+
+    try {
+        if (!partial || si.findMember(DOC_TAGS_ENTRY)) {
+            std::set<Tag> tags;
+            si.getMember(DOC_TAGS_ENTRY) >>= tags;
+            m_tags = StringPool::intern(tags);
+        }
     } catch (const std::exception& e) {
         throw SecwInvalidDocumentFormatException(DOC_TAGS_ENTRY);
     }
 
     try {
-        si.getMember(DOC_USAGES_ENTRY) >>= m_usages;
+        if (!partial || si.findMember(DOC_USAGES_ENTRY)) {
+            std::set<UsageId> usages;
+            si.getMember(DOC_USAGES_ENTRY) >>= usages;
+            m_usages = StringPool::intern(usages);
+        }
     } catch (const std::exception& e) {
         throw SecwInvalidDocumentFormatException(DOC_USAGES_ENTRY);
     }
@@ -336,11 +546,19 @@ void operator>>=(const cxxtools::SerializationInfo& si, DocumentPtr& doc)
         DocumentType type = "";
 
         bool documentExist = (doc != nullptr);
+        bool partial       = false;
 
         si.getMember(DOC_TYPE_ENTRY) >>= type;
         si.getMember(DOC_ID_ENTRY) >>= id;
 
-        const cxxtools::SerializationInfo& publicEntry  = si.getMember(DOC_PUBLIC_ENTRY);
+        const cxxtools::SerializationInfo* partialEntry = si.findMember(DOC_PARTIAL_ENTRY);
+        if (partialEntry != nullptr) {
+            *partialEntry >>= partial;
+        }
+
+        // the public part is mandatory, except for a partial document
+        const cxxtools::SerializationInfo* publicEntry =
+            partial ? si.findMember(DOC_PUBLIC_ENTRY) : &si.getMember(DOC_PUBLIC_ENTRY);
         const cxxtools::SerializationInfo* privateEntry = si.findMember(DOC_PRIVATE_ENTRY);
 
         // if we override and existing document, check that we have the same type and same id
@@ -349,19 +567,26 @@ void operator>>=(const cxxtools::SerializationInfo& si, DocumentPtr& doc)
                 throw SecwInvalidDocumentFormatException(DOC_TYPE_ENTRY);
             }
 
-            if (doc->getId() != id) {
+            if (doc->m_id != DocumentId(id)) {
                 throw SecwInvalidDocumentFormatException(DOC_ID_ENTRY);
             }
         } else {
             // document do not exist, so create one
             doc       = Document::m_documentFactoryFuntions.at(type)();
-            doc->m_id = id;
+            doc->m_id = DocumentId(id);
         }
 
         // log_debug("Create document '%s' matching with '%s'", doc->getType().c_str(), type.c_str());
 
-        doc->updateHeaderFromSerializationInfo(si);
-        doc->updatePublicDocFromSerializationInfo(publicEntry);
+        doc->updateHeaderFromSerializationInfo(si, partial);
+
+        if (publicEntry != nullptr) {
+            doc->updatePublicDocFromSerializationInfo(*publicEntry);
+        }
+
+        if (!documentExist) {
+            doc->m_partial = partial;
+        }
 
         if (privateEntry != nullptr) {
             doc->updatePrivateDocFromSerializationInfo(*privateEntry);
@@ -439,6 +664,55 @@ void operator<<=(std::string& str, const std::vector<DocumentPtr>& docs)
     }
 }
 
+void operator<<=(cxxtools::SerializationInfo& si, const DocumentChanges& changes)
+{
+    si.addMember("generation") <<= changes.generation;
+    si.addMember("full_resync") <<= changes.fullResync;
+    si.addMember("created") <<= changes.created;
+    si.addMember("updated") <<= changes.updated;
+    si.addMember("deleted") <<= changes.deleted;
+}
+
+void operator>>=(const cxxtools::SerializationInfo& si, DocumentChanges& changes)
+{
+    si.getMember("generation") >>= changes.generation;
+    si.getMember("full_resync") >>= changes.fullResync;
+    si.getMember("created") >>= changes.created;
+    si.getMember("updated") >>= changes.updated;
+    si.getMember("deleted") >>= changes.deleted;
+}
+
+void operator<<=(cxxtools::SerializationInfo& si, const std::vector<DocumentStatus>& statuses)
+{
+    for (DocumentStatus status : statuses) {
+        si.addMember("") <<= unsigned(status);
+    }
+
+    si.setCategory(cxxtools::SerializationInfo::Array);
+}
+
+void operator>>=(const cxxtools::SerializationInfo& si, std::vector<DocumentStatus>& statuses)
+{
+    statuses.clear();
+
+    for (const cxxtools::SerializationInfo& member : si) {
+        unsigned status;
+        member >>= status;
+
+        if (status > unsigned(DocumentStatus::ILLEGAL_ACCESS)) {
+            throw SecwProtocolErrorException("Unknown document status " + std::to_string(status));
+        }
+
+        statuses.push_back(DocumentStatus(status));
+    }
+}
+
+void operator>>=(const cxxtools::SerializationInfo& si, DocumentsByIds& documents)
+{
+    si.getMember("documents") >>= documents.documents;
+    si.getMember("statuses") >>= documents.statuses;
+}
+
 /*std::ostream& operator<< (std::ostream& os, const DocumentPtr & doc)
 {
     os << *(doc);
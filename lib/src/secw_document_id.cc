@@ -0,0 +1,280 @@
+/*  =========================================================================
+    secw_document_id - Identifier of a document in 16 bytes
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_document_id - Identifier of a document in 16 bytes
+@discuss
+@end
+*/
+
+#include "secw_document_id.h"
+#include "secw_document_index.h"
+#include <atomic>
+#include <random>
+
+namespace secw {
+
+// xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+static constexpr const size_t UUID_TEXT_LENGTH = 36;
+
+static bool isDashPosition(size_t position)
+{
+    return (position == 8) || (position == 13) || (position == 18) || (position == 23);
+}
+
+// only the lowercase form is compact: the text is rebuilt identical
+static int hexValue(char c)
+{
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    }
+
+    if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+
+    return -1;
+}
+
+// text of an id which is not compact, shared by its copies
+struct DocumentId::Text
+{
+    std::atomic<size_t> references{1};
+    const std::string   value;
+
+    explicit Text(std::string_view text)
+        : value(text)
+    {
+    }
+};
+
+DocumentId::DocumentId(std::string_view text)
+{
+    if (text.empty() || parseCompact(text, *this)) {
+        return;
+    }
+
+    m_high = uint64_t(reinterpret_cast<uintptr_t>(new Text(text)));
+    m_low  = TEXT_TAG;
+}
+
+DocumentId::DocumentId(const DocumentId& other)
+    : m_high(other.m_high)
+    , m_low(other.m_low)
+{
+    if (isText()) {
+        text()->references++;
+    }
+}
+
+DocumentId::DocumentId(DocumentId&& other) noexcept
+    : m_high(other.m_high)
+    , m_low(other.m_low)
+{
+    other.m_high = 0;
+    other.m_low  = 0;
+}
+
+DocumentId& DocumentId::operator=(const DocumentId& other)
+{
+    if (other.isText()) {
+        other.text()->references++;
+    }
+
+    release();
+
+    m_high = other.m_high;
+    m_low  = other.m_low;
+
+    return *this;
+}
+
+DocumentId& DocumentId::operator=(DocumentId&& other) noexcept
+{
+    if (this != &other) {
+        release();
+
+        m_high       = other.m_high;
+        m_low        = other.m_low;
+        other.m_high = 0;
+        other.m_low  = 0;
+    }
+
+    return *this;
+}
+
+DocumentId::~DocumentId()
+{
+    release();
+}
+
+void DocumentId::release()
+{
+    if (isText() && (--text()->references == 0)) {
+        delete text();
+    }
+}
+
+DocumentId DocumentId::generate()
+{
+    // one generator per thread => no lock
+    thread_local std::mt19937_64 generator = []() {
+        std::random_device device;
+        std::seed_seq      seed{device(), device(), device(), device(), device(), device(), device(), device()};
+        return std::mt19937_64(seed);
+    }();
+
+    DocumentId id;
+    id.m_high = generator();
+    id.m_low  = generator();
+
+    // version 4 and variant 1 of RFC 4122
+    id.m_high = (id.m_high & ~uint64_t(0xF000)) | uint64_t(0x4000);
+    id.m_low  = (id.m_low & ~(uint64_t(3) << 62)) | (COMPACT_VARIANT << 62);
+
+    return id;
+}
+
+bool DocumentId::parseCompact(std::string_view text, DocumentId& id)
+{
+    if (text.size() != UUID_TEXT_LENGTH) {
+        return false;
+    }
+
+    uint64_t value[2] = {0, 0};
+    size_t   nbDigits = 0;
+
+    for (size_t position = 0; position < text.size(); position++) {
+        if (isDashPosition(position)) {
+            if (text[position] != '-') {
+                return false;
+            }
+            continue;
+        }
+
+        int digit = hexValue(text[position]);
+        if (digit < 0) {
+            return false;
+        }
+
+        value[nbDigits / 16] = (value[nbDigits / 16] << 4) | uint64_t(digit);
+        nbDigits++;
+    }
+
+    // the other variants would be taken for the empty id or for a text
+    if ((value[1] >> 62) != COMPACT_VARIANT) {
+        return false;
+    }
+
+    id = DocumentId();
+
+    id.m_high = value[0];
+    id.m_low  = value[1];
+
+    return true;
+}
+
+uint64_t DocumentId::hashText(std::string_view text)
+{
+    return DocumentIndex::hash(text);
+}
+
+void DocumentId::format(char* text) const
+{
+    static const char* DIGITS = "0123456789abcdef";
+
+    size_t nbDigits = 0;
+
+    for (size_t position = 0; position < UUID_TEXT_LENGTH; position++) {
+        if (isDashPosition(position)) {
+            text[position] = '-';
+            continue;
+        }
+
+        uint64_t value = (nbDigits < 16) ? m_high : m_low;
+        text[position] = DIGITS[(value >> (60 - 4 * (nbDigits % 16))) & 0xF];
+        nbDigits++;
+    }
+}
+
+std::string DocumentId::toString() const
+{
+    if (!isCompact()) {
+        return std::string(getText());
+    }
+
+    std::string text(UUID_TEXT_LENGTH, '-');
+    format(&text[0]);
+
+    return text;
+}
+
+std::string_view DocumentId::getText() const
+{
+    return isText() ? std::string_view(text()->value) : std::string_view();
+}
+
+uint64_t DocumentId::hash() const
+{
+    if (!isCompact()) {
+        return hashText(getText());
+    }
+
+    // final mix (murmur3) of both halves: the ids are not always random
+    uint64_t value = m_high ^ ((m_low << 32) | (m_low >> 32));
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+
+    return value;
+}
+
+bool DocumentId::operator<(const DocumentId& other) const
+{
+    // the lowercase hexadecimal text of a UUID has the order of its value
+    if (isCompact() && other.isCompact()) {
+        return (m_high < other.m_high) || ((m_high == other.m_high) && (m_low < other.m_low));
+    }
+
+    // the text of a compact id is formatted on the stack
+    char buffer[UUID_TEXT_LENGTH];
+    char otherBuffer[UUID_TEXT_LENGTH];
+
+    std::string_view text      = getText();
+    std::string_view otherText = other.getText();
+
+    if (isCompact()) {
+        format(buffer);
+        text = std::string_view(buffer, UUID_TEXT_LENGTH);
+    }
+
+    if (other.isCompact()) {
+        other.format(otherBuffer);
+        otherText = std::string_view(otherBuffer, UUID_TEXT_LENGTH);
+    }
+
+    return text < otherText;
+}
+
+} // namespace secw
@@ -0,0 +1,444 @@
+/*  =========================================================================
+    secw_document_index - Hash index of the documents of a portfolio
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_document_index - Hash index of the documents of a portfolio
+@discuss
+@end
+*/
+
+#include "secw_document_index.h"
+#include "secw_portfolio.h"
+#include <algorithm>
+#include <atomic>
+
+namespace secw {
+
+// smallest array allocated: one chunk
+static constexpr const size_t MIN_CAPACITY = 32;
+
+// each copy of an index takes new owners: the nodes created before are then shared
+static uint64_t newOwner()
+{
+    static std::atomic<uint64_t> nextOwner(1);
+    return nextOwner.fetch_add(1, std::memory_order_relaxed);
+}
+
+DocumentIndex::DocumentIndex(Key key)
+    : m_key(key)
+    , m_owner(newOwner())
+{
+}
+
+DocumentIndex::DocumentIndex(const DocumentIndex& other)
+    : m_key(other.m_key)
+    , m_size(other.m_size)
+    , m_capacity(other.m_capacity)
+    , m_depth(other.m_depth)
+    , m_root(other.m_root)
+    , m_owner(newOwner())
+{
+    other.m_owner = newOwner();
+}
+
+DocumentIndex::DocumentIndex(DocumentIndex&& other) noexcept
+    : m_key(other.m_key)
+    , m_size(other.m_size)
+    , m_capacity(other.m_capacity)
+    , m_depth(other.m_depth)
+    , m_root(std::move(other.m_root))
+    , m_owner(other.m_owner.load())
+{
+    other.clear();
+    other.m_owner = newOwner();
+}
+
+DocumentIndex& DocumentIndex::operator=(const DocumentIndex& other)
+{
+    if (this != &other) {
+        m_key      = other.m_key;
+        m_size     = other.m_size;
+        m_capacity = other.m_capacity;
+        m_depth    = other.m_depth;
+        m_root     = other.m_root;
+        m_owner    = newOwner();
+
+        other.m_owner = newOwner();
+    }
+
+    return *this;
+}
+
+DocumentIndex& DocumentIndex::operator=(DocumentIndex&& other) noexcept
+{
+    if (this != &other) {
+        m_key      = other.m_key;
+        m_size     = other.m_size;
+        m_capacity = other.m_capacity;
+        m_depth    = other.m_depth;
+        m_root     = std::move(other.m_root);
+        m_owner    = other.m_owner.load();
+
+        other.clear();
+        other.m_owner = newOwner();
+    }
+
+    return *this;
+}
+
+const DocumentEntryPtr* DocumentIndex::find(std::string_view key) const
+{
+    if (m_size == 0) {
+        return nullptr;
+    }
+
+    const Slot& slot = getSlot(findSlot(key));
+    return slot.entry ? &slot.entry : nullptr;
+}
+
+const DocumentEntryPtr* DocumentIndex::find(const DocumentId& id) const
+{
+    if (m_key == Key::NAME) {
+        return find(std::string_view(id.toString()));
+    }
+
+    if (m_size == 0) {
+        return nullptr;
+    }
+
+    const Slot& slot = getSlot(findSlot(id));
+    return slot.entry ? &slot.entry : nullptr;
+}
+
+void DocumentIndex::insert(const DocumentEntryPtr& entry)
+{
+    // at most 3/4 of the slots are used => the sequences of used slots stay short
+    if ((m_size + 1) * 4 > m_capacity * 3) {
+        rehash(std::max(MIN_CAPACITY, m_capacity * 2));
+    }
+
+    uint64_t keyHash = hashOf(*entry);
+    size_t   index   = findSlot(keyHash, [&](const DocumentEntry& other) {
+        return sameKey(*entry, other);
+    });
+
+    Slot& slot = getMutableSlot(index);
+
+    if (!slot.entry) {
+        m_size++;
+    }
+
+    slot.hash  = keyHash;
+    slot.entry = entry;
+}
+
+bool DocumentIndex::erase(std::string_view key)
+{
+    if (m_size == 0) {
+        return false;
+    }
+
+    size_t hole = findSlot(key);
+    if (!getSlot(hole).entry) {
+        return false;
+    }
+
+    eraseSlot(hole);
+    return true;
+}
+
+bool DocumentIndex::erase(const DocumentId& id)
+{
+    if (m_key == Key::NAME) {
+        return erase(std::string_view(id.toString()));
+    }
+
+    if (m_size == 0) {
+        return false;
+    }
+
+    size_t hole = findSlot(id);
+    if (!getSlot(hole).entry) {
+        return false;
+    }
+
+    eraseSlot(hole);
+    return true;
+}
+
+void DocumentIndex::eraseSlot(size_t hole)
+{
+    size_t mask = m_capacity - 1;
+
+    // backward shift: the following entries of the sequence are moved back, no tombstone needed
+    for (size_t next = (hole + 1) & mask; getSlot(next).entry; next = (next + 1) & mask) {
+        size_t ideal = getSlot(next).hash & mask;
+
+        // the entry can be moved to the hole if the hole is between its ideal slot and its slot
+        if (((next - ideal) & mask) >= ((next - hole) & mask)) {
+            Slot& target = getMutableSlot(hole);
+            target       = std::move(getMutableSlot(next));
+            hole         = next;
+        }
+    }
+
+    getMutableSlot(hole) = Slot();
+    m_size--;
+}
+
+void DocumentIndex::clear()
+{
+    m_root.reset();
+    m_size     = 0;
+    m_capacity = 0;
+    m_depth    = 0;
+}
+
+void DocumentIndex::reserve(size_t nbEntries)
+{
+    size_t capacity = MIN_CAPACITY;
+    while (nbEntries * 4 > capacity * 3) {
+        capacity *= 2;
+    }
+
+    if (capacity > m_capacity) {
+        rehash(capacity);
+    }
+}
+
+DocumentIndex::const_iterator::const_iterator(const DocumentIndex& index, size_t slot)
+    : m_index(&index)
+    , m_slot(slot)
+{
+    skipEmptySlots();
+}
+
+DocumentIndex::const_iterator& DocumentIndex::const_iterator::operator++()
+{
+    m_slot++;
+    skipEmptySlots();
+
+    return *this;
+}
+
+void DocumentIndex::const_iterator::skipEmptySlots()
+{
+    for (; m_slot < m_index->m_capacity; m_slot++) {
+        if (!m_leaf || (m_slot % CHUNK_SIZE == 0)) {
+            m_leaf = &m_index->getLeaf(m_slot);
+        }
+
+        if (m_leaf->slots[m_slot % CHUNK_SIZE].entry) {
+            break;
+        }
+    }
+}
+
+DocumentIndex::const_iterator DocumentIndex::begin() const
+{
+    return const_iterator(*this, 0);
+}
+
+DocumentIndex::const_iterator DocumentIndex::end() const
+{
+    return const_iterator(*this, m_capacity);
+}
+
+uint64_t DocumentIndex::hash(std::string_view key)
+{
+    // FNV-1a
+    uint64_t value = 14695981039346656037ULL;
+    for (char c : key) {
+        value ^= static_cast<unsigned char>(c);
+        value *= 1099511628211ULL;
+    }
+
+    // final mix (murmur3): the low bits used for the slot depend on all the bits
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+
+    return value;
+}
+
+uint64_t DocumentIndex::hashOf(const DocumentEntry& entry) const
+{
+    return (m_key == Key::ID) ? entry.getId().hash() : hash(entry.getName());
+}
+
+bool DocumentIndex::sameKey(const DocumentEntry& entry, const DocumentEntry& other) const
+{
+    return (m_key == Key::ID) ? (entry.getId() == other.getId()) : (entry.getName() == other.getName());
+}
+
+template <typename Match>
+size_t DocumentIndex::findSlot(uint64_t keyHash, const Match& match) const
+{
+    size_t      mask  = m_capacity - 1;
+    size_t      index = keyHash & mask;
+    const Node* leaf  = &getLeaf(index);
+
+    for (;;) {
+        const Slot& slot = leaf->slots[index % CHUNK_SIZE];
+
+        if (!slot.entry || ((slot.hash == keyHash) && match(*slot.entry))) {
+            return index;
+        }
+
+        index = (index + 1) & mask;
+        if (index % CHUNK_SIZE == 0) {
+            leaf = &getLeaf(index);
+        }
+    }
+}
+
+size_t DocumentIndex::findSlot(std::string_view key) const
+{
+    if (m_key == Key::NAME) {
+        return findSlot(hash(key), [&](const DocumentEntry& entry) {
+            return entry.getName() == key;
+        });
+    }
+
+    DocumentId compact;
+    if (DocumentId::parseCompact(key, compact)) {
+        return findSlot(compact);
+    }
+
+    // an id kept as text is compared without building it
+    return findSlot(DocumentId::hashText(key), [&](const DocumentEntry& entry) {
+        return !entry.getId().isCompact() && (entry.getId().getText() == key);
+    });
+}
+
+size_t DocumentIndex::findSlot(const DocumentId& id) const
+{
+    return findSlot(id.hash(), [&](const DocumentEntry& entry) {
+        return entry.getId() == id;
+    });
+}
+
+const DocumentIndex::Node& DocumentIndex::getLeaf(size_t slot) const
+{
+    size_t      leaf = slot / CHUNK_SIZE;
+    const Node* node = m_root.get();
+
+    for (unsigned level = m_depth; level > 0; level--) {
+        node = node->children[(leaf >> (BRANCH_BITS * (level - 1))) & (BRANCHING - 1)].get();
+    }
+
+    return *node;
+}
+
+const DocumentIndex::Slot& DocumentIndex::getSlot(size_t slot) const
+{
+    return getLeaf(slot).slots[slot % CHUNK_SIZE];
+}
+
+DocumentIndex::Node& DocumentIndex::getMutableLeaf(size_t slot)
+{
+    uint64_t owner = m_owner.load(std::memory_order_relaxed);
+    size_t   leaf  = slot / CHUNK_SIZE;
+    NodePtr* node  = &m_root;
+
+    for (unsigned level = m_depth;; level--) {
+        // shared with a copy of the index
+        if ((*node)->owner != owner) {
+            NodePtr copy = std::make_shared<Node>(**node);
+            copy->owner  = owner;
+            *node        = std::move(copy);
+        }
+
+        if (level == 0) {
+            return **node;
+        }
+
+        node = &(*node)->children[(leaf >> (BRANCH_BITS * (level - 1))) & (BRANCHING - 1)];
+    }
+}
+
+DocumentIndex::Slot& DocumentIndex::getMutableSlot(size_t slot)
+{
+    return getMutableLeaf(slot).slots[slot % CHUNK_SIZE];
+}
+
+void DocumentIndex::rehash(size_t capacity)
+{
+    uint64_t owner    = m_owner.load(std::memory_order_relaxed);
+    size_t   nbLeaves = capacity / CHUNK_SIZE;
+
+    unsigned depth = 0;
+    while ((size_t(1) << (BRANCH_BITS * depth)) < nbLeaves) {
+        depth++;
+    }
+
+    // empty trie of the new capacity, each level covering BRANCHING times more leaves
+    std::vector<NodePtr> level(nbLeaves);
+    for (NodePtr& leaf : level) {
+        leaf        = std::make_shared<Node>();
+        leaf->owner = owner;
+        leaf->slots.resize(CHUNK_SIZE);
+    }
+
+    while (level.size() > 1) {
+        std::vector<NodePtr> parents((level.size() + BRANCHING - 1) / BRANCHING);
+
+        for (size_t index = 0; index < parents.size(); index++) {
+            parents[index]        = std::make_shared<Node>();
+            parents[index]->owner = owner;
+            parents[index]->children.assign(level.begin() + index * BRANCHING,
+                level.begin() + std::min(level.size(), (index + 1) * BRANCHING));
+        }
+
+        level.swap(parents);
+    }
+
+    DocumentIndex rehashed(m_key);
+    rehashed.m_capacity = capacity;
+    rehashed.m_depth    = depth;
+    rehashed.m_root     = std::move(level.front());
+    rehashed.m_owner    = owner;
+
+    size_t mask = capacity - 1;
+
+    // the entries keep their hash: they are placed without reading their key
+    for (size_t first = 0; first < m_capacity; first += CHUNK_SIZE) {
+        for (const Slot& slot : getLeaf(first).slots) {
+            if (slot.entry) {
+                size_t target = slot.hash & mask;
+                while (rehashed.getSlot(target).entry) {
+                    target = (target + 1) & mask;
+                }
+
+                rehashed.getMutableSlot(target) = slot;
+            }
+        }
+    }
+
+    m_capacity = capacity;
+    m_depth    = depth;
+    m_root     = std::move(rehashed.m_root);
+}
+
+} // namespace secw
@@ -0,0 +1,185 @@
+/*  =========================================================================
+    secw_document_index - Hash index of the documents of a portfolio
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "secw_document_id.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace secw {
+
+class DocumentEntry;
+using DocumentEntryPtr = std::shared_ptr<const DocumentEntry>;
+
+/// @brief Hash index of document entries, by id or by name
+///
+/// Open addressing with linear probing: the entries are in one array of slots and a lookup
+/// reads consecutive slots. The key is read from the header of the entry: the lookups by
+/// name take a string_view and the lookups by id a DocumentId, no string is built to search
+/// a document.
+///
+/// The array is split in chunks of slots, the leaves of a trie. A copy of the index shares
+/// the trie and a modification copies only the chunk and the branches leading to it, so a
+/// snapshot is copied and modified in O(log n). The nodes created by an index since its
+/// last copy are modified in place.
+///
+/// The hash does not depend on the process: the same insertions give the same order.
+class DocumentIndex
+{
+    struct Slot
+    {
+        uint64_t         hash = 0;
+        DocumentEntryPtr entry; ///< nullptr for an empty slot
+    };
+
+    /// Node of the trie: a branch holds nodes, a leaf holds a chunk of slots
+    struct Node
+    {
+        uint64_t                           owner; ///< index allowed to modify the node in place
+        std::vector<std::shared_ptr<Node>> children;
+        std::vector<Slot>                  slots;
+    };
+
+    using NodePtr = std::shared_ptr<Node>;
+
+public:
+    enum class Key
+    {
+        ID,
+        NAME
+    };
+
+    explicit DocumentIndex(Key key);
+
+    /// Share the nodes of the other index: both copy a node before modifying it
+    DocumentIndex(const DocumentIndex& other);
+    DocumentIndex(DocumentIndex&& other) noexcept;
+
+    DocumentIndex& operator=(const DocumentIndex& other);
+    DocumentIndex& operator=(DocumentIndex&& other) noexcept;
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    /// nullptr if there is no entry with this key. The text of an id is not copied.
+    const DocumentEntryPtr* find(std::string_view key) const;
+    const DocumentEntryPtr* find(const DocumentId& id) const;
+
+    bool contains(std::string_view key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    bool contains(const DocumentId& id) const
+    {
+        return find(id) != nullptr;
+    }
+
+    /// Add the entry, or replace the entry having the same key
+    void insert(const DocumentEntryPtr& entry);
+
+    /// Return false if there is no entry with this key
+    bool erase(std::string_view key);
+    bool erase(const DocumentId& id);
+
+    void clear();
+    void reserve(size_t nbEntries);
+
+    /// @brief Iteration over the entries, in the order of the slots
+    class const_iterator
+    {
+    public:
+        const_iterator(const DocumentIndex& index, size_t slot);
+
+        const DocumentEntryPtr& operator*() const
+        {
+            return m_leaf->slots[m_slot % CHUNK_SIZE].entry;
+        }
+
+        const_iterator& operator++();
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return m_slot != other.m_slot;
+        }
+
+    private:
+        const DocumentIndex* m_index;
+        size_t               m_slot;
+        const Node*          m_leaf = nullptr;
+
+        void skipEmptySlots();
+    };
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    static uint64_t hash(std::string_view key);
+
+private:
+    static constexpr unsigned BRANCH_BITS = 5;
+    static constexpr size_t   BRANCHING   = size_t(1) << BRANCH_BITS;
+    static constexpr size_t   CHUNK_SIZE  = 32;
+
+    Key      m_key;
+    size_t   m_size     = 0;
+    size_t   m_capacity = 0; ///< number of slots: 0 or a power of 2
+    unsigned m_depth    = 0; ///< number of branches above the leaves
+    NodePtr  m_root;
+
+    // changed by a copy: the nodes shared with the copy are no longer modified in place
+    mutable std::atomic<uint64_t> m_owner;
+
+    uint64_t hashOf(const DocumentEntry& entry) const;
+    bool     sameKey(const DocumentEntry& entry, const DocumentEntry& other) const;
+
+    // slot of the key, or the empty slot where it would be inserted
+    template <typename Match>
+    size_t findSlot(uint64_t hash, const Match& match) const;
+
+    size_t findSlot(std::string_view key) const;
+    size_t findSlot(const DocumentId& id) const;
+
+    const Node& getLeaf(size_t slot) const;
+    const Slot& getSlot(size_t slot) const;
+
+    // copy the leaf of the slot and its branches if they are shared
+    Node& getMutableLeaf(size_t slot);
+    Slot& getMutableSlot(size_t slot);
+
+    // remove the entry of a used slot
+    void eraseSlot(size_t hole);
+
+    void rehash(size_t capacity);
+};
+
+} // namespace secw
@@ -0,0 +1,381 @@
+/*  =========================================================================
+    secw_document_order - Ordered index of the documents of a portfolio
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_document_order - Ordered index of the documents of a portfolio
+@discuss
+@end
+*/
+
+#include "secw_document_order.h"
+#include "secw_portfolio.h"
+#include <algorithm>
+
+namespace secw {
+
+// each copy of an index takes new owners: the nodes created before are then shared
+static uint64_t newOwner()
+{
+    static std::atomic<uint64_t> nextOwner(1);
+    return nextOwner.fetch_add(1, std::memory_order_relaxed);
+}
+
+static bool entryBefore(const DocumentEntryPtr& entry, const DocumentId& id)
+{
+    return entry->getId() < id;
+}
+
+static bool idBefore(const DocumentId& id, const DocumentEntryPtr& entry)
+{
+    return id < entry->getId();
+}
+
+DocumentOrder::DocumentOrder()
+    : m_owner(newOwner())
+{
+}
+
+DocumentOrder::DocumentOrder(const DocumentOrder& other)
+    : m_size(other.m_size)
+    , m_depth(other.m_depth)
+    , m_root(other.m_root)
+    , m_owner(newOwner())
+{
+    other.m_owner = newOwner();
+}
+
+DocumentOrder::DocumentOrder(DocumentOrder&& other) noexcept
+    : m_size(other.m_size)
+    , m_depth(other.m_depth)
+    , m_root(std::move(other.m_root))
+    , m_owner(other.m_owner.load())
+{
+    other.clear();
+    other.m_owner = newOwner();
+}
+
+DocumentOrder& DocumentOrder::operator=(const DocumentOrder& other)
+{
+    if (this != &other) {
+        m_size  = other.m_size;
+        m_depth = other.m_depth;
+        m_root  = other.m_root;
+        m_owner = newOwner();
+
+        other.m_owner = newOwner();
+    }
+
+    return *this;
+}
+
+DocumentOrder& DocumentOrder::operator=(DocumentOrder&& other) noexcept
+{
+    if (this != &other) {
+        m_size  = other.m_size;
+        m_depth = other.m_depth;
+        m_root  = std::move(other.m_root);
+        m_owner = other.m_owner.load();
+
+        other.clear();
+        other.m_owner = newOwner();
+    }
+
+    return *this;
+}
+
+void DocumentOrder::insert(const DocumentEntryPtr& entry)
+{
+    if (!m_root) {
+        m_root = createNode();
+    }
+
+    Split split = insert(m_root, m_depth, entry);
+
+    // the root was split: the tree grows by the top
+    if (split.node) {
+        NodePtr root = createNode();
+        root->keys.push_back(std::move(split.key));
+        root->children.push_back(std::move(m_root));
+        root->children.push_back(std::move(split.node));
+
+        m_root = std::move(root);
+        m_depth++;
+    }
+}
+
+bool DocumentOrder::erase(const DocumentId& id)
+{
+    // nothing is copied for an absent entry
+    if (!contains(id)) {
+        return false;
+    }
+
+    erase(m_root, m_depth, id);
+    m_size--;
+
+    if (m_size == 0) {
+        clear();
+        return true;
+    }
+
+    // the tree shrinks by the top
+    while ((m_depth > 0) && (m_root->children.size() == 1)) {
+        NodePtr child = m_root->children.front();
+        m_root        = std::move(child);
+        m_depth--;
+    }
+
+    return true;
+}
+
+void DocumentOrder::clear()
+{
+    m_root.reset();
+    m_size  = 0;
+    m_depth = 0;
+}
+
+DocumentOrder::const_iterator& DocumentOrder::const_iterator::operator++()
+{
+    m_path.back().second++;
+    skipEndOfLeaf();
+
+    return *this;
+}
+
+void DocumentOrder::const_iterator::descend()
+{
+    for (const Node* node = m_path.back().first; !node->children.empty(); node = m_path.back().first) {
+        m_path.emplace_back(node->children[m_path.back().second].get(), 0);
+    }
+}
+
+void DocumentOrder::const_iterator::skipEndOfLeaf()
+{
+    while (!m_path.empty() && (m_path.back().second >= m_path.back().first->entries.size())) {
+        m_path.pop_back();
+
+        // nearest branch having a next child
+        while (!m_path.empty() && (m_path.back().second + 1 >= m_path.back().first->children.size())) {
+            m_path.pop_back();
+        }
+
+        if (m_path.empty()) {
+            return;
+        }
+
+        m_path.back().second++;
+        descend();
+    }
+}
+
+DocumentOrder::const_iterator DocumentOrder::begin() const
+{
+    const_iterator it;
+
+    if (m_root) {
+        it.m_path.reserve(m_depth + 1);
+        it.m_path.emplace_back(m_root.get(), 0);
+        it.descend();
+        it.skipEndOfLeaf();
+    }
+
+    return it;
+}
+
+DocumentOrder::const_iterator DocumentOrder::end() const
+{
+    return const_iterator();
+}
+
+DocumentOrder::const_iterator DocumentOrder::upperBound(const DocumentId& id) const
+{
+    const_iterator it;
+
+    if (!m_root) {
+        return it;
+    }
+
+    it.m_path.reserve(m_depth + 1);
+
+    const Node* node = m_root.get();
+    for (unsigned level = m_depth; level > 0; level--) {
+        size_t index = size_t(std::upper_bound(node->keys.begin(), node->keys.end(), id) - node->keys.begin());
+        it.m_path.emplace_back(node, index);
+        node = node->children[index].get();
+    }
+
+    auto position = std::upper_bound(node->entries.begin(), node->entries.end(), id, idBefore);
+    it.m_path.emplace_back(node, size_t(position - node->entries.begin()));
+    it.skipEndOfLeaf();
+
+    return it;
+}
+
+DocumentOrder::NodePtr DocumentOrder::createNode() const
+{
+    NodePtr node = std::make_shared<Node>();
+    node->owner  = m_owner.load(std::memory_order_relaxed);
+
+    return node;
+}
+
+DocumentOrder::Node& DocumentOrder::getMutableNode(NodePtr& node)
+{
+    uint64_t owner = m_owner.load(std::memory_order_relaxed);
+
+    // shared with a copy of the index
+    if (node->owner != owner) {
+        NodePtr copy = std::make_shared<Node>(*node);
+        copy->owner  = owner;
+        node         = std::move(copy);
+    }
+
+    return *node;
+}
+
+DocumentOrder::Split DocumentOrder::insert(NodePtr& nodePtr, unsigned level, const DocumentEntryPtr& entry)
+{
+    Node&             node = getMutableNode(nodePtr);
+    const DocumentId& id   = entry->getId();
+
+    if (level == 0) {
+        auto position = std::lower_bound(node.entries.begin(), node.entries.end(), id, entryBefore);
+        if ((position != node.entries.end()) && ((*position)->getId() == id)) {
+            *position = entry;
+            return Split();
+        }
+
+        node.entries.insert(position, entry);
+        m_size++;
+
+        if (node.entries.size() <= NODE_SIZE) {
+            return Split();
+        }
+
+        Split split;
+        split.node = createNode();
+        split.node->entries.assign(node.entries.begin() + std::ptrdiff_t(NODE_SIZE / 2), node.entries.end());
+        split.key = split.node->entries.front()->getId();
+
+        node.entries.resize(NODE_SIZE / 2);
+        return split;
+    }
+
+    size_t index = size_t(std::upper_bound(node.keys.begin(), node.keys.end(), id) - node.keys.begin());
+
+    Split childSplit = insert(node.children[index], level - 1, entry);
+    if (!childSplit.node) {
+        return Split();
+    }
+
+    node.keys.insert(node.keys.begin() + std::ptrdiff_t(index), std::move(childSplit.key));
+    node.children.insert(node.children.begin() + std::ptrdiff_t(index + 1), std::move(childSplit.node));
+
+    if (node.children.size() <= NODE_SIZE) {
+        return Split();
+    }
+
+    // the middle key moves up: it separates the two halves
+    size_t half = node.children.size() / 2;
+
+    Split split;
+    split.node = createNode();
+    split.key  = node.keys[half - 1];
+    split.node->keys.assign(node.keys.begin() + std::ptrdiff_t(half), node.keys.end());
+    split.node->children.assign(node.children.begin() + std::ptrdiff_t(half), node.children.end());
+
+    node.keys.resize(half - 1);
+    node.children.resize(half);
+    return split;
+}
+
+void DocumentOrder::erase(NodePtr& nodePtr, unsigned level, const DocumentId& id)
+{
+    Node& node = getMutableNode(nodePtr);
+
+    if (level == 0) {
+        node.entries.erase(std::lower_bound(node.entries.begin(), node.entries.end(), id, entryBefore));
+        return;
+    }
+
+    size_t index = size_t(std::upper_bound(node.keys.begin(), node.keys.end(), id) - node.keys.begin());
+    erase(node.children[index], level - 1, id);
+
+    const Node& child = *node.children[index];
+
+    if (child.entries.empty() && child.children.empty()) {
+        // the key before the child, or after the first child
+        if (!node.keys.empty()) {
+            node.keys.erase(node.keys.begin() + std::ptrdiff_t((index > 0) ? index - 1 : 0));
+        }
+        node.children.erase(node.children.begin() + std::ptrdiff_t(index));
+    } else if (index > 0) {
+        mergeChildren(node, index - 1, level - 1);
+    } else if (index + 1 < node.children.size()) {
+        mergeChildren(node, index, level - 1);
+    }
+}
+
+void DocumentOrder::mergeChildren(Node& branch, size_t index, unsigned childLevel)
+{
+    // keep the right node alive: it may be shared
+    NodePtr     right = branch.children[index + 1];
+    const Node& left  = *branch.children[index];
+
+    size_t merged = (childLevel == 0) ? (left.entries.size() + right->entries.size())
+                                      : (left.children.size() + right->children.size());
+    if (merged > NODE_SIZE * 3 / 4) {
+        return;
+    }
+
+    Node& target = getMutableNode(branch.children[index]);
+
+    if (childLevel == 0) {
+        target.entries.insert(target.entries.end(), right->entries.begin(), right->entries.end());
+    } else {
+        target.keys.push_back(branch.keys[index]);
+        target.keys.insert(target.keys.end(), right->keys.begin(), right->keys.end());
+        target.children.insert(target.children.end(), right->children.begin(), right->children.end());
+    }
+
+    branch.keys.erase(branch.keys.begin() + std::ptrdiff_t(index));
+    branch.children.erase(branch.children.begin() + std::ptrdiff_t(index + 1));
+}
+
+bool DocumentOrder::contains(const DocumentId& id) const
+{
+    if (!m_root) {
+        return false;
+    }
+
+    const Node* node = m_root.get();
+    for (unsigned level = m_depth; level > 0; level--) {
+        size_t index = size_t(std::upper_bound(node->keys.begin(), node->keys.end(), id) - node->keys.begin());
+        node         = node->children[index].get();
+    }
+
+    auto position = std::lower_bound(node->entries.begin(), node->entries.end(), id, entryBefore);
+    return (position != node->entries.end()) && ((*position)->getId() == id);
+}
+
+} // namespace secw
@@ -0,0 +1,154 @@
+/*  =========================================================================
+    secw_document_order - Ordered index of the documents of a portfolio
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "secw_document_index.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace secw {
+
+/// @brief Document entries ordered by id
+///
+/// B+tree: the entries are in the leaves, a branch holds the first id of each of its
+/// children but the first one. A page of documents is a seek followed by the reading of
+/// consecutive entries, in O(log n + limit).
+///
+/// As for DocumentIndex, a copy shares the nodes and a modification copies only the nodes
+/// on the path of the entry, if they are shared. A node emptied by the removals is merged
+/// with a neighbour when both fit in three quarters of a node.
+class DocumentOrder
+{
+    struct Node
+    {
+        uint64_t                           owner;    ///< index allowed to modify the node in place
+        std::vector<DocumentEntryPtr>      entries;  ///< leaf
+        std::vector<DocumentId>            keys;     ///< branch: first id of each child but the first one
+        std::vector<std::shared_ptr<Node>> children; ///< branch
+    };
+
+    using NodePtr = std::shared_ptr<Node>;
+
+public:
+    DocumentOrder();
+
+    /// Share the nodes of the other index: both copy a node before modifying it
+    DocumentOrder(const DocumentOrder& other);
+    DocumentOrder(DocumentOrder&& other) noexcept;
+
+    DocumentOrder& operator=(const DocumentOrder& other);
+    DocumentOrder& operator=(DocumentOrder&& other) noexcept;
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    /// Add the entry, or replace the entry having the same id
+    void insert(const DocumentEntryPtr& entry);
+
+    /// Return false if there is no entry with this id
+    bool erase(const DocumentId& id);
+
+    void clear();
+
+    /// @brief Iteration over the entries, by increasing id
+    class const_iterator
+    {
+    public:
+        const DocumentEntryPtr& operator*() const
+        {
+            return m_path.back().first->entries[m_path.back().second];
+        }
+
+        const_iterator& operator++();
+
+        bool operator==(const const_iterator& other) const
+        {
+            return (m_path.empty() || other.m_path.empty()) ? (m_path.empty() == other.m_path.empty())
+                                                            : (m_path.back() == other.m_path.back());
+        }
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        friend class DocumentOrder;
+
+        // position in each node from the root to the leaf, empty at the end
+        std::vector<std::pair<const Node*, size_t>> m_path;
+
+        // go down to the first entry of the child at the current position of the last node
+        void descend();
+
+        // go to the first entry of the next leaf when the position is after the last entry
+        void skipEndOfLeaf();
+    };
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /// First entry having an id greater than the id
+    const_iterator upperBound(const DocumentId& id) const;
+
+private:
+    // the leaves and the branches are split beyond this size
+    static constexpr size_t NODE_SIZE = 64;
+
+    struct Split
+    {
+        NodePtr    node; ///< new right sibling, nullptr if the node was not split
+        DocumentId key;  ///< first id of the new sibling
+    };
+
+    size_t   m_size  = 0;
+    unsigned m_depth = 0; ///< number of branches above the leaves
+    NodePtr  m_root;
+
+    // changed by a copy: the nodes shared with the copy are no longer modified in place
+    mutable std::atomic<uint64_t> m_owner;
+
+    NodePtr createNode() const;
+
+    // copy the node if it is shared
+    Node& getMutableNode(NodePtr& node);
+
+    Split insert(NodePtr& node, unsigned level, const DocumentEntryPtr& entry);
+    void  erase(NodePtr& node, unsigned level, const DocumentId& id);
+
+    // merge the child with the next one if both fit in three quarters of a node
+    void mergeChildren(Node& branch, size_t index, unsigned childLevel);
+
+    bool contains(const DocumentId& id) const;
+};
+
+} // namespace secw
@@ -0,0 +1,156 @@
+/*  =========================================================================
+    secw_file_watcher - Notification of the modifications of a file
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_file_watcher - Notification of the modifications of a file
+@discuss
+@end
+*/
+
+#include "secw_file_watcher.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fty_log.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace secw {
+
+// events of the directory which can modify the file
+static constexpr const uint32_t WATCHED_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE;
+
+FileWatcher::FileWatcher(const std::string& path, FctOnChange onChange, std::chrono::milliseconds delay)
+    : m_onChange(onChange)
+    , m_delay(delay)
+{
+    size_t      separator = path.rfind('/');
+    std::string directory = (separator == std::string::npos) ? "." : path.substr(0, separator + 1);
+    m_fileName            = (separator == std::string::npos) ? path : path.substr(separator + 1);
+
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0) {
+        throw std::runtime_error("Impossible to create the inotify instance: " + std::string(strerror(errno)));
+    }
+
+    if ((inotify_add_watch(m_inotify, directory.c_str(), WATCHED_EVENTS) < 0) || (pipe2(m_stopPipe, O_CLOEXEC) != 0)) {
+        std::string error = strerror(errno);
+        close(m_inotify);
+        throw std::runtime_error("Impossible to watch " + path + ": " + error);
+    }
+
+    m_thread = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    // the end of the pipe wakes the thread up
+    close(m_stopPipe[1]);
+    m_thread.join();
+
+    close(m_stopPipe[0]);
+    close(m_inotify);
+}
+
+void FileWatcher::run()
+{
+    while (true) {
+        Wait result = waitForEvent(-1);
+
+        // an editor writes the file in several steps => wait for the last one
+        while (result == Wait::EVENT) {
+            result = waitForEvent(int(m_delay.count()));
+        }
+
+        if (result == Wait::STOPPED) {
+            return;
+        }
+
+        try {
+            m_onChange();
+        } catch (const std::exception& e) {
+            log_error("Error while handling the modification of %s: %s", m_fileName.c_str(), e.what());
+        }
+    }
+}
+
+FileWatcher::Wait FileWatcher::waitForEvent(int timeout)
+{
+    while (true) {
+        struct pollfd fds[2];
+        fds[0].fd      = m_inotify;
+        fds[0].events  = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd      = m_stopPipe[0];
+        fds[1].events  = POLLIN;
+        fds[1].revents = 0;
+
+        int nbReady = poll(fds, 2, timeout);
+
+        if (nbReady < 0) {
+            // interrupted by a signal: revents was not filled, wait again
+            if (errno == EINTR) {
+                continue;
+            }
+
+            log_error("Impossible to wait for the modifications of %s: %s", m_fileName.c_str(), strerror(errno));
+            return Wait::STOPPED;
+        }
+
+        if (nbReady == 0) {
+            return Wait::TIMEOUT;
+        }
+
+        if (fds[1].revents != 0) {
+            return Wait::STOPPED;
+        }
+
+        if (fds[0].revents == 0) {
+            continue;
+        }
+
+        // the events of the other files of the directory are ignored
+        alignas(struct inotify_event) char buffer[4096];
+        bool                               fileEvent = false;
+
+        ssize_t length;
+        while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+            for (char* ptr = buffer; ptr < buffer + length;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+
+                if ((event->len > 0) && (m_fileName == event->name)) {
+                    fileEvent = true;
+                }
+
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+
+        if (fileEvent) {
+            return Wait::EVENT;
+        }
+    }
+}
+
+} // namespace secw
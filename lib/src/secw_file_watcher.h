@@ -0,0 +1,73 @@
+/*  =========================================================================
+    secw_file_watcher - Notification of the modifications of a file
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace secw {
+
+/// @brief Thread calling a function when a file is modified (inotify)
+///
+/// The directory of the file is watched: a file replaced by a rename, as done by most
+/// editors, is detected. The events received during the delay are coalesced into one call.
+class FileWatcher
+{
+public:
+    using FctOnChange = std::function<void()>;
+
+    /// @exceptions: std::runtime_error if the file cannot be watched
+    FileWatcher(const std::string& path, FctOnChange onChange,
+        std::chrono::milliseconds delay = std::chrono::milliseconds(100));
+
+    /// Stop the thread, a call in progress is completed
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+private:
+    std::string               m_fileName;
+    FctOnChange               m_onChange;
+    std::chrono::milliseconds m_delay;
+
+    int m_inotify     = -1;
+    int m_stopPipe[2] = {-1, -1};
+
+    std::thread m_thread;
+
+    enum class Wait
+    {
+        EVENT,
+        TIMEOUT,
+        STOPPED
+    };
+
+    void run();
+
+    // wait for an event on the file, timeout in msec (-1: forever)
+    Wait waitForEvent(int timeout);
+};
+
+} // namespace secw
@@ -0,0 +1,178 @@
+/*  =========================================================================
+    secw_journal - Append-only journal of the wallet modifications
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_journal - Append-only journal of the wallet modifications
+@discuss
+@end
+*/
+
+#include "secw_journal.h"
+#include "secw_helpers.h"
+#include <cxxtools/serializationinfo.h>
+#include <fstream>
+#include <fty_log.h>
+#include <sys/stat.h>
+
+namespace secw {
+
+static constexpr const char* JOURNAL_SEQUENCE_ENTRY  = "sequence";
+static constexpr const char* JOURNAL_ACTION_ENTRY    = "action";
+static constexpr const char* JOURNAL_PORTFOLIO_ENTRY = "portfolio";
+static constexpr const char* JOURNAL_ID_ENTRY        = "id";
+static constexpr const char* JOURNAL_DOCUMENT_ENTRY  = "document";
+
+Journal::Journal(const std::string& path, const FsyncPolicy& policy)
+    : m_path(path)
+    , m_policy(policy)
+{
+}
+
+void Journal::append(const std::vector<JournalRecord>& records)
+{
+    if (records.empty()) {
+        return;
+    }
+
+    // prepare all the lines before to write them
+    std::string lines;
+
+    for (const JournalRecord& record : records) {
+        cxxtools::SerializationInfo si;
+        si.addMember(JOURNAL_SEQUENCE_ENTRY) <<= record.sequence;
+        si.addMember(JOURNAL_ACTION_ENTRY) <<= PortfolioChange::actionToString(record.change.action);
+        si.addMember(JOURNAL_PORTFOLIO_ENTRY) <<= record.portfolio;
+        si.addMember(JOURNAL_ID_ENTRY) <<= record.change.id;
+
+        if (record.change.document != nullptr) {
+            si.addMember(JOURNAL_DOCUMENT_ENTRY) <<= *record.change.document;
+        }
+
+        // json without beautify => one line per record
+        lines += serialize(si);
+        lines += "\n";
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    {
+        std::ofstream output(m_path, std::ios::binary | std::ios::app);
+        output << lines;
+        output.flush();
+
+        if (!output) {
+            throw std::runtime_error("Impossible to write in journal " + m_path);
+        }
+    }
+
+    std::chrono::steady_clock::time_point written = std::chrono::steady_clock::now();
+    m_statistics.addWrite(std::chrono::duration_cast<std::chrono::microseconds>(written - start));
+
+    if (m_policy.isSyncNeeded()) {
+        SnapshotWriter::syncPath(m_path);
+        m_statistics.addSync(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - written));
+    }
+}
+
+std::vector<JournalRecord> Journal::read(uint64_t afterSequence) const
+{
+    std::vector<JournalRecord> records;
+
+    std::ifstream input(m_path, std::ios::binary);
+    std::string   line;
+    size_t        lineNumber = 0;
+
+    while (std::getline(input, line)) {
+        lineNumber++;
+
+        if (line.empty()) {
+            continue;
+        }
+
+        try {
+            cxxtools::SerializationInfo si = deserialize(line);
+
+            JournalRecord record;
+            std::string   action;
+
+            si.getMember(JOURNAL_SEQUENCE_ENTRY) >>= record.sequence;
+            si.getMember(JOURNAL_ACTION_ENTRY) >>= action;
+            si.getMember(JOURNAL_PORTFOLIO_ENTRY) >>= record.portfolio;
+            si.getMember(JOURNAL_ID_ENTRY) >>= record.change.id;
+
+            record.change.action = PortfolioChange::actionFromString(action);
+
+            if (record.change.action != PortfolioChange::Action::DELETE) {
+                DocumentPtr document;
+                si.getMember(JOURNAL_DOCUMENT_ENTRY) >>= document;
+
+                record.change.document = document;
+            }
+
+            if (record.sequence > afterSequence) {
+                records.push_back(record);
+            }
+        } catch (const std::exception& e) {
+            // the end of the journal was not completely written => ignore it
+            log_warning("Journal %s: stop reading at line %zu: %s", m_path.c_str(), lineNumber, e.what());
+            break;
+        }
+    }
+
+    return records;
+}
+
+void Journal::syncPending()
+{
+    if (m_policy.hasPendingSync()) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        SnapshotWriter::syncPath(m_path);
+        m_policy.setSynced();
+
+        m_statistics.addSync(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+    }
+}
+
+void Journal::reset()
+{
+    std::ofstream output(m_path, std::ios::binary | std::ios::trunc);
+
+    if (!output) {
+        throw std::runtime_error("Impossible to reset journal " + m_path);
+    }
+}
+
+size_t Journal::size() const
+{
+    struct stat buffer;
+
+    if (stat(m_path.c_str(), &buffer) != 0) {
+        return 0;
+    }
+
+    return size_t(buffer.st_size);
+}
+
+} // namespace secw
@@ -0,0 +1,79 @@
+/*  =========================================================================
+    secw_journal - Append-only journal of the wallet modifications
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "secw_portfolio.h"
+#include "secw_snapshot_writer.h"
+#include <string>
+#include <vector>
+
+namespace secw {
+
+/// @brief One modification of a portfolio written in the journal
+struct JournalRecord
+{
+    uint64_t        sequence = 0;
+    std::string     portfolio;
+    PortfolioChange change;
+};
+
+/// @brief Append-only journal of the modifications done since the last snapshot of the database
+///
+/// Each record is written on its own line, in json. A record which cannot be read (for example
+/// because of a crash while writing it) ends the journal.
+class Journal
+{
+public:
+    explicit Journal(const std::string& path, const FsyncPolicy& policy = FsyncPolicy());
+
+    const std::string& getPath() const
+    {
+        return m_path;
+    }
+
+    /// Append the records at the end of the journal
+    void append(const std::vector<JournalRecord>& records);
+
+    /// Read the records with a sequence greater than afterSequence
+    std::vector<JournalRecord> read(uint64_t afterSequence = 0) const;
+
+    /// Remove all the records
+    void reset();
+
+    /// Size of the journal in bytes
+    size_t size() const;
+
+    /// Synchronize the records not synchronized by the policy
+    void syncPending();
+
+    const WriteStatistics& getStatistics() const
+    {
+        return m_statistics;
+    }
+
+private:
+    std::string     m_path;
+    FsyncPolicy     m_policy;
+    WriteStatistics m_statistics;
+};
+
+} // namespace secw
@@ -0,0 +1,251 @@
+/*  =========================================================================
+    secw_json_writer - Streaming writer of compact JSON
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_json_writer - Streaming writer of compact JSON
+@discuss
+@end
+*/
+
+#include "secw_json_writer.h"
+#include <cstdio>
+#include <stdexcept>
+
+namespace secw {
+
+// the buffer is written in the stream when it reaches this size
+static constexpr const size_t BUFFER_SIZE = 64 * 1024;
+
+JsonWriter::JsonWriter(std::ostream& output)
+    : m_output(output)
+{
+    m_buffer.reserve(BUFFER_SIZE + 1024);
+}
+
+JsonWriter::~JsonWriter()
+{
+    try {
+        flush();
+    } catch (const std::exception&) {
+    }
+}
+
+JsonWriter& JsonWriter::beginObject()
+{
+    separator();
+    m_buffer.push_back('{');
+    m_empty.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    m_buffer.push_back('}');
+    m_empty.pop_back();
+    checkBuffer();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+    separator();
+    m_buffer.push_back('[');
+    m_empty.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    m_buffer.push_back(']');
+    m_empty.pop_back();
+    checkBuffer();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const std::string& name)
+{
+    separator();
+    writeString(name);
+    m_buffer.push_back(':');
+    m_afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const std::string& value)
+{
+    separator();
+    writeString(value);
+    checkBuffer();
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* value)
+{
+    return this->value(std::string(value));
+}
+
+JsonWriter& JsonWriter::value(uint64_t value)
+{
+    separator();
+    m_buffer.append(std::to_string(value));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int64_t value)
+{
+    separator();
+    m_buffer.append(std::to_string(value));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool value)
+{
+    separator();
+    m_buffer.append(value ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::null()
+{
+    separator();
+    m_buffer.append("null");
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const cxxtools::SerializationInfo& si)
+{
+    if (si.category() == cxxtools::SerializationInfo::Array) {
+        beginArray();
+        for (const cxxtools::SerializationInfo& member : si) {
+            value(member);
+        }
+        endArray();
+    } else if ((si.category() == cxxtools::SerializationInfo::Object) || (si.memberCount() > 0)) {
+        beginObject();
+        for (const cxxtools::SerializationInfo& member : si) {
+            key(member.name());
+            value(member);
+        }
+        endObject();
+    } else if (si.isNull()) {
+        null();
+    } else if (si.isBool()) {
+        bool boolValue = false;
+        si.getValue(boolValue);
+        value(boolValue);
+    } else if (si.isInt()) {
+        long long intValue = 0;
+        si.getValue(intValue);
+        value(int64_t(intValue));
+    } else if (si.isUInt()) {
+        unsigned long long uintValue = 0;
+        si.getValue(uintValue);
+        value(uint64_t(uintValue));
+    } else if (si.isFloat()) {
+        long double floatValue = 0;
+        si.getValue(floatValue);
+
+        char text[64];
+        snprintf(text, sizeof(text), "%.21Lg", floatValue);
+
+        separator();
+        m_buffer.append(text);
+    } else {
+        std::string stringValue;
+        si.getValue(stringValue);
+        value(stringValue);
+    }
+
+    return *this;
+}
+
+void JsonWriter::flush()
+{
+    m_output.write(m_buffer.data(), std::streamsize(m_buffer.size()));
+    m_buffer.clear();
+
+    if (!m_output) {
+        throw std::runtime_error("Impossible to write the JSON content");
+    }
+}
+
+void JsonWriter::separator()
+{
+    if (m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+
+    if (!m_empty.empty()) {
+        if (!m_empty.back()) {
+            m_buffer.push_back(',');
+        }
+        m_empty.back() = false;
+    }
+}
+
+void JsonWriter::writeString(const std::string& value)
+{
+    static const char* HEX = "0123456789abcdef";
+
+    m_buffer.push_back('"');
+
+    for (char c : value) {
+        switch (c) {
+            case '"':
+                m_buffer.append("\\\"");
+                break;
+            case '\\':
+                m_buffer.append("\\\\");
+                break;
+            case '\n':
+                m_buffer.append("\\n");
+                break;
+            case '\r':
+                m_buffer.append("\\r");
+                break;
+            case '\t':
+                m_buffer.append("\\t");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    m_buffer.append("\\u00");
+                    m_buffer.push_back(HEX[(c >> 4) & 0x0F]);
+                    m_buffer.push_back(HEX[c & 0x0F]);
+                } else {
+                    // UTF-8 is kept as is
+                    m_buffer.push_back(c);
+                }
+        }
+    }
+
+    m_buffer.push_back('"');
+}
+
+void JsonWriter::checkBuffer()
+{
+    if (m_buffer.size() >= BUFFER_SIZE) {
+        flush();
+    }
+}
+
+} // namespace secw
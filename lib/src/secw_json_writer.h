@@ -0,0 +1,80 @@
+/*  =========================================================================
+    secw_json_writer - Streaming writer of compact JSON
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cxxtools/serializationinfo.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace secw {
+
+/// @brief Streaming writer of compact JSON
+///
+/// The values are written as they come, without building a tree: only a small buffer
+/// is kept in memory. The separators between the members are inserted automatically.
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::ostream& output);
+
+    /// The buffer must be flushed before: errors are not reported here
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    /// Name of the next member of the current object
+    JsonWriter& key(const std::string& name);
+
+    JsonWriter& value(const std::string& value);
+    JsonWriter& value(const char* value);
+    JsonWriter& value(uint64_t value);
+    JsonWriter& value(int64_t value);
+    JsonWriter& value(bool value);
+    JsonWriter& null();
+
+    /// Complete tree
+    JsonWriter& value(const cxxtools::SerializationInfo& si);
+
+    /// Write the buffer in the stream, throw on error
+    void flush();
+
+private:
+    std::ostream& m_output;
+    std::string   m_buffer;
+
+    // for each opened object or array: true until its first member is written
+    std::vector<bool> m_empty;
+    bool              m_afterKey = false;
+
+    void separator();
+    void writeString(const std::string& value);
+    void checkBuffer();
+};
+
+} // namespace secw
@@ -0,0 +1,175 @@
+/*  =========================================================================
+    secw_persistence_worker - Write-behind persistence of the security wallet
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_persistence_worker - Write-behind persistence of the security wallet
+@discuss
+@end
+*/
+
+#include "secw_persistence_worker.h"
+#include <fty_log.h>
+#include <stdexcept>
+
+namespace secw {
+
+// delay before writing again after a failure
+static constexpr std::chrono::seconds RETRY_DELAY(1);
+
+DurabilityPolicy StorageOptions::durabilityFromString(const std::string& durability)
+{
+    if (durability == "sync") {
+        return DurabilityPolicy::SYNC;
+    } else if (durability == "async") {
+        return DurabilityPolicy::ASYNC;
+    }
+
+    throw std::runtime_error("Unknown durability policy '" + durability + "'");
+}
+
+PersistenceWorker::PersistenceWorker(SaveFunction saveFunction, const StorageOptions& options)
+    : m_saveFunction(saveFunction)
+    , m_options(options)
+{
+    m_thread = std::thread(&PersistenceWorker::run, this);
+}
+
+PersistenceWorker::~PersistenceWorker()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_stop = true;
+    }
+    m_requested.notify_all();
+
+    m_thread.join();
+}
+
+uint64_t PersistenceWorker::requestSave()
+{
+    uint64_t ticket;
+
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        ticket = ++m_lastTicket;
+    }
+    m_requested.notify_all();
+
+    return ticket;
+}
+
+uint64_t PersistenceWorker::getLastTicket() const
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    return m_lastTicket;
+}
+
+void PersistenceWorker::waitForSave(uint64_t ticket)
+{
+    if (m_options.durability == DurabilityPolicy::SYNC) {
+        flush(ticket);
+    }
+}
+
+void PersistenceWorker::flush(uint64_t ticket)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    m_saved.wait(lock, [this, ticket]() {
+        return (m_lastSavedTicket >= ticket) || (m_lastFailedTicket >= ticket);
+    });
+
+    if (m_lastSavedTicket < ticket) {
+        throw std::runtime_error("Impossible to save the database: " + m_lastError);
+    }
+}
+
+uint64_t PersistenceWorker::getSaveCount() const
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    return m_saveCount;
+}
+
+void PersistenceWorker::run()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    while (true) {
+        if (m_lastTicket == m_lastSavedTicket) {
+            if (m_stop) {
+                break;
+            }
+
+            m_requested.wait(lock);
+            continue;
+        }
+
+        if (!m_stop) {
+            if (m_lastFailedTicket == m_lastTicket) {
+                // the last write failed: retry later or as soon as there is a new modification
+                m_requested.wait_for(lock, RETRY_DELAY, [this]() {
+                    return m_stop || (m_lastTicket > m_lastFailedTicket);
+                });
+            } else if (m_options.durability == DurabilityPolicy::ASYNC) {
+                // coalesce all the modifications received during the delay
+                m_requested.wait_for(lock, m_options.maxDelay, [this]() {
+                    return m_stop;
+                });
+            }
+        }
+
+        // all the tickets delivered so far are covered by this write
+        uint64_t    target = m_lastTicket;
+        std::string error;
+
+        lock.unlock();
+
+        try {
+            m_saveFunction();
+        } catch (const std::exception& e) {
+            error = e.what();
+        } catch (...) {
+            error = "unknown error";
+        }
+
+        lock.lock();
+
+        m_saveCount++;
+
+        if (error.empty()) {
+            m_lastSavedTicket = target;
+        } else {
+            log_error("Error while saving the database: %s", error.c_str());
+            m_lastFailedTicket = target;
+            m_lastError        = error;
+        }
+
+        m_saved.notify_all();
+
+        if (m_stop && !error.empty()) {
+            // do not retry forever when stopping
+            break;
+        }
+    }
+}
+
+} // namespace secw
@@ -0,0 +1,128 @@
+/*  =========================================================================
+    secw_persistence_worker - Write-behind persistence of the security wallet
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "secw_snapshot_writer.h"
+#include "secw_storage_format.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace secw {
+
+/// @brief When a modification of the wallet is acknowledged
+enum class DurabilityPolicy
+{
+    SYNC,  ///< once the modification is written in the database
+    ASYNC  ///< immediately, the modification is written at most maxDelay later
+};
+
+/// @brief Options of the storage of the wallet
+struct StorageOptions
+{
+    DurabilityPolicy          durability = DurabilityPolicy::SYNC;
+    std::chrono::milliseconds maxDelay{100};
+
+    /// Size of the journal (bytes) triggering its merge in the database
+    size_t journalMaxSize = 1024 * 1024;
+
+    /// When the database and the journal are forced to the disk
+    FsyncPolicy fsyncPolicy;
+
+    /// Encoding of the database, any format is accepted at load
+    StorageFormat format = StorageFormat::JSON;
+
+    /// Map a binary database and decode the documents on their first access
+    bool lazyLoad = false;
+
+    /// Number of threads decoding and validating the documents at load, 0: one per core
+    size_t loadThreads = 0;
+
+    /// Reload the configuration of the portfolios when its file is modified
+    bool watchConfiguration = false;
+
+    /// Parse "sync" or "async"
+    static DurabilityPolicy durabilityFromString(const std::string& durability);
+};
+
+/// @brief Thread writing the database in background
+///
+/// Each modification requests a save and gets a ticket. Several requests are coalesced
+/// into one write (group commit): a write covers all the tickets delivered before it starts.
+class PersistenceWorker
+{
+public:
+    using SaveFunction = std::function<void()>;
+
+    explicit PersistenceWorker(SaveFunction saveFunction, const StorageOptions& options = StorageOptions());
+
+    /// Write the pending modifications and stop the thread
+    ~PersistenceWorker();
+
+    PersistenceWorker(const PersistenceWorker&) = delete;
+    PersistenceWorker& operator=(const PersistenceWorker&) = delete;
+
+    /// Request a save of the current content: to be called once the modification is visible
+    uint64_t requestSave();
+
+    /// Last ticket delivered
+    uint64_t getLastTicket() const;
+
+    /// Wait until the ticket is written, if the durability policy requires it.
+    /// Throw if the write covering this ticket failed.
+    void waitForSave(uint64_t ticket);
+
+    /// Wait until the ticket is written, whatever the policy.
+    void flush(uint64_t ticket);
+
+    /// Number of writes done since the start
+    uint64_t getSaveCount() const;
+
+    const StorageOptions& getOptions() const
+    {
+        return m_options;
+    }
+
+private:
+    SaveFunction   m_saveFunction;
+    StorageOptions m_options;
+
+    mutable std::mutex      m_lock;
+    std::condition_variable m_requested;
+    std::condition_variable m_saved;
+
+    uint64_t    m_lastTicket       = 0;
+    uint64_t    m_lastSavedTicket  = 0;
+    uint64_t    m_lastFailedTicket = 0;
+    std::string m_lastError;
+    uint64_t    m_saveCount = 0;
+    bool        m_stop      = false;
+
+    std::thread m_thread;
+
+    void run();
+};
+
+} // namespace secw
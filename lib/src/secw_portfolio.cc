@@ -28,115 +28,929 @@
 
 #include "secw_portfolio.h"
 #include "secw_exception.h"
+#include "secw_helpers.h"
+#include "secw_openssl_wrapper.h"
+#include "secw_string_pool.h"
 #include <cxxtools/jsonserializer.h>
-#include <fty_common_mlm_guards.h>
+#include <algorithm>
+#include <atomic>
 #include <fty_log.h>
+#include <functional>
+#include <system_error>
+#include <thread>
 
 namespace secw {
 
+// comparison by name, for the usages sharing the overflow bit
+static bool hasCommonUsageName(const std::vector<InternedString>& documentUsages, const std::set<UsageId>& usages)
+{
+    for (const InternedString& usage : documentUsages) {
+        if (usages.count(*usage) > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void validateDocument(const Document& document, const ValidationCachePtr& cache)
+{
+    if (cache) {
+        cache->validate(document);
+    } else {
+        document.validate();
+    }
+}
+
+// below this number of documents per thread, starting the threads costs more than it saves
+static constexpr const size_t MIN_DOCUMENTS_PER_THREAD = 64;
+
+// call fct for each index in [0, count[ on nbThreads threads (0: one per core), fct must not throw
+static void parallelFor(size_t count, size_t nbThreads, const std::function<void(size_t)>& fct)
+{
+    if (nbThreads == 0) {
+        nbThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    nbThreads = std::min(nbThreads, (count + MIN_DOCUMENTS_PER_THREAD - 1) / MIN_DOCUMENTS_PER_THREAD);
+
+    std::atomic<size_t> next{0};
+
+    auto work = [&next, count, &fct]() {
+        for (size_t index = next++; index < count; index = next++) {
+            fct(index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (size_t thread = 1; thread < nbThreads; thread++) {
+        try {
+            threads.emplace_back(work);
+        } catch (const std::system_error& e) {
+            // the remaining indexes are handled by the threads already started
+            log_warning("Impossible to start a loading thread: %s", e.what());
+            break;
+        }
+    }
+
+    work();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+/*----------------------------------------------------------------------*/
+/*   DocumentEntry                                                      */
+/*----------------------------------------------------------------------*/
+// locks of the decodings, shared by the entries: a mutex per entry would double the size of a decoded one
+static constexpr const size_t NB_DECODE_LOCKS = 64;
+static std::mutex             s_decodeLocks[NB_DECODE_LOCKS];
+
+DocumentEntry::DocumentEntry(const ConstDocumentPtr& document, UsageMask usageMask)
+    : m_usageMask(usageMask)
+    , m_document(document)
+{
+}
+
+DocumentEntry::DocumentEntry(DocumentHeader header, const BinaryValue& value, const MappedStoragePtr& storage,
+    const ValidationCachePtr& validationCache, UsageMask usageMask)
+    : m_usageMask(usageMask)
+    , m_encoded(new Encoded{std::move(header), value, storage, validationCache})
+{
+}
+
+ConstDocumentPtr DocumentEntry::getDocument() const
+{
+    if (!m_encoded) {
+        return m_document;
+    }
+
+    ConstDocumentPtr document = std::atomic_load(&m_document);
+    if (document) {
+        return document;
+    }
+
+    // the first reader decodes it, the other ones wait for it
+    std::unique_lock<std::mutex> lock(s_decodeLocks[(uintptr_t(this) / sizeof(DocumentEntry)) % NB_DECODE_LOCKS]);
+
+    document = std::atomic_load(&m_document);
+    if (!document) {
+        cxxtools::SerializationInfo si;
+        m_encoded->value.decode(si);
+
+        DocumentPtr decoded;
+        si >>= decoded;
+        validateDocument(*decoded, m_encoded->validationCache);
+
+        document = decoded;
+        std::atomic_store(&m_document, document);
+    }
+
+    return document;
+}
+
+ConstDocumentPtr DocumentEntry::getHeaderDocument() const
+{
+    if (!m_encoded) {
+        return m_document;
+    }
+
+    const DocumentHeader&       header = m_encoded->header;
+    cxxtools::SerializationInfo si;
+
+    si.addMember(DOC_ID_ENTRY) <<= header.id.toString();
+    si.addMember(DOC_NAME_ENTRY) <<= header.name;
+    si.addMember(DOC_TYPE_ENTRY) <<= header.type;
+    si.addMember(DOC_VERSION_ENTRY) <<= header.version;
+    si.addMember(DOC_PARTIAL_ENTRY) <<= true;
+
+    cxxtools::SerializationInfo& tagsSi = si.addMember(DOC_TAGS_ENTRY);
+    for (const InternedString& tag : header.tags) {
+        tagsSi.addMember("") <<= *tag;
+    }
+    tagsSi.setCategory(cxxtools::SerializationInfo::Array);
+
+    cxxtools::SerializationInfo& usagesSi = si.addMember(DOC_USAGES_ENTRY);
+    for (const InternedString& usage : header.usages) {
+        usagesSi.addMember("") <<= *usage;
+    }
+    usagesSi.setCategory(cxxtools::SerializationInfo::Array);
+
+    DocumentPtr document;
+    si >>= document;
+
+    return document;
+}
+
+void DocumentEntry::serialize(cxxtools::SerializationInfo& si) const
+{
+    ConstDocumentPtr document = std::atomic_load(&m_document);
+
+    if (document) {
+        document->fillSerializationInfoWithSecret(si);
+    } else {
+        m_encoded->value.decode(si);
+    }
+}
+
+void DocumentEntry::serialize(JsonWriter& writer) const
+{
+    // only the tree of this document is built
+    cxxtools::SerializationInfo si;
+    serialize(si);
+
+    writer.value(si);
+}
+
+/*----------------------------------------------------------------------*/
+/*   PortfolioSnapshot                                                  */
+/*----------------------------------------------------------------------*/
+void PortfolioSnapshot::insert(const ConstDocumentPtr& document)
+{
+    insertEntry(std::make_shared<DocumentEntry>(document, assignUsageMask(document->getInternedUsageIds())));
+}
+
+void PortfolioSnapshot::insert(DocumentHeader header, const BinaryValue& value, const MappedStoragePtr& storage,
+    const ValidationCachePtr& validationCache)
+{
+    UsageMask usageMask = assignUsageMask(header.usages);
+    insertEntry(std::make_shared<DocumentEntry>(std::move(header), value, storage, validationCache, usageMask));
+}
+
+bool PortfolioSnapshot::erase(const DocumentId& id)
+{
+    const DocumentEntryPtr* existing = documents.find(id);
+    if (!existing) {
+        return false;
+    }
+
+    // keep the entry alive: it holds the keys
+    DocumentEntryPtr entry = *existing;
+
+    // the name may already belong to another document when the changes are replayed
+    const DocumentEntryPtr* named = documentsByName.find(entry->getName());
+    if (named && (*named == entry)) {
+        documentsByName.erase(entry->getName());
+    }
+
+    for (unsigned bit = 0; bit < documentsByUsage.size(); bit++) {
+        if (entry->getUsageMask() & (UsageMask(1) << bit)) {
+            documentsByUsage[bit].erase(entry->getId());
+        }
+    }
+
+    orderedDocuments.erase(entry->getId());
+    documents.erase(entry->getId());
+
+    return true;
+}
+
+bool PortfolioSnapshot::erase(std::string_view id)
+{
+    const DocumentEntryPtr* existing = documents.find(id);
+    if (!existing) {
+        return false;
+    }
+
+    // keep the entry alive: it holds the id
+    DocumentEntryPtr entry = *existing;
+    return erase(entry->getId());
+}
+
+UsageMask PortfolioSnapshot::getUsageMask(const std::set<UsageId>& usages) const
+{
+    UsageMask mask = 0;
+
+    for (const UsageId& usage : usages) {
+        auto it = usageBits.find(usage);
+        if (it != usageBits.end()) {
+            mask |= UsageMask(1) << it->second;
+        }
+    }
+
+    return mask;
+}
+
+bool PortfolioSnapshot::hasCommonUsage(
+    const DocumentEntry& entry, UsageMask mask, const std::set<UsageId>& usages) const
+{
+    UsageMask common = entry.getUsageMask() & mask;
+
+    // the usages sharing the last bit are compared by name
+    if (common == USAGE_OVERFLOW_BIT) {
+        return hasCommonUsageName(entry.getUsages(), usages);
+    }
+
+    return common != 0;
+}
+
+UsageMask PortfolioSnapshot::assignUsageMask(const std::vector<InternedString>& usages)
+{
+    static const unsigned OVERFLOW_BIT_INDEX = 63;
+
+    UsageMask mask = 0;
+
+    for (const InternedString& usage : usages) {
+        auto it = usageBits.find(*usage);
+
+        // the bits are never released: a usage keeps its bit in the following snapshots
+        if (it == usageBits.end()) {
+            unsigned bit = std::min(unsigned(usageBits.size()), OVERFLOW_BIT_INDEX);
+            it           = usageBits.emplace(*usage, bit).first;
+        }
+
+        mask |= UsageMask(1) << it->second;
+    }
+
+    return mask;
+}
+
+void PortfolioSnapshot::insertEntry(const DocumentEntryPtr& entry)
+{
+    // the former version of the document may have other usages and another name
+    erase(entry->getId());
+
+    documents.insert(entry);
+    documentsByName.insert(entry);
+    orderedDocuments.insert(entry);
+
+    for (unsigned bit = 0; bit < 64; bit++) {
+        if (entry->getUsageMask() & (UsageMask(1) << bit)) {
+            if (bit >= documentsByUsage.size()) {
+                documentsByUsage.resize(bit + 1);
+            }
+
+            documentsByUsage[bit].insert(entry);
+        }
+    }
+}
+
 /*----------------------------------------------------------------------*/
 /*   Portfolio                                                          */
 /*----------------------------------------------------------------------*/
 // Public
 Portfolio::Portfolio(const std::string& name)
     : m_name(name)
+    , m_snapshot(std::make_shared<PortfolioSnapshot>())
+    , m_epoch(DocumentId::generate().toString())
 {
 }
 
+Portfolio::Portfolio(const Portfolio& other)
+    : m_name(other.m_name)
+    , m_snapshot(other.getSnapshot())
+{
+    {
+        std::unique_lock<std::mutex> lock(other.m_changesLock);
+        m_changes = other.m_changes;
+    }
+
+    std::unique_lock<std::mutex> lock(other.m_changeLogLock);
+    m_epoch          = other.m_epoch;
+    m_changeLog      = other.m_changeLog;
+    m_changeLogStart = other.m_changeLogStart;
+    m_generation     = other.m_generation;
+}
+
+Portfolio& Portfolio::operator=(const Portfolio& other)
+{
+    if (this != &other) {
+        m_name = other.m_name;
+        std::atomic_store(&m_snapshot, other.getSnapshot());
+
+        std::vector<PortfolioChange> changes;
+        {
+            std::unique_lock<std::mutex> lock(other.m_changesLock);
+            changes = other.m_changes;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_changesLock);
+            m_changes = changes;
+        }
+
+        // the generations follow the copied snapshot
+        std::string                epoch;
+        std::deque<ChangeLogEntry> changeLog;
+        uint64_t                   changeLogStart;
+        uint64_t                   generation;
+        {
+            std::unique_lock<std::mutex> lock(other.m_changeLogLock);
+            epoch          = other.m_epoch;
+            changeLog      = other.m_changeLog;
+            changeLogStart = other.m_changeLogStart;
+            generation     = other.m_generation;
+        }
+
+        std::unique_lock<std::mutex> lock(m_changeLogLock);
+        m_epoch          = epoch;
+        m_changeLog      = changeLog;
+        m_changeLogStart = changeLogStart;
+        m_generation     = generation;
+    }
+
+    return *this;
+}
+
 Id Portfolio::add(const DocumentPtr& doc)
 {
+    return addDocuments({doc}).front();
+}
+
+void Portfolio::remove(const Id& id)
+{
+    removeDocuments({id});
+}
+
+void Portfolio::update(const DocumentPtr& doc)
+{
+    updateDocuments({doc});
+}
+
+std::vector<Id> Portfolio::addDocuments(const std::vector<DocumentPtr>& docs)
+{
+    if (docs.empty()) {
+        return {};
+    }
+
+    // the checks are done on the snapshot being built => they see the previous documents of the list
+    auto snapshot = std::make_shared<PortfolioSnapshot>(*getSnapshot());
+
+    std::vector<Id>               ids;
+    std::vector<ConstDocumentPtr> copies;
+
+    for (const DocumentPtr& doc : docs) {
+        // Check to ensure that the name do not exist => name unique by portfolio
+        if (snapshot->documentsByName.contains(doc->getName())) {
+            throw SecwNameAlreadyExistsException(doc->getName());
+        }
+
+        // create an id
+        DocumentId documentId;
+        do {
+            documentId = DocumentId::generate();
+        } while (snapshot->documents.contains(documentId)); // the id already exist, so we get a new one
+
+        // the text of the id is built for the reply only
+        Id id = documentId.toString();
+
+        // make a copy using factory
+        DocumentPtr copyDoc = doc->clone();
+
+        copyDoc->m_id      = std::move(documentId);
+        copyDoc->m_version = 1;
+
+        snapshot->insert(copyDoc);
+
+        ids.push_back(id);
+        copies.push_back(copyDoc);
+    }
+
+    // published only if all the documents are valid
+    publish(snapshot);
+
+    for (size_t index = 0; index < ids.size(); index++) {
+        recordChange(PortfolioChange::Action::CREATE, ids[index], copies[index]);
+    }
+
+    return ids;
+}
+
+void Portfolio::removeDocuments(const std::vector<Id>& ids)
+{
+    if (ids.empty()) {
+        return;
+    }
 
-    // Check to ensure that the name do not exist => name unique by portfolio
-    if (m_mapNameDocuments.count(doc->getName()) > 0) {
-        throw SecwNameAlreadyExistsException(doc->getName());
+    auto snapshot = std::make_shared<PortfolioSnapshot>(*getSnapshot());
+
+    for (const Id& id : ids) {
+        // Check if document exist, a document given twice does not exist the second time
+        if (!snapshot->erase(std::string_view(id))) {
+            throw SecwDocumentDoNotExistException(id);
+        }
     }
 
-    // create an id
-    Id id;
-    do {
-        ZuuidGuard zuuid(zuuid_new());
-        id = std::string(zuuid_str_canonical(zuuid.get()));
-    } while (m_documents.count(id) != 0); // the id already exist, so we get a new one
+    publish(snapshot);
+
+    for (const Id& id : ids) {
+        recordChange(PortfolioChange::Action::DELETE, id, nullptr);
+    }
+}
+
+void Portfolio::updateDocuments(const std::vector<DocumentPtr>& docs)
+{
+    if (docs.empty()) {
+        return;
+    }
+
+    auto snapshot = std::make_shared<PortfolioSnapshot>(*getSnapshot());
+
+    std::vector<ConstDocumentPtr> copies;
+
+    for (const DocumentPtr& doc : docs) {
+        const Id& id = doc->getId();
+
+        // Check if document exist
+        const DocumentEntryPtr* existing = snapshot->documents.find(id);
+        if (!existing) {
+            throw SecwDocumentDoNotExistException(id);
+        }
+
+        // ensure that if the name is modified, the new name do not already exist
+        if (doc->getName() != (*existing)->getName()) {
+            if (snapshot->documentsByName.contains(doc->getName())) {
+                throw SecwNameAlreadyExistsException(doc->getName());
+            }
+        }
+
+        DocumentPtr copyDoc = doc->clone();
+
+        // the version given by the caller is ignored
+        copyDoc->m_version = (*existing)->getVersion() + 1;
 
-    // make a copy using factory
-    DocumentPtr copyDoc = doc->clone();
+        // the former name and usages are removed with the former entry
+        snapshot->insert(copyDoc);
 
-    copyDoc->m_id = id;
+        copies.push_back(copyDoc);
+    }
 
-    m_documents[id]                        = copyDoc;
-    m_mapNameDocuments[copyDoc->getName()] = copyDoc;
+    publish(snapshot);
 
-    return id;
+    for (const ConstDocumentPtr& copy : copies) {
+        recordChange(PortfolioChange::Action::UPDATE, copy->getId(), copy);
+    }
 }
 
-void Portfolio::remove(const Id& id)
+ConstDocumentPtr Portfolio::getDocument(const Id& id) const
 {
-    // Check if document exist
-    if (m_documents.count(id) < 1) {
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    const DocumentEntryPtr* entry = snapshot->documents.find(id);
+    if (!entry) {
         throw SecwDocumentDoNotExistException(id);
     }
 
-    m_mapNameDocuments.erase(m_documents[id]->getName());
-    m_documents.erase(id);
+    return (*entry)->getDocument();
 }
 
-void Portfolio::update(const DocumentPtr& doc)
+ConstDocumentPtr Portfolio::getDocumentOrHeader(const Id& id) const
 {
-    Id id = doc->getId();
+    PortfolioSnapshotPtr snapshot = getSnapshot();
 
-    // Check if document exist
-    if (m_documents.count(id) < 1) {
+    const DocumentEntryPtr* entry = snapshot->documents.find(id);
+    if (!entry) {
         throw SecwDocumentDoNotExistException(id);
     }
 
-    DocumentPtr oldDoc = m_documents[id];
+    try {
+        return (*entry)->getDocument();
+    } catch (const std::exception& e) {
+        log_warning("Document %s cannot be decoded, only its header is given: %s", id.c_str(), e.what());
+    }
 
-    // ensure that if the name is modified, the new name do not already exist
-    if (doc->getName() != oldDoc->getName()) {
-        if (m_mapNameDocuments.count(doc->getName()) > 0) {
-            throw SecwNameAlreadyExistsException(doc->getName());
-        }
+    return (*entry)->getHeaderDocument();
+}
 
-        m_mapNameDocuments.erase(oldDoc->getName());
+// usages nullptr => all the documents are allowed
+static std::vector<ConstDocumentPtr> getDocumentsOfSnapshot(const PortfolioSnapshot& snapshot,
+    const std::vector<Id>& ids, const std::set<UsageId>* usages, std::vector<DocumentStatus>& statuses)
+{
+    UsageMask usageMask = usages ? snapshot.getUsageMask(*usages) : 0;
+
+    std::vector<ConstDocumentPtr> documents;
+    documents.reserve(ids.size());
+
+    statuses.clear();
+    statuses.reserve(ids.size());
+
+    for (const Id& id : ids) {
+        const DocumentEntryPtr* entry = snapshot.documents.find(id);
+
+        if (!entry) {
+            statuses.push_back(DocumentStatus::DOES_NOT_EXIST);
+        } else if (usages && !snapshot.hasCommonUsage(**entry, usageMask, *usages)) {
+            statuses.push_back(DocumentStatus::ILLEGAL_ACCESS);
+        } else {
+            documents.push_back((*entry)->getDocument());
+            statuses.push_back(DocumentStatus::FOUND);
+        }
     }
 
-    DocumentPtr copyDoc = doc->clone();
+    return documents;
+}
 
-    m_documents[id]                        = copyDoc;
-    m_mapNameDocuments[copyDoc->getName()] = copyDoc;
+std::vector<ConstDocumentPtr> Portfolio::getDocuments(
+    const std::vector<Id>& ids, std::vector<DocumentStatus>& statuses) const
+{
+    return getDocumentsOfSnapshot(*getSnapshot(), ids, nullptr, statuses);
 }
 
+std::vector<ConstDocumentPtr> Portfolio::getDocuments(
+    const std::vector<Id>& ids, const std::set<UsageId>& usages, std::vector<DocumentStatus>& statuses) const
+{
+    return getDocumentsOfSnapshot(*getSnapshot(), ids, &usages, statuses);
+}
 
-DocumentPtr Portfolio::getDocument(const Id& id) const
+ConstDocumentPtr Portfolio::getDocumentByName(const std::string& name) const
 {
-    if (m_documents.count(id) < 1) {
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    const DocumentEntryPtr* entry = snapshot->documentsByName.find(name);
+    if (!entry) {
+        throw SecwNameDoesNotExistException(name);
+    }
+
+    return (*entry)->getDocument();
+}
+
+ConstDocumentPtr Portfolio::getDocument(const Id& id, const std::set<UsageId>& usages) const
+{
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    const DocumentEntryPtr* entry = snapshot->documents.find(id);
+    if (!entry) {
         throw SecwDocumentDoNotExistException(id);
     }
 
-    return m_documents.at(id)->clone();
+    if (!snapshot->hasCommonUsage(**entry, snapshot->getUsageMask(usages), usages)) {
+        return nullptr;
+    }
+
+    return (*entry)->getDocument();
 }
 
-DocumentPtr Portfolio::getDocumentByName(const std::string& name) const
+ConstDocumentPtr Portfolio::getDocumentByName(const std::string& name, const std::set<UsageId>& usages) const
 {
-    if (m_mapNameDocuments.count(name) < 1) {
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    const DocumentEntryPtr* entry = snapshot->documentsByName.find(name);
+    if (!entry) {
         throw SecwNameDoesNotExistException(name);
     }
 
-    return m_mapNameDocuments.at(name)->clone();
+    if (!snapshot->hasCommonUsage(**entry, snapshot->getUsageMask(usages), usages)) {
+        return nullptr;
+    }
+
+    return (*entry)->getDocument();
+}
+
+// a document which cannot be decoded is skipped
+static void appendDocument(std::vector<ConstDocumentPtr>& documents, const DocumentEntry& entry)
+{
+    try {
+        documents.push_back(entry.getDocument());
+    } catch (const std::exception& e) {
+        log_error("Impossible to decode document %s: %s", entry.getId().toString().c_str(), e.what());
+    }
+}
+
+// the cursor is the encoded id of the last document of the page
+static const std::string CURSOR_PREFIX = "1:";
+
+static std::string encodeCursor(const DocumentId& id)
+{
+    return base64Encode(strToBytes(CURSOR_PREFIX + id.toString()));
+}
+
+static DocumentId decodeCursor(const std::string& cursor)
+{
+    std::string decoded = bytesToStr(base64Decode(cursor, 0, cursor.size()));
+
+    // given back by the clients: only the cursors of the previous pages are accepted
+    if ((decoded.compare(0, CURSOR_PREFIX.size(), CURSOR_PREFIX) != 0) ||
+        (base64Encode(strToBytes(decoded)) != cursor)) {
+        throw SecwBadCommandArgumentException("Invalid cursor " + cursor);
+    }
+
+    return DocumentId(decoded.substr(CURSOR_PREFIX.size()));
+}
+
+// the first documents given by next in the order of the ids, limit 0: all of them
+static DocumentPage buildPage(const std::function<DocumentEntryPtr()>& next, size_t limit)
+{
+    DocumentPage page;
+
+    DocumentEntryPtr entry = next();
+    DocumentEntryPtr last;
+
+    for (size_t count = 0; entry && ((limit == 0) || (count < limit)); count++) {
+        appendDocument(page.documents, *entry);
+
+        last  = std::move(entry);
+        entry = next();
+    }
+
+    // the cursor is the last id of the page, even if the document cannot be decoded
+    if (entry) {
+        page.nextCursor = encodeCursor(last->getId());
+    }
+
+    return page;
+}
+
+// the documents having at least one of the usages, by increasing id after the id (all of them for nullptr).
+// The documents of the other usages are not visited. The snapshot and the usages must outlive the function.
+static std::function<DocumentEntryPtr()> mergeEntriesWithUsages(
+    const PortfolioSnapshot& snapshot, const std::set<UsageId>& usages, const DocumentId* after)
+{
+    UsageMask mask = snapshot.getUsageMask(usages);
+
+    // next document of each usage, the usages with no more document are removed
+    std::vector<std::pair<DocumentOrder::const_iterator, DocumentOrder::const_iterator>> heads;
+
+    for (unsigned bit = 0; bit < snapshot.documentsByUsage.size(); bit++) {
+        if (mask & (UsageMask(1) << bit)) {
+            const DocumentOrder& ordered = snapshot.documentsByUsage[bit];
+
+            DocumentOrder::const_iterator it = after ? ordered.upperBound(*after) : ordered.begin();
+            if (it != ordered.end()) {
+                heads.emplace_back(std::move(it), ordered.end());
+            }
+        }
+    }
+
+    // merge of the usages by id: a document having several of the usages is in several of them
+    return [&snapshot, &usages, mask, heads]() mutable -> DocumentEntryPtr {
+        while (!heads.empty()) {
+            DocumentEntryPtr first = *heads.front().first;
+            for (const auto& head : heads) {
+                if ((*head.first)->getId() < first->getId()) {
+                    first = *head.first;
+                }
+            }
+
+            for (auto& head : heads) {
+                if (*head.first == first) {
+                    ++head.first;
+                }
+            }
+
+            heads.erase(std::remove_if(heads.begin(), heads.end(),
+                            [](const auto& head) {
+                                return head.first == head.second;
+                            }),
+                heads.end());
+
+            // the usages sharing the last bit are compared by name
+            if (snapshot.hasCommonUsage(*first, mask, usages)) {
+                return first;
+            }
+        }
+
+        return nullptr;
+    };
 }
 
-std::vector<DocumentPtr> Portfolio::getListDocuments() const
+std::vector<ConstDocumentPtr> Portfolio::getListDocuments() const
 {
-    std::vector<DocumentPtr> returnList;
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    std::vector<ConstDocumentPtr> returnList;
+    returnList.reserve(snapshot->documents.size());
 
-    for (const auto& item : m_documents) {
-        returnList.push_back(item.second);
+    for (const DocumentEntryPtr& entry : snapshot->orderedDocuments) {
+        appendDocument(returnList, *entry);
     }
 
     return returnList;
 }
 
-void Portfolio::loadPortfolio(const cxxtools::SerializationInfo& si)
+std::vector<ConstDocumentPtr> Portfolio::getListDocuments(const std::set<UsageId>& usages) const
+{
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    // same order as the pages
+    return buildPage(mergeEntriesWithUsages(*snapshot, usages, nullptr), 0).documents;
+}
+
+DocumentPage Portfolio::getPageDocuments(const std::string& cursor, size_t limit) const
+{
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    const DocumentOrder& ordered = snapshot->orderedDocuments;
+
+    // seek to the cursor: the documents before it are not visited
+    DocumentOrder::const_iterator it = cursor.empty() ? ordered.begin() : ordered.upperBound(decodeCursor(cursor));
+
+    auto next = [&]() -> DocumentEntryPtr {
+        if (it == ordered.end()) {
+            return nullptr;
+        }
+
+        DocumentEntryPtr entry = *it;
+        ++it;
+        return entry;
+    };
+
+    return buildPage(next, limit);
+}
+
+DocumentPage Portfolio::getPageDocuments(
+    const std::set<UsageId>& usages, const std::string& cursor, size_t limit) const
+{
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    if (cursor.empty()) {
+        return buildPage(mergeEntriesWithUsages(*snapshot, usages, nullptr), limit);
+    }
+
+    DocumentId after = decodeCursor(cursor);
+    return buildPage(mergeEntriesWithUsages(*snapshot, usages, &after), limit);
+}
+
+PortfolioSnapshotPtr Portfolio::getSnapshot() const
+{
+    return std::atomic_load(&m_snapshot);
+}
+
+std::vector<PortfolioChange> Portfolio::takeChanges()
+{
+    std::vector<PortfolioChange> changes;
+
+    std::unique_lock<std::mutex> lock(m_changesLock);
+    changes.swap(m_changes);
+
+    return changes;
+}
+
+void Portfolio::applyChanges(const std::vector<PortfolioChange>& changes)
+{
+    if (changes.empty()) {
+        return;
+    }
+
+    auto snapshot = std::make_shared<PortfolioSnapshot>(*getSnapshot());
+
+    for (const PortfolioChange& change : changes) {
+        if (change.action == PortfolioChange::Action::DELETE) {
+            snapshot->erase(std::string_view(change.id));
+        } else {
+            snapshot->insert(change.document);
+        }
+    }
+
+    publish(snapshot);
+    resetChangeLog();
+}
+
+void Portfolio::recordChange(PortfolioChange::Action action, const Id& id, const ConstDocumentPtr& document)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_changesLock);
+        m_changes.push_back({action, id, document});
+    }
+
+    // writers are serialized: the current snapshot is the one holding the modification
+    uint64_t generation = getSnapshot()->version;
+
+    std::unique_lock<std::mutex> lock(m_changeLogLock);
+    m_changeLog.push_back({generation, action, id});
+    m_generation = generation;
+
+    if (m_changeLog.size() > CHANGE_LOG_SIZE) {
+        m_changeLogStart = m_changeLog.front().generation;
+        m_changeLog.pop_front();
+    }
+}
+
+void Portfolio::resetChangeLog()
+{
+    uint64_t generation = getSnapshot()->version;
+
+    std::unique_lock<std::mutex> lock(m_changeLogLock);
+    m_changeLog.clear();
+    m_changeLogStart = generation;
+    m_generation     = generation;
+}
+
+std::string Portfolio::getGeneration() const
+{
+    std::unique_lock<std::mutex> lock(m_changeLogLock);
+    return m_epoch + ":" + std::to_string(m_generation);
+}
+
+DocumentChanges Portfolio::getChangesSince(const std::string& generation) const
+{
+    // <epoch>:<number>
+    size_t   separator = generation.rfind(':');
+    uint64_t number    = 0;
+
+    if (!generation.empty()) {
+        std::string digits = (separator == std::string::npos) ? "" : generation.substr(separator + 1);
+
+        if (digits.empty() || (digits.size() > 19) || (digits.find_first_not_of("0123456789") != std::string::npos)) {
+            throw SecwBadCommandArgumentException("Bad generation <" + generation + ">");
+        }
+
+        number = std::stoull(digits);
+    }
+
+    DocumentChanges changes;
+
+    // last action of each document, a document created and deleted since the generation is not given
+    std::map<Id, PortfolioChange::Action> actions;
+    {
+        std::unique_lock<std::mutex> lock(m_changeLogLock);
+
+        changes.generation = m_epoch + ":" + std::to_string(m_generation);
+        changes.fullResync = generation.empty() || (generation.compare(0, separator, m_epoch) != 0) ||
+                             (number < m_changeLogStart) || (number > m_generation);
+
+        if (changes.fullResync) {
+            return changes;
+        }
+
+        // the entries are in the order of the generations
+        auto it = std::upper_bound(m_changeLog.begin(), m_changeLog.end(), number,
+            [](uint64_t value, const ChangeLogEntry& entry) {
+                return value < entry.generation;
+            });
+
+        for (; it != m_changeLog.end(); ++it) {
+            auto known = actions.find(it->id);
+
+            if (known == actions.end()) {
+                actions.emplace(it->id, it->action);
+            } else if (it->action == PortfolioChange::Action::DELETE) {
+                if (known->second == PortfolioChange::Action::CREATE) {
+                    actions.erase(known);
+                } else {
+                    known->second = PortfolioChange::Action::DELETE;
+                }
+            } else if (known->second == PortfolioChange::Action::DELETE) {
+                known->second = PortfolioChange::Action::UPDATE;
+            }
+        }
+    }
+
+    for (const auto& action : actions) {
+        switch (action.second) {
+            case PortfolioChange::Action::CREATE:
+                changes.created.push_back(action.first);
+                break;
+            case PortfolioChange::Action::UPDATE:
+                changes.updated.push_back(action.first);
+                break;
+            case PortfolioChange::Action::DELETE:
+                changes.deleted.push_back(action.first);
+                break;
+        }
+    }
+
+    return changes;
+}
+
+void Portfolio::publish(std::shared_ptr<PortfolioSnapshot> snapshot)
+{
+    // the previous snapshot is released when its last reader drops it
+    snapshot->version = getSnapshot()->version + 1;
+    std::atomic_store(&m_snapshot, PortfolioSnapshotPtr(std::move(snapshot)));
+}
+
+void Portfolio::loadPortfolio(const cxxtools::SerializationInfo& si, const PortfolioLoadOptions& options)
 {
     uint8_t version = 0;
 
@@ -146,28 +960,141 @@ void Portfolio::loadPortfolio(const cxxtools::SerializationInfo& si)
         throw SecwImpossibleToLoadPortfolioException("Bad format of the serialization data");
     }
 
-    // remove former content
-    m_documents.clear();
-    m_mapNameDocuments.clear();
+    // replace former content
+    auto snapshot = std::make_shared<PortfolioSnapshot>();
 
     switch (version) {
         case 1:
-            loadPortfolioVersion1(si);
+            loadPortfolioVersion1(si, options, *snapshot);
             break;
         default:
             throw SecwImpossibleToLoadPortfolioException("Version " + std::to_string(version) + " not supported");
     }
+
+    publish(snapshot);
+    resetChangeLog();
+}
+
+void Portfolio::loadPortfolio(
+    const BinaryValue& value, const MappedStoragePtr& storage, const PortfolioLoadOptions& options)
+{
+    uint8_t                     version = 0;
+    cxxtools::SerializationInfo si;
+    BinaryValue                 documents;
+
+    try {
+        for (const auto& member : value.getMembers()) {
+            if (member.first == "documents") {
+                documents = member.second;
+            } else {
+                member.second.decode(si.addMember(member.first));
+            }
+        }
+
+        si.getMember("version") >>= version;
+        si.getMember("name") >>= m_name;
+    } catch (const std::exception& e) {
+        throw SecwImpossibleToLoadPortfolioException("Bad format of the serialization data");
+    }
+
+    if (version != 1) {
+        throw SecwImpossibleToLoadPortfolioException("Version " + std::to_string(version) + " not supported");
+    }
+
+    // replace former content
+    auto snapshot = std::make_shared<PortfolioSnapshot>();
+
+    try {
+        BinaryValue::Members members = documents.getMembers();
+
+        snapshot->documents.reserve(members.size());
+        snapshot->documentsByName.reserve(members.size());
+
+        for (const auto& document : members) {
+            try {
+                // the public and private parts stay in the storage, only a former file has no offset table
+                cxxtools::SerializationInfo headerSi;
+
+                for (const auto& member : document.second.getHeaderMembers()) {
+                    if ((member.first != DOC_PUBLIC_ENTRY) && (member.first != DOC_PRIVATE_ENTRY)) {
+                        member.second.decode(headerSi.addMember(member.first));
+                    }
+                }
+
+                Id id;
+                headerSi.getMember(DOC_ID_ENTRY) >>= id;
+
+                DocumentHeader header;
+                header.id = DocumentId(id);
+                headerSi.getMember(DOC_NAME_ENTRY) >>= header.name;
+                headerSi.getMember(DOC_TYPE_ENTRY) >>= header.type;
+                std::set<Tag>     tags;
+                std::set<UsageId> usages;
+                headerSi.getMember(DOC_TAGS_ENTRY) >>= tags;
+                headerSi.getMember(DOC_USAGES_ENTRY) >>= usages;
+
+                header.tags   = StringPool::intern(tags);
+                header.usages = StringPool::intern(usages);
+
+                if (headerSi.findMember(DOC_VERSION_ENTRY)) {
+                    headerSi.getMember(DOC_VERSION_ENTRY) >>= header.version;
+                }
+
+                if (header.id.empty() || !Document::isSupportedType(header.type)) {
+                    throw SecwInvalidDocumentFormatException(DOC_TYPE_ENTRY);
+                }
+
+                snapshot->insert(std::move(header), document.second, storage, options.validationCache);
+            } catch (const std::exception& e) {
+                log_error("Impossible to load a document from portfolio %s: %s", m_name.c_str(), e.what());
+            }
+        }
+    } catch (const std::exception& e) {
+        throw SecwImpossibleToLoadPortfolioException("Bad format of the serialization data in portfolio " + m_name);
+    }
+
+    log_debug("Portfolio %s mapped with %zu documents", m_name.c_str(), snapshot->documents.size());
+
+    publish(snapshot);
+    resetChangeLog();
 }
 
 void Portfolio::serializePortfolio(cxxtools::SerializationInfo& si) const
 {
     si.addMember("version") <<= PORTFOLIO_VERSION;
     si.addMember("name") <<= m_name;
-    si.addMember("documents") <<= getListDocuments();
+
+    cxxtools::SerializationInfo& siDocuments = si.addMember("documents");
+
+    // kept during the iteration, even if a new snapshot is published
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    for (const DocumentEntryPtr& entry : snapshot->orderedDocuments) {
+        entry->serialize(siDocuments.addMember(""));
+    }
+
+    siDocuments.setCategory(cxxtools::SerializationInfo::Array);
 }
 
-void Portfolio::loadPortfolioFromSRR(
-    const cxxtools::SerializationInfo& si, const std::string& encryptiondKey, bool isSameInstance)
+void Portfolio::serializePortfolio(JsonWriter& writer) const
+{
+    writer.beginObject();
+    writer.key("version").value(uint64_t(PORTFOLIO_VERSION));
+    writer.key("name").value(m_name);
+    writer.key("documents").beginArray();
+
+    PortfolioSnapshotPtr snapshot = getSnapshot();
+
+    for (const DocumentEntryPtr& entry : snapshot->orderedDocuments) {
+        entry->serialize(writer);
+    }
+
+    writer.endArray();
+    writer.endObject();
+}
+
+void Portfolio::loadPortfolioFromSRR(const cxxtools::SerializationInfo& si, const std::string& encryptiondKey,
+    bool isSameInstance, const PortfolioLoadOptions& options)
 {
     uint8_t version = 0;
 
@@ -177,17 +1104,19 @@ void Portfolio::loadPortfolioFromSRR(
         throw SecwImpossibleToLoadPortfolioException("Bad format of the serialization data");
     }
 
-    // remove former content
-    m_documents.clear();
-    m_mapNameDocuments.clear();
+    // replace former content
+    auto snapshot = std::make_shared<PortfolioSnapshot>();
 
     switch (version) {
         case 1:
-            loadPortfolioSRRVersion1(si, encryptiondKey, isSameInstance);
+            loadPortfolioSRRVersion1(si, encryptiondKey, isSameInstance, options, *snapshot);
             break;
         default:
             throw SecwImpossibleToLoadPortfolioException("Version " + std::to_string(version) + " not supported");
     }
+
+    publish(snapshot);
+    resetChangeLog();
 }
 
 void Portfolio::serializePortfolioSRR(cxxtools::SerializationInfo& si, const std::string& encryptiondKey) const
@@ -204,28 +1133,48 @@ void Portfolio::serializePortfolioSRR(cxxtools::SerializationInfo& si, const std
     siDocuments.setCategory(cxxtools::SerializationInfo::Array);
 }
 
-void Portfolio::loadPortfolioVersion1(const cxxtools::SerializationInfo& si)
+void Portfolio::loadPortfolioVersion1(
+    const cxxtools::SerializationInfo& si, const PortfolioLoadOptions& options, PortfolioSnapshot& snapshot)
 {
     try {
         si.getMember("name") >>= m_name;
         const cxxtools::SerializationInfo& documents = si.getMember("documents");
 
-        size_t count = 0;
+        // the validation of the certificates is costly => decoded in parallel
+        size_t                   nbDocuments = documents.memberCount();
+        std::vector<DocumentPtr> loaded(nbDocuments);
+        std::vector<std::string> errors(nbDocuments);
 
-        for (size_t index = 0; index < documents.memberCount(); index++) {
+        parallelFor(nbDocuments, options.nbThreads, [&documents, &options, &loaded, &errors](size_t index) {
             try {
                 DocumentPtr doc;
                 documents.getMember(uint32_t(index)) >>= doc;
 
-                doc->validate();
+                validateDocument(*doc, options.validationCache);
 
-                m_documents[doc->getId()]          = doc;
-                m_mapNameDocuments[doc->getName()] = doc;
-
-                count++;
+                loaded[index] = doc;
             } catch (const std::exception& e) {
-                log_error("Impossible to load a document from portfolio %s: %s", m_name.c_str(), e.what());
+                errors[index] = e.what();
             }
+        });
+
+        // inserted in the order of the serialization => the last one wins as before
+        size_t count = 0;
+
+        snapshot.documents.reserve(nbDocuments);
+        snapshot.documentsByName.reserve(nbDocuments);
+
+        for (size_t index = 0; index < nbDocuments; index++) {
+            const DocumentPtr& doc = loaded[index];
+
+            if (!doc) {
+                log_error("Impossible to load a document from portfolio %s: %s", m_name.c_str(), errors[index].c_str());
+                continue;
+            }
+
+            snapshot.insert(doc);
+
+            count++;
         }
 
         log_debug("Portfolio %s loaded with %i documents", m_name.c_str(), count);
@@ -235,8 +1184,8 @@ void Portfolio::loadPortfolioVersion1(const cxxtools::SerializationInfo& si)
     }
 }
 
-void Portfolio::loadPortfolioSRRVersion1(
-    const cxxtools::SerializationInfo& si, const std::string& encryptiondKey, bool isSameInstance)
+void Portfolio::loadPortfolioSRRVersion1(const cxxtools::SerializationInfo& si, const std::string& encryptiondKey,
+    bool isSameInstance, const PortfolioLoadOptions& options, PortfolioSnapshot& snapshot)
 {
     try {
         si.getMember("name") >>= m_name;
@@ -251,10 +1200,9 @@ void Portfolio::loadPortfolioSRRVersion1(
                 if ((!isSameInstance) && (doc->getType() == "InternalCertificate")) {
                     log_info("Skip InternalCertificate because the instance is not the same.");
                 } else {
-                    doc->validate();
+                    validateDocument(*doc, options.validationCache);
 
-                    m_documents[doc->getId()]          = doc;
-                    m_mapNameDocuments[doc->getName()] = doc;
+                    snapshot.insert(doc);
 
                     count++;
                 }
@@ -271,6 +1219,36 @@ void Portfolio::loadPortfolioSRRVersion1(
     }
 }
 
+/*----------------------------------------------------------------------*/
+/*   PortfolioChange                                                    */
+/*----------------------------------------------------------------------*/
+std::string PortfolioChange::actionToString(Action action)
+{
+    switch (action) {
+        case Action::CREATE:
+            return "CREATE";
+        case Action::UPDATE:
+            return "UPDATE";
+        case Action::DELETE:
+            return "DELETE";
+    }
+
+    return "";
+}
+
+PortfolioChange::Action PortfolioChange::actionFromString(const std::string& action)
+{
+    if (action == "CREATE") {
+        return Action::CREATE;
+    } else if (action == "UPDATE") {
+        return Action::UPDATE;
+    } else if (action == "DELETE") {
+        return Action::DELETE;
+    }
+
+    throw std::runtime_error("Unknown action '" + action + "'");
+}
+
 void operator<<=(cxxtools::SerializationInfo& si, const Portfolio& portfolio)
 {
     portfolio.serializePortfolio(si);
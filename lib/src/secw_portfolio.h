@@ -22,54 +22,341 @@
 #pragma once
 
 #include "secw_document.h"
+#include "secw_document_index.h"
+#include "secw_document_order.h"
+#include "secw_json_writer.h"
+#include "secw_storage_format.h"
+#include "secw_validation_cache.h"
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
 
 /// portfolio wallet
 namespace secw {
 
+/// Set of usages, one bit per usage of the portfolio
+using UsageMask = uint64_t;
+
+/// Bit shared by the usages beyond the 63 first ones of a portfolio: they are compared by name
+static constexpr const UsageMask USAGE_OVERFLOW_BIT = UsageMask(1) << 63;
+
+/// @brief Part of a document needed to find it and to check its access, read at load
+struct DocumentHeader
+{
+    DocumentId                  id;
+    std::string                 name;
+    DocumentType                type;
+    std::vector<InternedString> tags;        ///< sorted by text
+    std::vector<InternedString> usages;      ///< sorted by text
+    uint64_t                    version = 0; ///< see Document::getVersion()
+};
+
+/// @brief Resources used by a load, owned by the wallet holding the portfolio
+struct PortfolioLoadOptions
+{
+    /// Number of threads decoding and validating the documents, 0: one per core.
+    /// The documents are inserted in the order of the serialization whatever the number.
+    size_t nbThreads = 0;
+
+    /// Cache used to validate the documents, nullptr to validate all of them
+    ValidationCachePtr validationCache;
+};
+
+/// @brief Document held by a snapshot
+///
+/// A document loaded from a mapped database is decoded on its first access: only its
+/// header is decoded at load. It is decoded once, whatever the number of readers.
+/// The header of a document already decoded is read from the document itself.
+class DocumentEntry
+{
+public:
+    /// Document already decoded
+    explicit DocumentEntry(const ConstDocumentPtr& document, UsageMask usageMask = 0);
+
+    /// Document decoded on first access, the storage is kept as long as the entry exists.
+    /// The document is validated through the cache at its decoding, if any.
+    DocumentEntry(DocumentHeader header, const BinaryValue& value, const MappedStoragePtr& storage,
+        const ValidationCachePtr& validationCache, UsageMask usageMask = 0);
+
+    DocumentEntry(const DocumentEntry&) = delete;
+    DocumentEntry& operator=(const DocumentEntry&) = delete;
+
+    const DocumentId& getId() const
+    {
+        return m_encoded ? m_encoded->header.id : m_document->getDocumentId();
+    }
+
+    const std::string& getName() const
+    {
+        return m_encoded ? m_encoded->header.name : m_document->getName();
+    }
+
+    /// Sorted by text
+    const std::vector<InternedString>& getUsages() const
+    {
+        return m_encoded ? m_encoded->header.usages : m_document->getInternedUsageIds();
+    }
+
+    uint64_t getVersion() const
+    {
+        return m_encoded ? m_encoded->header.version : m_document->getVersion();
+    }
+
+    /// Usages, with the bits of the snapshot holding the document
+    UsageMask getUsageMask() const
+    {
+        return m_usageMask;
+    }
+
+    /// Shared document, to be cloned before any modification.
+    /// Throw if the encoded document is not valid.
+    ConstDocumentPtr getDocument() const;
+
+    /// Partial document holding only the header, built without decoding the document.
+    /// The document itself if it was decoded at its creation.
+    ConstDocumentPtr getHeaderDocument() const;
+
+    /// Serialization with the secret, without decoding the document if it was never accessed
+    void serialize(cxxtools::SerializationInfo& si) const;
+    void serialize(JsonWriter& writer) const;
+
+private:
+    struct Encoded
+    {
+        DocumentHeader     header;
+        BinaryValue        value;
+        MappedStoragePtr   storage;
+        ValidationCachePtr validationCache;
+    };
+
+    UsageMask m_usageMask = 0;
+
+    // nullptr for a document decoded at its creation
+    std::unique_ptr<const Encoded> m_encoded;
+
+    // set at creation, or once decoded with atomic operations for an encoded document
+    mutable ConstDocumentPtr m_document;
+};
+
+/// @brief Immutable content of a portfolio at a given version
+///
+/// A snapshot is never modified once published: the documents it holds are shared
+/// between the successive snapshots and must be cloned before any modification. A copy
+/// shares the nodes of the indexes, a writer only copies the nodes it modifies.
+///
+/// Each usage gets a bit, kept by the following snapshots: the access to a document is
+/// checked with a bitwise AND, and the documents of a usage are listed without visiting
+/// the other ones.
+struct PortfolioSnapshot
+{
+    uint64_t version = 0;
+
+    DocumentIndex documents{DocumentIndex::Key::ID};
+    DocumentIndex documentsByName{DocumentIndex::Key::NAME};
+
+    /// Documents by increasing id, for the pages
+    DocumentOrder orderedDocuments;
+
+    /// Bit of each usage in the masks
+    std::map<UsageId, unsigned> usageBits;
+
+    /// Documents having each usage by increasing id, by bit
+    std::vector<DocumentOrder> documentsByUsage;
+
+    /// Add a decoded document, in place of the document with the same id
+    void insert(const ConstDocumentPtr& document);
+
+    /// Add a document decoded on its first access, in place of the document with the same id
+    void insert(DocumentHeader header, const BinaryValue& value, const MappedStoragePtr& storage,
+        const ValidationCachePtr& validationCache);
+
+    /// Return false if the document does not exist
+    bool erase(const DocumentId& id);
+    bool erase(std::string_view id);
+
+    /// Mask of the usages known by the snapshot, the other ones are ignored
+    UsageMask getUsageMask(const std::set<UsageId>& usages) const;
+
+    /// Tell if the document has at least one of the usages, given with their mask
+    bool hasCommonUsage(const DocumentEntry& entry, UsageMask mask, const std::set<UsageId>& usages) const;
+
+private:
+    UsageMask assignUsageMask(const std::vector<InternedString>& usages);
+    void      insertEntry(const DocumentEntryPtr& entry);
+};
+
+using PortfolioSnapshotPtr = std::shared_ptr<const PortfolioSnapshot>;
+
+/// @brief Modification of a portfolio, kept until it is written in the journal
+struct PortfolioChange
+{
+    enum class Action
+    {
+        CREATE,
+        UPDATE,
+        DELETE
+    };
+
+    Action           action = Action::CREATE;
+    Id               id;
+    ConstDocumentPtr document; ///< content after the modification, nullptr for DELETE
+
+    static std::string actionToString(Action action);
+    static Action      actionFromString(const std::string& action);
+};
+
+/// @brief Part of a list of documents, ordered by id
+struct DocumentPage
+{
+    std::vector<ConstDocumentPtr> documents;
+    std::string                   nextCursor; ///< opaque, empty for the last page
+};
+
 /// @brief Class to represent a portfolio of documents
 ///
 /// This class contain the interface description use for action in the portfolio.
 /// Portfolio is keeped in memory and it is the responsability of the owner to
 /// save it permanently if needed.
+///
+/// Readers work on the current snapshot, which is loaded atomically and never blocks.
+/// Writers (add, remove, update, load) build a new snapshot and publish it: they must be
+/// serialized by the owner.
+///
+/// The documents are immutable once added: the readers share them without copy, and a
+/// modification stores a new document in place of the former one.
 class Portfolio
 {
 public:
     explicit Portfolio(const std::string& name = "default");
 
+    Portfolio(const Portfolio& other);
+    Portfolio& operator=(const Portfolio& other);
+
     const std::string& getName() const
     {
         return m_name;
     }
 
+    /// The document is copied: the caller keeps its own
     Id   add(const DocumentPtr& doc);
     void remove(const Id& id);
     void update(const DocumentPtr& doc);
 
-    DocumentPtr getDocument(const Id& id) const;
-    DocumentPtr getDocumentByName(const std::string& name) const;
+    /// All or nothing: on error, none of the documents is added and the portfolio is unchanged.
+    /// The documents are checked in order, each one with the previous ones of the list.
+    /// The modifications share the same generation.
+    std::vector<Id> addDocuments(const std::vector<DocumentPtr>& docs);
+    void            removeDocuments(const std::vector<Id>& ids);
+    void            updateDocuments(const std::vector<DocumentPtr>& docs);
+
+    /// Shared document, to be cloned before any modification
+    ConstDocumentPtr getDocument(const Id& id) const;
+    ConstDocumentPtr getDocumentByName(const std::string& name) const;
+
+    /// Document, or its header only (a partial document) if it cannot be decoded: such a document
+    /// is loaded from a mapped database and can only be deleted.
+    ConstDocumentPtr getDocumentOrHeader(const Id& id) const;
+
+    /// Document having at least one of the usages, nullptr if it has none of them:
+    /// such a document is not decoded
+    ConstDocumentPtr getDocument(const Id& id, const std::set<UsageId>& usages) const;
+    ConstDocumentPtr getDocumentByName(const std::string& name, const std::set<UsageId>& usages) const;
+
+    /// Documents of the ids, found on the same snapshot, in the order of the ids.
+    /// statuses receives the status of each id.
+    std::vector<ConstDocumentPtr> getDocuments(const std::vector<Id>& ids, std::vector<DocumentStatus>& statuses) const;
+
+    /// Same with the usages: a document having none of them is ILLEGAL_ACCESS and is not decoded
+    std::vector<ConstDocumentPtr> getDocuments(
+        const std::vector<Id>& ids, const std::set<UsageId>& usages, std::vector<DocumentStatus>& statuses) const;
+
+    /// Documents ordered by id, as in the portfolio files
+    std::vector<ConstDocumentPtr> getListDocuments() const;
+
+    /// Documents having at least one of the usages: the other ones are not decoded
+    std::vector<ConstDocumentPtr> getListDocuments(const std::set<UsageId>& usages) const;
+
+    /// At most limit documents following the cursor of the previous page, empty for the first page.
+    /// The documents are ordered by id: a document present during the whole listing is returned
+    /// once, whatever the modifications done between the pages.
+    /// @throw SecwBadCommandArgumentException if the cursor was not given by a previous page
+    DocumentPage getPageDocuments(const std::string& cursor, size_t limit) const;
+    DocumentPage getPageDocuments(const std::set<UsageId>& usages, const std::string& cursor, size_t limit) const;
+
+    /// Current content of the portfolio
+    PortfolioSnapshotPtr getSnapshot() const;
+
+    /// Generation of the current content, changed by each modification.
+    /// The generations of a former instance of the portfolio are not taken for its own ones.
+    std::string getGeneration() const;
 
-    std::vector<DocumentPtr> getListDocuments() const;
+    /// Documents created, updated or deleted since the generation, sorted by id.
+    /// Only the last CHANGE_LOG_SIZE modifications are known: fullResync is set for an older
+    /// generation, an empty one or the generation of another instance.
+    /// @exceptions SecwBadCommandArgumentException on a malformed generation
+    DocumentChanges getChangesSince(const std::string& generation) const;
 
-    void loadPortfolio(const cxxtools::SerializationInfo& si);
+    /// Get the modifications done since the last call, in order
+    std::vector<PortfolioChange> takeChanges();
+
+    /// Apply modifications read from the journal. A modification already contained in the
+    /// portfolio can be applied again without effect.
+    void applyChanges(const std::vector<PortfolioChange>& changes);
+
+    void loadPortfolio(const cxxtools::SerializationInfo& si, const PortfolioLoadOptions& options = {});
+
+    /// Load the headers of the documents, the rest is decoded on first access
+    void loadPortfolio(
+        const BinaryValue& value, const MappedStoragePtr& storage, const PortfolioLoadOptions& options = {});
     void serializePortfolio(cxxtools::SerializationInfo& si) const;
 
-    void loadPortfolioFromSRR(
-        const cxxtools::SerializationInfo& si, const std::string& encryptiondKey, bool isSameInstance = false);
+    /// Same content as serializePortfolio, streamed document per document
+    void serializePortfolio(JsonWriter& writer) const;
+
+    void loadPortfolioFromSRR(const cxxtools::SerializationInfo& si, const std::string& encryptiondKey,
+        bool isSameInstance = false, const PortfolioLoadOptions& options = {});
     void serializePortfolioSRR(cxxtools::SerializationInfo& si, const std::string& encryptiondKey) const;
 
     static constexpr const uint8_t PORTFOLIO_VERSION = 1;
 
+    /// Number of modifications kept for getChangesSince
+    static constexpr const size_t CHANGE_LOG_SIZE = 4096;
+
 private:
     std::string m_name;
 
-    // Map containing all the document of the portfolio
-    std::map<Id, DocumentPtr>          m_documents;
-    std::map<std::string, DocumentPtr> m_mapNameDocuments;
+    // Current content of the portfolio: only accessed with atomic operations
+    PortfolioSnapshotPtr m_snapshot;
+
+    // Modifications not yet written in the journal
+    mutable std::mutex           m_changesLock;
+    std::vector<PortfolioChange> m_changes;
+
+    struct ChangeLogEntry
+    {
+        uint64_t                generation;
+        PortfolioChange::Action action;
+        Id                      id;
+    };
+
+    // Last modifications, for the clients keeping a copy of the portfolio
+    mutable std::mutex         m_changeLogLock;
+    std::string                m_epoch;              ///< random, distinguishes the instances of the portfolio
+    std::deque<ChangeLogEntry> m_changeLog;          ///< in the order of the generations
+    uint64_t                   m_changeLogStart = 0; ///< the modifications after this generation are known
+    uint64_t                   m_generation     = 0; ///< generation of the last modification
+
+    void publish(std::shared_ptr<PortfolioSnapshot> snapshot);
+    void recordChange(PortfolioChange::Action action, const Id& id, const ConstDocumentPtr& document);
+
+    // the whole content was replaced: the former generations need a full resync
+    void resetChangeLog();
 
-    void loadPortfolioVersion1(const cxxtools::SerializationInfo& si);
-    void loadPortfolioSRRVersion1(
-        const cxxtools::SerializationInfo& si, const std::string& encryptiondKey, bool isSameInstance);
+    void loadPortfolioVersion1(
+        const cxxtools::SerializationInfo& si, const PortfolioLoadOptions& options, PortfolioSnapshot& snapshot);
+    void loadPortfolioSRRVersion1(const cxxtools::SerializationInfo& si, const std::string& encryptiondKey,
+        bool isSameInstance, const PortfolioLoadOptions& options, PortfolioSnapshot& snapshot);
 };
 
 void operator<<=(cxxtools::SerializationInfo& si, const Portfolio& portfolio);
@@ -87,8 +87,20 @@ std::set<UsageId> ProducerAccessor::getProducerUsages(const std::string& portfol
 std::vector<DocumentPtr> ProducerAccessor::getListDocumentsWithoutPrivateData(
     const std::string& portfolio, const UsageId& usageId) const
 {
+    return getListDocumentsWithoutPrivateData(portfolio, usageId, Projection());
+}
+
+std::vector<DocumentPtr> ProducerAccessor::getListDocumentsWithoutPrivateData(
+    const std::string& portfolio, const UsageId& usageId, const Projection& projection) const
+{
+    // the former servers do not know the projection: it is sent only when needed
+    std::vector<std::string> params = {portfolio, usageId};
+    if (!projection.toString().empty()) {
+        params.insert(params.end(), {"", "", projection.toString()});
+    }
+
     std::vector<std::string> frames =
-        m_clientAccessor->sendCommand(SecurityWalletServer::GET_LIST_WITHOUT_SECRET, {portfolio, usageId});
+        m_clientAccessor->sendCommand(SecurityWalletServer::GET_LIST_WITHOUT_SECRET, params);
 
     // the first frame should contain the data
     if (frames.size() < 1) {
@@ -104,9 +116,53 @@ std::vector<DocumentPtr> ProducerAccessor::getListDocumentsWithoutPrivateData(
     return documents;
 }
 
+std::vector<DocumentPtr> ProducerAccessor::getListDocumentsWithoutPrivateData(
+    const std::string& portfolio, const UsageId& usageId, size_t pageSize, const Projection& projection) const
+{
+    std::vector<DocumentPtr> documents;
+    std::string              cursor;
+
+    do {
+        std::vector<DocumentPtr> page =
+            getPageDocumentsWithoutPrivateData(portfolio, usageId, pageSize, cursor, projection);
+        documents.insert(documents.end(), page.begin(), page.end());
+    } while (!cursor.empty());
+
+    return documents;
+}
+
+std::vector<DocumentPtr> ProducerAccessor::getPageDocumentsWithoutPrivateData(const std::string& portfolio,
+    const UsageId& usageId, size_t limit, std::string& cursor, const Projection& projection) const
+{
+    std::vector<std::string> frames = m_clientAccessor->sendCommand(SecurityWalletServer::GET_LIST_WITHOUT_SECRET,
+        {portfolio, usageId, std::to_string(limit), cursor, projection.toString()});
+
+    // the first frame should contain the data
+    if (frames.size() < 1) {
+        throw SecwProtocolErrorException("Empty answer from server");
+    }
+
+    cxxtools::SerializationInfo si = deserialize(frames.at(0));
+
+    std::vector<DocumentPtr> documents;
+
+    si >>= documents;
+
+    // the second frame is the cursor of the next page, absent if all the documents are returned
+    cursor = (frames.size() >= 2) ? frames.at(1) : "";
+
+    return documents;
+}
+
 std::vector<DocumentPtr> ProducerAccessor::getListDocumentsWithoutPrivateData(
     const std::string& portfolio, const std::vector<Id>& ids) const
 {
+    try {
+        return getDocumentsWithoutPrivateData(portfolio, ids).documents;
+    } catch (const SecwUnsupportedCommandException&) {
+        // former server => one request by id
+    }
+
     std::vector<DocumentPtr> docs;
 
     for (const Id& id : ids) {
@@ -123,10 +179,44 @@ std::vector<DocumentPtr> ProducerAccessor::getListDocumentsWithoutPrivateData(
     return docs;
 }
 
-DocumentPtr ProducerAccessor::getDocumentWithoutPrivateData(const std::string& portfolio, const Id& id) const
+DocumentsByIds ProducerAccessor::getDocumentsWithoutPrivateData(
+    const std::string& portfolio, const std::vector<Id>& ids, const Projection& projection) const
 {
+    std::vector<std::string> params = {portfolio, projection.toString()};
+    params.insert(params.end(), ids.begin(), ids.end());
+
     std::vector<std::string> frames =
-        m_clientAccessor->sendCommand(SecurityWalletServer::GET_WITHOUT_SECRET, {portfolio, id});
+        m_clientAccessor->sendCommand(SecurityWalletServer::GET_WITHOUT_SECRET_BY_IDS, params);
+
+    // the first frame should contain the data
+    if (frames.size() < 1) {
+        throw SecwProtocolErrorException("Empty answer from server");
+    }
+
+    cxxtools::SerializationInfo si = deserialize(frames.at(0));
+
+    DocumentsByIds documents;
+
+    si >>= documents;
+
+    return documents;
+}
+
+DocumentPtr ProducerAccessor::getDocumentWithoutPrivateData(const std::string& portfolio, const Id& id) const
+{
+    return getDocumentWithoutPrivateData(portfolio, id, Projection());
+}
+
+DocumentPtr ProducerAccessor::getDocumentWithoutPrivateData(
+    const std::string& portfolio, const Id& id, const Projection& projection) const
+{
+    // the former servers do not know the projection: it is sent only when needed
+    std::vector<std::string> params = {portfolio, id};
+    if (!projection.toString().empty()) {
+        params.push_back(projection.toString());
+    }
+
+    std::vector<std::string> frames = m_clientAccessor->sendCommand(SecurityWalletServer::GET_WITHOUT_SECRET, params);
 
     // the first frame should contain the data
     if (frames.size() < 1) {
@@ -162,6 +252,25 @@ DocumentPtr ProducerAccessor::getDocumentWithoutPrivateDataByName(
     return document;
 }
 
+DocumentChanges ProducerAccessor::getChangesSince(const std::string& portfolio, const std::string& generation) const
+{
+    std::vector<std::string> frames =
+        m_clientAccessor->sendCommand(SecurityWalletServer::GET_CHANGES_SINCE, {portfolio, generation});
+
+    // the first frame should contain the data
+    if (frames.size() < 1) {
+        throw SecwProtocolErrorException("Empty answer from server");
+    }
+
+    cxxtools::SerializationInfo si = deserialize(frames.at(0));
+
+    DocumentChanges changes;
+
+    si >>= changes;
+
+    return changes;
+}
+
 Id ProducerAccessor::insertNewDocument(const std::string& portfolio, const DocumentPtr& doc) const
 {
     cxxtools::SerializationInfo si;
@@ -188,6 +297,40 @@ void ProducerAccessor::deleteDocument(const std::string& portfolio, const Id& id
     m_clientAccessor->sendCommand(SecurityWalletServer::DELETE, {portfolio, id});
 }
 
+// portfolio followed by one frame per document
+static std::vector<std::string> documentFrames(const std::string& portfolio, const std::vector<DocumentPtr>& docs)
+{
+    std::vector<std::string> params = {portfolio};
+    params.reserve(docs.size() + 1);
+
+    for (const DocumentPtr& doc : docs) {
+        cxxtools::SerializationInfo si;
+        si <<= doc;
+        params.push_back(serialize(si));
+    }
+
+    return params;
+}
+
+std::vector<Id> ProducerAccessor::insertNewDocuments(
+    const std::string& portfolio, const std::vector<DocumentPtr>& docs) const
+{
+    return m_clientAccessor->sendCommand(SecurityWalletServer::BULK_CREATE, documentFrames(portfolio, docs));
+}
+
+void ProducerAccessor::updateDocuments(const std::string& portfolio, const std::vector<DocumentPtr>& docs) const
+{
+    m_clientAccessor->sendCommand(SecurityWalletServer::BULK_UPDATE, documentFrames(portfolio, docs));
+}
+
+void ProducerAccessor::deleteDocuments(const std::string& portfolio, const std::vector<Id>& ids) const
+{
+    std::vector<std::string> params = {portfolio};
+    params.insert(params.end(), ids.begin(), ids.end());
+
+    m_clientAccessor->sendCommand(SecurityWalletServer::BULK_DELETE, params);
+}
+
 void ProducerAccessor::setCallbackOnUpdate(UpdatedCallback updatedCallback)
 {
     m_clientAccessor->setCallbackOnUpdate(updatedCallback);
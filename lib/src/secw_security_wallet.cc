@@ -29,8 +29,10 @@
 
 #include "secw_security_wallet.h"
 #include "secw_helpers.h"
+#include "secw_storage_format.h"
+#include <algorithm>
+#include <cstdio>
 #include <cxxtools/jsondeserializer.h>
-#include <cxxtools/jsonserializer.h>
 #include <fstream>
 #include <fty_log.h>
 #include <iostream>
@@ -39,14 +41,66 @@
 
 namespace secw {
 static std::string getHardwareUuid();
+
+// parse the configuration file, with the content of each portfolio configuration
+static std::shared_ptr<PortfolioConfigurations> loadConfigurations(
+    const std::string& path, std::map<std::string, std::string>& contents)
+{
+    auto configurations = std::make_shared<PortfolioConfigurations>();
+
+    struct stat buffer;
+    bool        fileExist = (stat(path.c_str(), &buffer) == 0);
+
+    if (!fileExist) {
+        throw std::runtime_error("File does not exist!");
+    }
+
+    std::ifstream input;
+
+    input.open(path);
+
+    cxxtools::SerializationInfo rootSi;
+    cxxtools::JsonDeserializer  deserializer(input);
+    deserializer.deserialize(rootSi);
+
+    // it's an array
+    for (size_t index = 0; index < rootSi.memberCount(); index++) {
+        const cxxtools::SerializationInfo& portfolioConfigSi = rootSi.getMember(uint32_t(index));
+        PortfolioConfiguration             config(portfolioConfigSi);
+
+        if (configurations->count(config.getPortfolioName()) > 0) {
+            throw std::runtime_error("Portfolio " + config.getPortfolioName() + " already exist in the configuration.");
+        }
+
+        configurations->emplace(config.getPortfolioName(), config);
+        contents[config.getPortfolioName()] = serialize(portfolioConfigSi);
+    }
+
+    if (configurations->empty()) {
+        throw std::runtime_error("No Portfolio in the configuration.");
+    }
+
+    return configurations;
+}
+
 /*-----------------------------------------------------------------------------*/
 /*   SecurityWallet                                                            */
 /*-----------------------------------------------------------------------------*/
 // Public
-SecurityWallet::SecurityWallet(const std::string& configurationPath, const std::string& databasePath)
+SecurityWallet::SecurityWallet(
+    const std::string& configurationPath, const std::string& databasePath, const StorageOptions& storageOptions)
     : m_pathConfiguration(configurationPath)
     , m_pathDatabase(databasePath)
+    , m_storageOptions(storageOptions)
+    , m_snapshotWriter(databasePath, storageOptions.fsyncPolicy)
+    , m_journal(databasePath + ".journal", storageOptions.fsyncPolicy)
+    , m_validationCache(std::make_shared<ValidationCache>())
 {
+    m_validationCache->load(m_pathDatabase + ".validation");
+
+    m_loadOptions.nbThreads       = storageOptions.loadThreads;
+    m_loadOptions.validationCache = m_validationCache;
+
     try {
         reload();
     } catch (const std::exception& e) {
@@ -55,63 +109,67 @@ SecurityWallet::SecurityWallet(const std::string& configurationPath, const std::
 
 
     // attempt to save the database and ensure that we can write
+    // => the journal is merged in the portfolio files and the database is migrated to the last version.
+    // Only the modified portfolios are written: a mapped portfolio up to date is never decoded.
     try {
         save();
+        checkWritable();
     } catch (const std::exception& e) {
         log_error("Error while saving into database file %s\n %s", m_pathDatabase.c_str(), e.what());
         exit(EXIT_FAILURE);
     }
-}
 
-void SecurityWallet::reload()
-{
-    m_configurations.clear();
-    m_portfolios.clear();
+    m_fsyncTimer.reset(new FsyncTimer(storageOptions.fsyncPolicy, [this]() {
+        syncPendingWrites();
+    }));
 
-    // Load Config and then Database
-
-    // Load Config
-    try {
-        struct stat buffer;
-        bool        fileExist = (stat(m_pathConfiguration.c_str(), &buffer) == 0);
+    m_persistence.reset(new PersistenceWorker(std::bind(&SecurityWallet::persistChanges, this), storageOptions));
 
-        if (!fileExist) {
-            throw std::runtime_error("File does not exist!");
+    // without watch, the configuration is still reloaded by a restart
+    if (storageOptions.watchConfiguration) {
+        try {
+            m_configurationWatcher.reset(new FileWatcher(m_pathConfiguration, [this]() {
+                reloadConfiguration();
+            }));
+        } catch (const std::exception& e) {
+            log_warning("Configuration %s is not watched: %s", m_pathConfiguration.c_str(), e.what());
         }
+    }
+}
 
-        std::ifstream input;
-
-        input.open(m_pathConfiguration);
-
-        cxxtools::SerializationInfo rootSi;
-        cxxtools::JsonDeserializer  deserializer(input);
-        deserializer.deserialize(rootSi);
-
-        // it's an array
-        for (size_t index = 0; index < rootSi.memberCount(); index++) {
-            const cxxtools::SerializationInfo& portfolioConfigSi = rootSi.getMember(uint32_t(index));
-            PortfolioConfiguration             config(portfolioConfigSi);
+void SecurityWallet::reload()
+{
+    std::unique_lock<std::mutex> configurationLock(m_configurationLock);
 
-            if (m_configurations.count(config.getPortfolioName()) > 0) {
-                throw std::runtime_error(
-                    "Portfolio " + config.getPortfolioName() + " already exist in the configuration.");
-            }
+    // the new content is published once completely loaded
+    std::shared_ptr<PortfolioConfigurations> configurations;
+    std::map<std::string, std::string>       configurationContents;
 
-            m_configurations.emplace(config.getPortfolioName(), config);
-        }
+    auto portfolios = std::make_shared<PortfolioList>();
 
-        if (m_configurations.empty()) {
-            throw std::runtime_error("No Portfolio in the configuration.");
-        }
+    // Load Config and then Database
 
+    // Load Config
+    try {
+        configurations = loadConfigurations(m_pathConfiguration, configurationContents);
     } catch (const std::exception& e) {
         log_error("Error while loading configuration file %s\n %s", m_pathConfiguration.c_str(), e.what());
         throw;
     }
 
 
-    // Load database
+    // Load database and then replay the journal
     try {
+        std::unique_lock<std::mutex> lock(m_saveLock);
+
+        // for each portfolio, sequence of the last modification contained in its file
+        std::map<std::string, uint64_t> portfolioSequences;
+        bool                            hasJournal = false;
+
+        std::set<std::string> dirtyPortfolios;
+        std::set<std::string> manifestPortfolios;
+        bool                  manifestNeeded = false;
+
         struct stat buffer;
         bool        fileExist = (stat(m_pathDatabase.c_str(), &buffer) == 0);
 
@@ -119,27 +177,66 @@ void SecurityWallet::reload()
         if (fileExist) {
             std::ifstream input;
 
-            input.open(m_pathDatabase);
+            input.open(m_pathDatabase, std::ios::binary);
 
-            cxxtools::SerializationInfo rootSi;
-            cxxtools::JsonDeserializer  deserializer(input);
-            deserializer.deserialize(rootSi);
+            cxxtools::SerializationInfo rootSi = readStorage(input);
 
             uint8_t version = 0;
             rootSi.getMember("version") >>= version;
 
-            if (version == 1) {
-                rootSi.getMember("portfolios") >>= m_portfolios;
+            if ((version == 0) || (version > SECW_VERSION)) {
+                throw std::runtime_error("Version " + std::to_string(version) + " not supported");
+            }
+
+            if (version >= 3) {
+                // manifest: one file per portfolio
+                const cxxtools::SerializationInfo& portfoliosSi = rootSi.getMember("portfolios");
+
+                for (size_t index = 0; index < portfoliosSi.memberCount(); index++) {
+                    std::string name;
+                    portfoliosSi.getMember(uint32_t(index)).getMember("name") >>= name;
+
+                    uint64_t sequence = 0;
+                    portfolios->push_back(loadPortfolioFile(getPortfolioPath(m_pathDatabase, name), sequence));
+
+                    portfolioSequences[name] = sequence;
+                    manifestPortfolios.insert(name);
+                }
+
+                hasJournal = true;
+            } else {
+                // single file => migrated to one file per portfolio at the next write
+                const cxxtools::SerializationInfo& portfoliosSi = rootSi.getMember("portfolios");
+
+                // version 1 has no journal
+                uint64_t sequence = 0;
+                if (version >= 2) {
+                    rootSi.getMember("journal_sequence") >>= sequence;
+                    hasJournal = true;
+                }
+
+                for (size_t index = 0; index < portfoliosSi.memberCount(); index++) {
+                    auto portfolio = std::make_shared<Portfolio>();
+                    portfolio->loadPortfolio(portfoliosSi.getMember(uint32_t(index)), m_loadOptions);
+                    portfolios->push_back(portfolio);
+
+                    portfolioSequences[portfolio->getName()] = sequence;
+                    dirtyPortfolios.insert(portfolio->getName());
+                }
+
+                log_info(" Database %s version %u is migrated to one file per portfolio", m_pathDatabase.c_str(),
+                    unsigned(version));
+                manifestNeeded = true;
             }
         } else {
             log_info(" No database %s. Creating default database...", m_pathDatabase.c_str());
         }
 
-        for (const auto& item : m_configurations) {
+        for (const auto& item : *configurations) {
             // check that we have the portfolio in the list
             bool found = false;
-            for (const auto& portfolio : m_portfolios) {
-                if (item.first == portfolio.getName()) {
+            for (const auto& portfolio : *portfolios) {
+                if (item.first == portfolio->getName()) {
                     found = true;
                     break;
                 }
@@ -147,13 +244,149 @@ void SecurityWallet::reload()
 
             // if it not exist we add it.
             if (!found) {
-                m_portfolios.emplace_back(Portfolio(item.first));
+                portfolios->push_back(std::make_shared<Portfolio>(item.first));
+
+                dirtyPortfolios.insert(item.first);
+                manifestNeeded = true;
+            }
+        }
+
+        // the journal contains the modifications done after each portfolio file was written
+        // => a database without journal sequence (no file or version 1) has no journal
+        std::map<std::string, std::vector<PortfolioChange>> changes;
+        size_t                                              nbRecords = 0;
+
+        uint64_t journalSequence = 0;
+        uint64_t minSequence     = UINT64_MAX;
+
+        for (const auto& item : portfolioSequences) {
+            journalSequence = std::max(journalSequence, item.second);
+            minSequence     = std::min(minSequence, item.second);
+        }
+
+        std::vector<JournalRecord> records;
+        if (hasJournal) {
+            // a portfolio missing from the manifest has all its modifications in the journal
+            records = m_journal.read((portfolioSequences.size() < portfolios->size()) ? 0 : minSequence);
+        }
+
+        for (JournalRecord& record : records) {
+            auto it = portfolioSequences.find(record.portfolio);
+
+            if ((it == portfolioSequences.end()) || (record.sequence > it->second)) {
+                changes[record.portfolio].push_back(record.change);
+                nbRecords++;
             }
+
+            journalSequence = std::max(journalSequence, record.sequence);
+        }
+
+        for (const auto& portfolio : *portfolios) {
+            auto it = changes.find(portfolio->getName());
+
+            if (it != changes.end()) {
+                portfolio->applyChanges(it->second);
+                dirtyPortfolios.insert(it->first);
+                changes.erase(it);
+            }
+        }
+
+        for (const auto& item : changes) {
+            log_warning("Journal contains modifications of unknown portfolio %s", item.first.c_str());
         }
+
+        log_debug("%zu modifications replayed from journal %s", nbRecords, m_journal.getPath().c_str());
+
+        m_journalSequence    = journalSequence;
+        m_dirtyPortfolios    = dirtyPortfolios;
+        m_manifestPortfolios = manifestPortfolios;
+        m_manifestNeeded     = manifestNeeded;
     } catch (const std::exception& e) {
         log_error("Error while loading database file %s\n %s", m_pathDatabase.c_str(), e.what());
         throw;
     }
+
+    std::atomic_store(&m_configurations, PortfolioConfigurationsPtr(configurations));
+    std::atomic_store(&m_portfolios, PortfolioListPtr(portfolios));
+    m_configurationContents = configurationContents;
+
+    // only a hint for the next start => a failure is not an error
+    try {
+        m_validationCache->save(m_pathDatabase + ".validation");
+    } catch (const std::exception& e) {
+        log_warning("Impossible to save the validation cache: %s", e.what());
+    }
+
+    ValidationCache::Statistics statistics = m_validationCache->getStatistics();
+    log_debug("Validation cache: %llu hits, %llu misses", (unsigned long long)statistics.hits,
+        (unsigned long long)statistics.misses);
+}
+
+void SecurityWallet::reloadConfiguration()
+{
+    std::unique_lock<std::mutex> configurationLock(m_configurationLock);
+
+    // parsed without blocking anything: the requests keep the current configuration meanwhile
+    std::map<std::string, std::string>       contents;
+    std::shared_ptr<PortfolioConfigurations> configurations = loadConfigurations(m_pathConfiguration, contents);
+
+    std::vector<std::string> addedPortfolios;
+    bool                     modified = false;
+
+    for (const auto& item : contents) {
+        auto it = m_configurationContents.find(item.first);
+
+        if (it == m_configurationContents.end()) {
+            log_info("Portfolio %s added to the configuration", item.first.c_str());
+            addedPortfolios.push_back(item.first);
+            modified = true;
+        } else if (it->second != item.second) {
+            log_info("Configuration of portfolio %s modified", item.first.c_str());
+            modified = true;
+        }
+    }
+
+    for (const auto& item : m_configurationContents) {
+        if (contents.count(item.first) == 0) {
+            log_warning("Portfolio %s removed from the configuration: its documents are kept", item.first.c_str());
+            modified = true;
+        }
+    }
+
+    if (!modified) {
+        log_debug("Configuration %s unchanged", m_pathConfiguration.c_str());
+        return;
+    }
+
+    if (!addedPortfolios.empty()) {
+        // the list is replaced, the existing portfolios are shared => their documents are untouched
+        std::unique_lock<std::mutex> lock(m_saveLock);
+
+        auto portfolios = std::make_shared<PortfolioList>(*std::atomic_load(&m_portfolios));
+
+        for (const std::string& name : addedPortfolios) {
+            bool found = false;
+            for (const auto& portfolio : *portfolios) {
+                if (name == portfolio->getName()) {
+                    found = true;
+                    break;
+                }
+            }
+
+            // the documents of a portfolio removed then added again are kept
+            if (!found) {
+                portfolios->push_back(std::make_shared<Portfolio>(name));
+
+                m_dirtyPortfolios.insert(name);
+                m_manifestNeeded = true;
+            }
+        }
+
+        std::atomic_store(&m_portfolios, PortfolioListPtr(portfolios));
+    }
+
+    std::atomic_store(&m_configurations, PortfolioConfigurationsPtr(configurations));
+    m_configurationContents = contents;
 }
 
 cxxtools::SerializationInfo SecurityWallet::getSrrSaveData(const std::string& passphrase)
@@ -171,9 +404,9 @@ cxxtools::SerializationInfo SecurityWallet::getSrrSaveData(const std::string& pa
     // get the documents
     cxxtools::SerializationInfo& portfolios = si.addMember("portfolios");
 
-    for (const Portfolio& portfolio : m_portfolios) {
-        log_debug("Save portfolio <%s>", portfolio.getName().c_str());
-        portfolio.serializePortfolioSRR(portfolios.addMember(""), passphrase);
+    for (const PortfolioPtr& portfolio : *std::atomic_load(&m_portfolios)) {
+        log_debug("Save portfolio <%s>", portfolio->getName().c_str());
+        portfolio->serializePortfolioSRR(portfolios.addMember(""), passphrase);
     }
 
 
@@ -209,61 +442,307 @@ void SecurityWallet::restoreSRRData(
 
     const cxxtools::SerializationInfo& portfolios = si.getMember("portfolios");
 
-    std::vector<Portfolio> listPortfolio;
+    auto listPortfolio = std::make_shared<PortfolioList>();
 
     for (size_t index = 0; index < portfolios.memberCount(); index++) {
-        Portfolio portfolio;
-        portfolio.loadPortfolioFromSRR(portfolios.getMember(uint32_t(index)), passphrase, isSamePlatform);
+        auto portfolio = std::make_shared<Portfolio>();
+        portfolio->loadPortfolioFromSRR(
+            portfolios.getMember(uint32_t(index)), passphrase, isSamePlatform, m_loadOptions);
 
-        listPortfolio.push_back(portfolio);
+        listPortfolio->push_back(portfolio);
     }
 
-    m_portfolios = listPortfolio;
+    {
+        // the journal must not receive any modification of the former portfolios
+        std::unique_lock<std::mutex> lock(m_saveLock);
+
+        std::atomic_store(&m_portfolios, PortfolioListPtr(listPortfolio));
+
+        for (const PortfolioPtr& portfolio : *listPortfolio) {
+            m_dirtyPortfolios.insert(portfolio->getName());
+        }
+        m_manifestNeeded = true;
+
+        compact();
+    }
 
-    save();
     reload();
 }
 
-void SecurityWallet::save() const
+void SecurityWallet::checkWritable() const
+{
+    // the database is replaced by a rename => the directory must be writable
+    size_t      separator = m_pathDatabase.rfind('/');
+    std::string directory = (separator == std::string::npos) ? "." : m_pathDatabase.substr(0, separator + 1);
+
+    if (access(directory.c_str(), W_OK) != 0) {
+        throw std::runtime_error("Directory " + directory + " is not writable");
+    }
+}
+
+void SecurityWallet::save()
+{
+    std::unique_lock<std::mutex> lock(m_saveLock);
+    compact();
+}
+
+void SecurityWallet::persistChanges()
+{
+    std::unique_lock<std::mutex> lock(m_saveLock);
+
+    if (m_snapshotNeeded) {
+        // the journal is not reliable anymore => write everything
+        compact();
+        return;
+    }
+
+    std::vector<JournalRecord> records;
+
+    for (const PortfolioPtr& portfolio : *std::atomic_load(&m_portfolios)) {
+        for (const PortfolioChange& change : portfolio->takeChanges()) {
+            records.push_back({++m_journalSequence, portfolio->getName(), change});
+            m_dirtyPortfolios.insert(portfolio->getName());
+        }
+    }
+
+    try {
+        m_journal.append(records);
+    } catch (const std::exception&) {
+        // the modifications are lost for the journal, the next write will be a complete one
+        m_snapshotNeeded = true;
+        throw;
+    }
+
+    if (m_journal.size() > m_storageOptions.journalMaxSize) {
+        log_debug("Journal %s is too big: compact it", m_journal.getPath().c_str());
+        compact();
+    }
+}
+
+void SecurityWallet::syncPendingWrites()
+{
+    std::unique_lock<std::mutex> lock(m_saveLock);
+
+    m_journal.syncPending();
+
+    for (auto& writer : m_portfolioWriters) {
+        writer.second.syncPending();
+    }
+
+    m_snapshotWriter.syncPending();
+}
+
+void SecurityWallet::compact()
+{
+    PortfolioListPtr portfolios = std::atomic_load(&m_portfolios);
+
+    // the modifications are part of the portfolio files written below
+    for (const PortfolioPtr& portfolio : *portfolios) {
+        if (!portfolio->takeChanges().empty()) {
+            m_dirtyPortfolios.insert(portfolio->getName());
+        }
+    }
+
+    m_snapshotNeeded = true;
+
+    // replace the files => a crash keeps the former file of the portfolios not yet written,
+    // their modifications stay in the journal
+    for (const PortfolioPtr& portfolio : *portfolios) {
+        if (m_dirtyPortfolios.count(portfolio->getName()) > 0) {
+            writePortfolioFile(*portfolio);
+        }
+    }
+
+    // written last => it never lists a portfolio without file
+    if (m_manifestNeeded) {
+        writeManifest(*portfolios);
+    }
+
+    // the records until journal_sequence are in the portfolio files => they will be skipped
+    m_journal.reset();
+
+    m_dirtyPortfolios.clear();
+    m_snapshotNeeded = false;
+}
+
+std::string SecurityWallet::getPortfolioPath(const std::string& databasePath, const std::string& portfolioName)
 {
-    // create the file content
+    static const char* HEX = "0123456789abcdef";
+
+    // the name is escaped to be a valid file name
+    std::string path = databasePath + ".portfolio.";
+
+    for (char c : portfolioName) {
+        if (isalnum(static_cast<unsigned char>(c)) || (c == '-') || (c == '_')) {
+            path.push_back(c);
+        } else {
+            path.push_back('%');
+            path.push_back(HEX[(c >> 4) & 0x0F]);
+            path.push_back(HEX[c & 0x0F]);
+        }
+    }
+
+    return path;
+}
+
+PortfolioPtr SecurityWallet::loadPortfolioFile(const std::string& path, uint64_t& journalSequence) const
+{
+    std::ifstream input(path, std::ios::binary);
+
+    if (!input) {
+        throw std::runtime_error("Impossible to open portfolio file " + path);
+    }
+
+    auto portfolio = std::make_shared<Portfolio>();
+
+    // the format is detected => a change of format in the configuration is taken at the next write
     cxxtools::SerializationInfo rootSi;
 
-    rootSi.addMember("version") <<= SECW_VERSION;
-    rootSi.addMember("portfolios") <<= m_portfolios;
+    if (m_storageOptions.lazyLoad && (detectStorageFormat(input) == StorageFormat::BINARY)) {
+        // the documents stay in the mapped file
+        auto storage = std::make_shared<MappedStorage>(path);
+
+        for (const auto& record : storage->getRecords()) {
+            if (record.first != "portfolio") {
+                record.second.decode(rootSi.addMember(record.first));
+            }
+        }
+
+        portfolio->loadPortfolio(storage->getRecord("portfolio"), storage, m_loadOptions);
+    } else {
+        rootSi = readStorage(input);
+        portfolio->loadPortfolio(rootSi.getMember("portfolio"), m_loadOptions);
+    }
+
+    rootSi.getMember("journal_sequence") >>= journalSequence;
+
+    return portfolio;
+}
+
+void SecurityWallet::writePortfolioFile(const Portfolio& portfolio)
+{
+    std::string path = getPortfolioPath(m_pathDatabase, portfolio.getName());
+
+    auto it = m_portfolioWriters.find(path);
+    if (it == m_portfolioWriters.end()) {
+        it = m_portfolioWriters.emplace(path, SnapshotWriter(path, m_storageOptions.fsyncPolicy)).first;
+    }
+
+    it->second.write([this, &portfolio](std::ostream& output) {
+        if (m_storageOptions.format == StorageFormat::JSON) {
+            // streamed: the tree of the whole portfolio is never built
+            JsonWriter writer(output);
+
+            writer.beginObject();
+            writer.key("version").value(uint64_t(SECW_VERSION));
+            writer.key("journal_sequence").value(m_journalSequence);
+            writer.key("portfolio");
+            portfolio.serializePortfolio(writer);
+            writer.endObject();
+            writer.flush();
+        } else {
+            // the index of the binary format needs the size of the records
+            cxxtools::SerializationInfo rootSi;
 
-    // open the file
-    std::ofstream output(m_pathDatabase.c_str());
+            rootSi.addMember("version") <<= SECW_VERSION;
+            rootSi.addMember("journal_sequence") <<= m_journalSequence;
+            rootSi.addMember("portfolio") <<= portfolio;
 
-    cxxtools::JsonSerializer serializer(output);
-    serializer.beautify(true);
-    serializer.serialize(rootSi);
+            writeStorage(output, rootSi, StorageFormat::BINARY);
+        }
+    });
+}
+
+void SecurityWallet::writeManifest(const PortfolioList& portfolios)
+{
+    std::set<std::string> names;
+
+    // always in JSON: it is small and read at each start
+    m_snapshotWriter.write([&portfolios, &names](std::ostream& output) {
+        JsonWriter writer(output);
+
+        writer.beginObject();
+        writer.key("version").value(uint64_t(SECW_VERSION));
+        writer.key("portfolios").beginArray();
+
+        for (const PortfolioPtr& portfolio : portfolios) {
+            writer.beginObject();
+            writer.key("name").value(portfolio->getName());
+            writer.endObject();
+
+            names.insert(portfolio->getName());
+        }
+
+        writer.endArray();
+        writer.endObject();
+        writer.flush();
+    });
+
+    // the files of the portfolios removed from the manifest are not used anymore
+    for (const std::string& name : m_manifestPortfolios) {
+        if (names.count(name) == 0) {
+            std::string path = getPortfolioPath(m_pathDatabase, name);
+
+            if (std::remove(path.c_str()) != 0) {
+                log_warning("Impossible to remove portfolio file %s", path.c_str());
+            }
+
+            m_portfolioWriters.erase(path);
+        }
+    }
+
+    m_manifestPortfolios = names;
+    m_manifestNeeded     = false;
+}
+
+uint64_t SecurityWallet::requestSave()
+{
+    return m_persistence->requestSave();
+}
+
+uint64_t SecurityWallet::getLastSaveTicket() const
+{
+    return m_persistence->getLastTicket();
+}
+
+void SecurityWallet::waitForSave(uint64_t ticket)
+{
+    m_persistence->waitForSave(ticket);
+}
+
+ValidationCache::Statistics SecurityWallet::getValidationStatistics() const
+{
+    return m_validationCache->getStatistics();
 }
 
 std::vector<std::string> SecurityWallet::getPortfolioNames() const
 {
     std::vector<std::string> list;
 
-    for (const auto& item : m_configurations) {
+    for (const auto& item : *std::atomic_load(&m_configurations)) {
         list.push_back(item.first);
     }
 
     return list;
 }
 
-const PortfolioConfiguration& SecurityWallet::getConfiguration(const std::string& portfolioName) const
+PortfolioConfigurationPtr SecurityWallet::getConfiguration(const std::string& portfolioName) const
 {
-    if (m_configurations.count(portfolioName) != 1) {
+    PortfolioConfigurationsPtr configurations = std::atomic_load(&m_configurations);
+
+    auto it = configurations->find(portfolioName);
+    if (it == configurations->end()) {
         throw SecwUnknownPortfolioException(portfolioName);
     }
 
-    return m_configurations.at(portfolioName);
+    // share the ownership of the whole snapshot
+    return PortfolioConfigurationPtr(configurations, &(it->second));
 }
 
-Portfolio& SecurityWallet::getPortfolio(const std::string& name)
+PortfolioPtr SecurityWallet::getPortfolio(const std::string& name) const
 {
-    for (Portfolio& portfolio : m_portfolios) {
-        if (portfolio.getName() == name) {
+    for (const PortfolioPtr& portfolio : *std::atomic_load(&m_portfolios)) {
+        if (portfolio->getName() == name) {
             return portfolio;
         }
     }
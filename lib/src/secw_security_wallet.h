@@ -23,33 +23,121 @@
 
 #include "secw_configuration.h"
 #include "secw_document.h"
+#include "secw_file_watcher.h"
+#include "secw_journal.h"
+#include "secw_persistence_worker.h"
 #include "secw_portfolio.h"
 #include <memory>
+#include <mutex>
+#include <set>
 
 namespace secw {
+
+using PortfolioPtr               = std::shared_ptr<Portfolio>;
+using PortfolioConfigurationPtr  = std::shared_ptr<const PortfolioConfiguration>;
+using PortfolioConfigurations    = std::map<std::string, PortfolioConfiguration>;
+using PortfolioConfigurationsPtr = std::shared_ptr<const PortfolioConfigurations>;
+using PortfolioList              = std::vector<PortfolioPtr>;
+using PortfolioListPtr           = std::shared_ptr<const PortfolioList>;
+
+/// The configurations and the list of portfolios are immutable snapshots, replaced atomically
+/// by reload and restore: readers never block. Modifications must be serialized by the owner.
+///
+/// The database is written in background: after a modification, the owner requests a save and
+/// waits for it according to the durability policy. The modifications are appended to a journal,
+/// which is merged in the database when it becomes too big.
+///
+/// The database path is a manifest listing the portfolios, each one stored in its own file
+/// next to it: only the portfolios modified since the last write are written again.
 class SecurityWallet
 {
 public:
-    explicit SecurityWallet(const std::string& configurationPath, const std::string& databasePath);
-    void                     save() const;
+    explicit SecurityWallet(const std::string& configurationPath, const std::string& databasePath,
+        const StorageOptions& storageOptions = StorageOptions());
+    void                     save();
+    uint64_t                 requestSave();
+    uint64_t                 getLastSaveTicket() const;
+    void                     waitForSave(uint64_t ticket);
     void                     reload();
-    Portfolio&               getPortfolio(const std::string& name);
+
+    /// Parse the configuration file again and replace the configurations which changed.
+    /// The documents are untouched, a new portfolio starts empty.
+    /// @exceptions: The current configuration is kept if the file is not valid.
+    void reloadConfiguration();
+    PortfolioPtr             getPortfolio(const std::string& name) const;
     std::vector<std::string> getPortfolioNames() const;
 
-    const PortfolioConfiguration& getConfiguration(const std::string& portfolioName = "default") const;
+    /// Hits and misses of the validation cache since the start
+    ValidationCache::Statistics getValidationStatistics() const;
+
+    /// The configuration stays valid as long as the pointer is kept, even after a reload
+    PortfolioConfigurationPtr getConfiguration(const std::string& portfolioName = "default") const;
 
     cxxtools::SerializationInfo getSrrSaveData(const std::string& passphrase);
     void                        restoreSRRData(
                                const cxxtools::SerializationInfo& si, const std::string& passphrase, const std::string& version);
 
-    static constexpr const uint8_t SECW_VERSION = 1;
+    /// File of a portfolio, in the directory of the database
+    static std::string getPortfolioPath(const std::string& databasePath, const std::string& portfolioName);
+
+    static constexpr const uint8_t SECW_VERSION = 3;
 
 private:
     std::string m_pathConfiguration;
     std::string m_pathDatabase;
 
-    std::map<std::string, PortfolioConfiguration> m_configurations;
-    std::vector<Portfolio>                        m_portfolios;
+    // only accessed with atomic operations
+    PortfolioConfigurationsPtr m_configurations;
+    PortfolioListPtr           m_portfolios;
+
+    // only one write of the database or of the journal at a time, protect the members below
+    std::mutex m_saveLock;
+
+    StorageOptions m_storageOptions;
+    SnapshotWriter m_snapshotWriter;
+    Journal        m_journal;
+    uint64_t       m_journalSequence = 0;
+    bool           m_snapshotNeeded  = false;
+
+    // one writer per portfolio file, the manifest is written by m_snapshotWriter
+    std::map<std::string, SnapshotWriter> m_portfolioWriters;
+
+    // portfolios with modifications not yet written in their file
+    std::set<std::string> m_dirtyPortfolios;
+    bool                  m_manifestNeeded = false;
+
+    // portfolios listed in the manifest on the disk
+    std::set<std::string> m_manifestPortfolios;
+
+    // documents already validated, saved after each load
+    ValidationCachePtr m_validationCache;
+
+    // threads and cache of the loads of this wallet
+    PortfolioLoadOptions m_loadOptions;
+
+    // serialize the reloads of the configuration, protect m_configurationContents
+    std::mutex m_configurationLock;
+
+    // content of each portfolio configuration, to detect its modifications
+    std::map<std::string, std::string> m_configurationContents;
+
+    // periodic fsync policy: synchronize the writes left pending, a last time after the persistence worker
+    std::unique_ptr<FsyncTimer> m_fsyncTimer;
+
+    // destroyed before the storage => the pending modifications are written before anything is destroyed
+    std::unique_ptr<PersistenceWorker> m_persistence;
+
+    // last member => no reload of the configuration during the destruction
+    std::unique_ptr<FileWatcher> m_configurationWatcher;
+
+    void persistChanges();
+    void syncPendingWrites();
+    void compact();
+    void checkWritable() const;
+
+    PortfolioPtr loadPortfolioFile(const std::string& path, uint64_t& journalSequence) const;
+    void         writePortfolioFile(const Portfolio& portfolio);
+    void         writeManifest(const PortfolioList& portfolios);
 };
 
 } // namespace secw
@@ -36,6 +36,7 @@
 #include <fty_common_messagebus.h>
 #include <fty_log.h>
 #include <fty_srr_dto.h>
+#include <algorithm>
 #include <sstream>
 
 using namespace std::placeholders;
@@ -45,8 +46,9 @@ static constexpr auto FEATURE_SRR_SECW = "security-wallet";
 namespace secw {
 
 SecurityWalletServer::SecurityWalletServer(const std::string& configurationPath, const std::string& databasePath,
-    fty::StreamPublisher& streamPublisher, const std::string& srrEndpoint, const std::string& srrAgentName)
-    : m_activeWallet(configurationPath, databasePath)
+    fty::StreamPublisher& streamPublisher, const std::string& srrEndpoint, const std::string& srrAgentName,
+    const StorageOptions& storageOptions)
+    : m_activeWallet(configurationPath, databasePath, storageOptions)
     , m_streamPublisher(streamPublisher)
     , m_srrProcessor(new dto::srr::SrrQueryProcessor)
 {
@@ -70,10 +72,26 @@ SecurityWalletServer::SecurityWalletServer(const std::string& configurationPath,
     m_supportedCommands[GET_WITH_SECRET_BY_NAME] =
         std::bind(&SecurityWalletServer::handleGetDocumentWithSecretByName, this, _1, _2);
 
+    m_supportedCommands[GET_WITHOUT_SECRET_BY_IDS] =
+        std::bind(&SecurityWalletServer::handleGetDocumentsWithoutSecretByIds, this, _1, _2);
+    m_supportedCommands[GET_WITH_SECRET_BY_IDS] =
+        std::bind(&SecurityWalletServer::handleGetDocumentsWithSecretByIds, this, _1, _2);
+
     m_supportedCommands[CREATE] = std::bind(&SecurityWalletServer::handleCreate, this, _1, _2);
     m_supportedCommands[DELETE] = std::bind(&SecurityWalletServer::handleDelete, this, _1, _2);
     m_supportedCommands[UPDATE] = std::bind(&SecurityWalletServer::handleUpdate, this, _1, _2);
 
+    m_supportedCommands[BULK_CREATE] = std::bind(&SecurityWalletServer::handleBulkCreate, this, _1, _2);
+    m_supportedCommands[BULK_DELETE] = std::bind(&SecurityWalletServer::handleBulkDelete, this, _1, _2);
+    m_supportedCommands[BULK_UPDATE] = std::bind(&SecurityWalletServer::handleBulkUpdate, this, _1, _2);
+
+    m_supportedCommands[GET_CHANGES_SINCE] = std::bind(&SecurityWalletServer::handleGetChangesSince, this, _1, _2);
+
+    // read only commands => executed without lock
+    m_readOnlyCommands = {GET_PORTFOLIO_LIST, GET_CONSUMER_USAGES, GET_PRODUCER_USAGES, GET_LIST_WITH_SECRET,
+        GET_LIST_WITHOUT_SECRET, GET_WITHOUT_SECRET, GET_WITH_SECRET, GET_WITHOUT_SECRET_BY_NAME,
+        GET_WITH_SECRET_BY_NAME, GET_WITHOUT_SECRET_BY_IDS, GET_WITH_SECRET_BY_IDS, GET_CHANGES_SINCE};
+
     log_debug("check SRR <%s> <%s>", srrEndpoint.c_str(), srrAgentName.c_str());
     // add support for SRR here (need to rework after)
     if ((!srrEndpoint.empty()) && (!srrAgentName.empty())) {
@@ -95,14 +113,30 @@ SecurityWalletServer::~SecurityWalletServer()
     std::unique_lock<std::mutex> lock(m_lock);
 }
 
+// reply of the function, or "ERROR" and the exception if it throws
+static std::vector<std::string> replyOrError(const std::function<std::vector<std::string>()>& fct)
+{
+    try {
+        return fct();
+    } catch (SecwException& e) {
+        log_warning("%s", e.what());
+        return {"ERROR", e.toJson()};
+    } catch (std::exception& e) {
+        log_error("Unexpected error: %s", e.what());
+        return {"ERROR", ""};
+    } catch (...) // show must go one => Log and ignore the unknown error
+    {
+        log_error("Unexpected error: unknown");
+        return {"ERROR", ""};
+    }
+}
+
 std::vector<std::string> SecurityWalletServer::handleRequest(
     const Sender& sender, const std::vector<std::string>& payload)
 {
     log_debug("process SRR");
-    // ensure nothing else is on going
-    std::unique_lock<std::mutex> lock(m_lock);
 
-    try {
+    return replyOrError([&]() -> std::vector<std::string> {
         if (payload.size() == 0) {
             throw SecwProtocolErrorException("Command frame is empty");
         }
@@ -114,30 +148,134 @@ std::vector<std::string> SecurityWalletServer::handleRequest(
             return {};
         }
 
-        // check if the command exist in the system
-        if (m_supportedCommands.count(cmd) == 0) {
-            throw SecwUnsupportedCommandException(cmd + " not supported");
+        // Declaring new vector
+        std::vector<std::string> params(payload.begin() + 1, payload.end());
+
+        if (cmd == BATCH) {
+            return handleBatch(sender, params);
         }
 
-        FctCommandHandler cmdHandler = m_supportedCommands[cmd];
+        const FctCommandHandler& cmdHandler = getCommandHandler(cmd);
 
-        // Declaring new vector
-        std::vector<std::string> params(payload.begin() + 1, payload.end());
+        std::vector<std::string> result;
 
-        std::string result = cmdHandler(sender, params);
+        if (m_readOnlyCommands.count(cmd) > 0) {
+            // readers work on snapshots of the wallet => no lock
+            result = cmdHandler(sender, params);
+        } else {
+            uint64_t saveTicket;
+
+            {
+                // writers are serialized, they publish new snapshots
+                std::unique_lock<std::mutex> lock(m_lock);
+                result     = cmdHandler(sender, params);
+                saveTicket = m_activeWallet.getLastSaveTicket();
+            }
+
+            // wait outside of the lock, so the next writers share the same write of the database
+            m_activeWallet.waitForSave(saveTicket);
+        }
+
+        return result;
+    });
+}
+
+const FctCommandHandler& SecurityWalletServer::getCommandHandler(const Command& cmd) const
+{
+    // check if the command exist in the system
+    auto it = m_supportedCommands.find(cmd);
+    if (it == m_supportedCommands.end()) {
+        throw SecwUnsupportedCommandException(cmd + " not supported");
+    }
+
+    return it->second;
+}
+
+// commands of a batch: each one is preceded by its number of frames, the command included
+static std::vector<std::vector<std::string>> splitBatch(const std::vector<std::string>& params)
+{
+    std::vector<std::vector<std::string>> commands;
+
+    size_t index = 0;
+    while (index < params.size()) {
+        const std::string& nbFramesText = params[index];
+
+        if (nbFramesText.empty() || (nbFramesText.size() > 9) ||
+            (nbFramesText.find_first_not_of("0123456789") != std::string::npos)) {
+            throw SecwProtocolErrorException("Bad number of frames <" + nbFramesText + "> in batch");
+        }
+
+        size_t nbFrames = size_t(std::stoul(nbFramesText));
+        index++;
+
+        if ((nbFrames == 0) || (nbFrames > params.size() - index)) {
+            throw SecwProtocolErrorException("Truncated command in batch");
+        }
+
+        commands.emplace_back(params.begin() + long(index), params.begin() + long(index + nbFrames));
+        index += nbFrames;
+    }
+
+    return commands;
+}
+
+std::vector<std::string> SecurityWalletServer::handleBatch(
+    const Sender& sender, const std::vector<std::string>& params)
+{
+    /*
+     * Parameters for this command, repeated for each command of the batch:
+     *
+     * 0. number of frames of the command
+     * 1. command
+     * 2..n. parameters of the command
+     *
+     * The reply of each command, error included, is given in the same way, in the order of the commands.
+     * The commands are independent: a command is executed even if the previous one fails.
+     */
+
+    std::vector<std::vector<std::string>> commands = splitBatch(params);
+
+    bool readOnly = std::all_of(commands.begin(), commands.end(), [this](const std::vector<std::string>& command) {
+        return m_readOnlyCommands.count(command[0]) > 0;
+    });
+
+    log_debug("Do Batch of %zu commands", commands.size());
+
+    auto executeAll = [&]() {
+        std::vector<std::string> result;
+
+        for (const std::vector<std::string>& command : commands) {
+            // a batch in a batch is not supported
+            std::vector<std::string> reply = replyOrError([&]() {
+                std::vector<std::string> commandParams(command.begin() + 1, command.end());
+                return getCommandHandler(command[0])(sender, commandParams);
+            });
+
+            result.push_back(std::to_string(reply.size()));
+            result.insert(result.end(), reply.begin(), reply.end());
+        }
+
+        return result;
+    };
+
+    if (readOnly) {
+        // readers work on snapshots of the wallet => no lock
+        return executeAll();
+    }
+
+    std::vector<std::string> result;
+    uint64_t                 saveTicket;
 
-        return {result};
-    } catch (SecwException& e) {
-        log_warning("%s", e.what());
-        return {"ERROR", e.toJson()};
-    } catch (std::exception& e) {
-        log_error("Unexpected error: %s", e.what());
-        return {"ERROR", ""};
-    } catch (...) // show must go one => Log and ignore the unknown error
     {
-        log_error("Unexpected error: unknown");
-        return {"ERROR", ""};
+        // one lock for the whole batch: the commands are not interleaved with the other writers
+        std::unique_lock<std::mutex> lock(m_lock);
+        result     = executeAll();
+        saveTicket = m_activeWallet.getLastSaveTicket();
     }
+
+    m_activeWallet.waitForSave(saveTicket);
+
+    return result;
 }
 
 static void sendResponse(
@@ -270,7 +408,7 @@ static void sendResponse(
     }
 }
 
-std::string SecurityWalletServer::handleGetListPortfolio(
+std::vector<std::string> SecurityWalletServer::handleGetListPortfolio(
     const Sender& /*sender*/, const std::vector<std::string>& /*params*/)
 {
     /*
@@ -281,10 +419,11 @@ std::string SecurityWalletServer::handleGetListPortfolio(
     cxxtools::SerializationInfo si;
     si <<= m_activeWallet.getPortfolioNames();
 
-    return serialize(si);
+    return {serialize(si)};
 }
 
-std::string SecurityWalletServer::handleGetConsumerUsages(const Sender& sender, const std::vector<std::string>& params)
+std::vector<std::string> SecurityWalletServer::handleGetConsumerUsages(
+    const Sender& sender, const std::vector<std::string>& params)
 {
     /*
      * Parameters for this command:
@@ -299,12 +438,13 @@ std::string SecurityWalletServer::handleGetConsumerUsages(const Sender& sender,
     const std::string& portfolioName = params[0];
 
     cxxtools::SerializationInfo si;
-    si <<= m_activeWallet.getConfiguration(portfolioName).getUsageIdsForConsummer(sender);
+    si <<= m_activeWallet.getConfiguration(portfolioName)->getUsageIdsForConsummer(sender);
 
-    return serialize(si);
+    return {serialize(si)};
 }
 
-std::string SecurityWalletServer::handleGetProducerUsages(const Sender& sender, const std::vector<std::string>& params)
+std::vector<std::string> SecurityWalletServer::handleGetProducerUsages(
+    const Sender& sender, const std::vector<std::string>& params)
 {
     /*
      * Parameters for this command:
@@ -319,13 +459,41 @@ std::string SecurityWalletServer::handleGetProducerUsages(const Sender& sender,
     const std::string& portfolioName = params[0];
 
     cxxtools::SerializationInfo si;
-    si <<= m_activeWallet.getConfiguration(portfolioName).getUsageIdsForProducer(sender);
+    si <<= m_activeWallet.getConfiguration(portfolioName)->getUsageIdsForProducer(sender);
+
+    return {serialize(si)};
+}
+
+
+// the client has the current version of the document: it is not sent again
+static bool isNotModified(const Document& doc, const std::vector<std::string>& params, size_t index)
+{
+    if ((params.size() <= index) || params[index].empty()) {
+        return false;
+    }
+
+    const std::string& version = params[index];
+
+    if ((version.size() > 19) || (version.find_first_not_of("0123456789") != std::string::npos)) {
+        throw SecwBadCommandArgumentException("Bad version <" + version + ">");
+    }
 
-    return serialize(si);
+    // by name, the document may have been replaced by another one with the same version
+    if ((params.size() > index + 1) && (params[index + 1] != doc.getId())) {
+        return false;
+    }
+
+    // version 0: stored by a former version of the wallet, its changes are not counted
+    return (doc.getVersion() != 0) && (doc.getVersion() == std::stoull(version));
 }
 
+// optional projection of the list and get commands, all the parts if it is not given
+static Projection getProjectionParameter(const std::vector<std::string>& params, size_t index)
+{
+    return (params.size() > index) ? Projection::fromString(params[index]) : Projection();
+}
 
-std::string SecurityWalletServer::handleGetDocumentWithSecret(
+std::vector<std::string> SecurityWalletServer::handleGetDocumentWithSecret(
     const Sender& sender, const std::vector<std::string>& params)
 {
     /*
@@ -333,9 +501,11 @@ std::string SecurityWalletServer::handleGetDocumentWithSecret(
      *
      * 0. name of the portfolio
      * 1. document id
+     * 2. Parts of the document, see Projection (optional)
+     * 3. Version of the document known by the client (optional): the reply is NOT_MODIFIED if it is current
      */
 
-    if (params.size() != 2) {
+    if (params.size() < 2) {
         throw SecwBadCommandArgumentException("Command needs at least 2 arguments");
     }
 
@@ -343,26 +513,108 @@ std::string SecurityWalletServer::handleGetDocumentWithSecret(
     const Id&          id            = params[1];
 
     // check global access
-    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName).getUsageIdsForConsummer(sender);
+    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName)->getUsageIdsForConsummer(sender);
 
     if (allowedUsageIds.size() == 0) {
         throw SecwIllegalAccess("You do not have access to this document");
     }
 
-    DocumentPtr doc = m_activeWallet.getPortfolio(portfolioName).getDocument(id);
+    // nullptr if the document has none of the allowed usages: it is not decoded
+    ConstDocumentPtr doc = m_activeWallet.getPortfolio(portfolioName)->getDocument(id, allowedUsageIds);
 
-    if (!hasCommonUsageIds(allowedUsageIds, doc->getUsageIds())) {
+    if (!doc) {
         throw SecwIllegalAccess("You do not have access to this document");
     }
 
+    if (isNotModified(*doc, params, 3)) {
+        return {NOT_MODIFIED};
+    }
+
+    cxxtools::SerializationInfo si;
+
+    doc->fillSerializationInfo(si, getProjectionParameter(params, 2));
+
+    return {serialize(si)};
+}
+
+// documents and status of each id, in one frame
+static std::vector<std::string> serializeDocumentsByIds(const std::vector<ConstDocumentPtr>& documents,
+    const std::vector<DocumentStatus>& statuses, const Projection& projection)
+{
     cxxtools::SerializationInfo si;
 
-    doc->fillSerializationInfoWithSecret(si);
+    cxxtools::SerializationInfo& documentsSi = si.addMember("documents");
+    for (const ConstDocumentPtr& doc : documents) {
+        doc->fillSerializationInfo(documentsSi.addMember(""), projection);
+    }
+    documentsSi.setCategory(cxxtools::SerializationInfo::Array);
+
+    si.addMember("statuses") <<= statuses;
 
-    return serialize(si);
+    return {serialize(si)};
 }
 
-std::string SecurityWalletServer::handleGetDocumentWithoutSecret(
+std::vector<std::string> SecurityWalletServer::handleGetDocumentsWithSecretByIds(
+    const Sender& sender, const std::vector<std::string>& params)
+{
+    /*
+     * Parameters for this command:
+     *
+     * 0. name of the portfolio
+     * 1. Parts of the documents, see Projection (empty for all)
+     * 2..n. documents ids
+     *
+     * The reply gives the documents found and the status of each id, see DocumentsByIds
+     */
+
+    if (params.size() < 2) {
+        throw SecwBadCommandArgumentException("Command needs at least 2 arguments");
+    }
+
+    const std::string& portfolioName = params[0];
+    std::vector<Id>    ids(params.begin() + 2, params.end());
+
+    // without usage, each document is an illegal access
+    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName)->getUsageIdsForConsummer(sender);
+
+    // the documents without the allowed usages are not decoded
+    std::vector<DocumentStatus>   statuses;
+    std::vector<ConstDocumentPtr> documents =
+        m_activeWallet.getPortfolio(portfolioName)->getDocuments(ids, allowedUsageIds, statuses);
+
+    return serializeDocumentsByIds(documents, statuses, getProjectionParameter(params, 1));
+}
+
+std::vector<std::string> SecurityWalletServer::handleGetDocumentsWithoutSecretByIds(
+    const Sender& /*sender*/, const std::vector<std::string>& params)
+{
+    /*
+     * Parameters for this command:
+     *
+     * 0. name of the portfolio
+     * 1. Parts of the documents, see Projection (empty for all)
+     * 2..n. documents ids
+     *
+     * The reply gives the documents found and the status of each id, see DocumentsByIds
+     */
+
+    if (params.size() < 2) {
+        throw SecwBadCommandArgumentException("Command needs at least 2 arguments");
+    }
+
+    const std::string& portfolioName = params[0];
+    std::vector<Id>    ids(params.begin() + 2, params.end());
+
+    std::vector<DocumentStatus>   statuses;
+    std::vector<ConstDocumentPtr> documents = m_activeWallet.getPortfolio(portfolioName)->getDocuments(ids, statuses);
+
+    Projection projection  = getProjectionParameter(params, 1);
+    projection.privatePart = false;
+
+    return serializeDocumentsByIds(documents, statuses, projection);
+}
+
+std::vector<std::string> SecurityWalletServer::handleGetDocumentWithoutSecret(
     const Sender& /*sender*/, const std::vector<std::string>& params)
 {
     /*
@@ -370,25 +622,34 @@ std::string SecurityWalletServer::handleGetDocumentWithoutSecret(
      *
      * 0. name of the portfolio
      * 1. document id
+     * 2. Parts of the document, see Projection (optional)
+     * 3. Version of the document known by the client (optional): the reply is NOT_MODIFIED if it is current
      */
 
-    if (params.size() != 2) {
+    if (params.size() < 2) {
         throw SecwBadCommandArgumentException("Command needs at least 2 arguments");
     }
 
     const std::string& portfolioName = params[0];
     const Id&          id            = params[1];
 
-    DocumentPtr doc = m_activeWallet.getPortfolio(portfolioName).getDocument(id);
+    ConstDocumentPtr doc = m_activeWallet.getPortfolio(portfolioName)->getDocument(id);
+
+    if (isNotModified(*doc, params, 3)) {
+        return {NOT_MODIFIED};
+    }
+
+    Projection projection  = getProjectionParameter(params, 2);
+    projection.privatePart = false;
 
     cxxtools::SerializationInfo si;
 
-    doc->fillSerializationInfoWithoutSecret(si);
+    doc->fillSerializationInfo(si, projection);
 
-    return serialize(si);
+    return {serialize(si)};
 }
 
-std::string SecurityWalletServer::handleGetDocumentWithSecretByName(
+std::vector<std::string> SecurityWalletServer::handleGetDocumentWithSecretByName(
     const Sender& sender, const std::vector<std::string>& params)
 {
     /*
@@ -396,9 +657,12 @@ std::string SecurityWalletServer::handleGetDocumentWithSecretByName(
      *
      * 0. name of the portfolio
      * 1. document name
+     * 2. Parts of the document, see Projection (optional)
+     * 3. Version of the document known by the client (optional): the reply is NOT_MODIFIED if it is current
+     * 4. Id of the document known by the client (needed with the version)
      */
 
-    if (params.size() != 2) {
+    if (params.size() < 2) {
         throw SecwBadCommandArgumentException("Command needs at least 2 arguments");
     }
 
@@ -406,26 +670,32 @@ std::string SecurityWalletServer::handleGetDocumentWithSecretByName(
     const std::string& name          = params[1];
 
     // check global access
-    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName).getUsageIdsForConsummer(sender);
+    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName)->getUsageIdsForConsummer(sender);
 
     if (allowedUsageIds.size() == 0) {
         throw SecwIllegalAccess("You do not have access to this document");
     }
 
-    DocumentPtr doc = m_activeWallet.getPortfolio(portfolioName).getDocumentByName(name);
+    // nullptr if the document has none of the allowed usages: it is not decoded
+    ConstDocumentPtr doc = m_activeWallet.getPortfolio(portfolioName)->getDocumentByName(name, allowedUsageIds);
 
-    if (!hasCommonUsageIds(allowedUsageIds, doc->getUsageIds())) {
+    if (!doc) {
         throw SecwIllegalAccess("You do not have access to this document");
     }
 
+    // without the id, another document with the same name could be taken for the known one
+    if ((params.size() >= 5) && isNotModified(*doc, params, 3)) {
+        return {NOT_MODIFIED};
+    }
+
     cxxtools::SerializationInfo si;
 
-    doc->fillSerializationInfoWithSecret(si);
+    doc->fillSerializationInfo(si, getProjectionParameter(params, 2));
 
-    return serialize(si);
+    return {serialize(si)};
 }
 
-std::string SecurityWalletServer::handleGetDocumentWithoutSecretByName(
+std::vector<std::string> SecurityWalletServer::handleGetDocumentWithoutSecretByName(
     const Sender& /*sender*/, const std::vector<std::string>& params)
 {
     /*
@@ -433,25 +703,52 @@ std::string SecurityWalletServer::handleGetDocumentWithoutSecretByName(
      *
      * 0. name of the portfolio
      * 1. document name
+     * 2. Parts of the document, see Projection (optional)
+     * 3. Version of the document known by the client (optional): the reply is NOT_MODIFIED if it is current
+     * 4. Id of the document known by the client (needed with the version)
      */
 
-    if (params.size() != 2) {
+    if (params.size() < 2) {
         throw SecwBadCommandArgumentException("Command needs at least 2 arguments");
     }
 
     const std::string& portfolioName = params[0];
     const std::string& name          = params[1];
 
-    DocumentPtr doc = m_activeWallet.getPortfolio(portfolioName).getDocumentByName(name);
+    ConstDocumentPtr doc = m_activeWallet.getPortfolio(portfolioName)->getDocumentByName(name);
+
+    // without the id, another document with the same name could be taken for the known one
+    if ((params.size() >= 5) && isNotModified(*doc, params, 3)) {
+        return {NOT_MODIFIED};
+    }
+
+    Projection projection  = getProjectionParameter(params, 2);
+    projection.privatePart = false;
 
     cxxtools::SerializationInfo si;
 
-    doc->fillSerializationInfoWithoutSecret(si);
+    doc->fillSerializationInfo(si, projection);
+
+    return {serialize(si)};
+}
+
+// optional limit of the list commands, 0 if it is not given
+static size_t getLimitParameter(const std::vector<std::string>& params, size_t index)
+{
+    if ((params.size() <= index) || params[index].empty()) {
+        return 0;
+    }
+
+    const std::string& limit = params[index];
+
+    if ((limit.size() > 9) || (limit.find_first_not_of("0123456789") != std::string::npos)) {
+        throw SecwBadCommandArgumentException("Bad limit <" + limit + ">");
+    }
 
-    return serialize(si);
+    return size_t(std::stoul(limit));
 }
 
-std::string SecurityWalletServer::handleGetListDocumentsWithSecret(
+std::vector<std::string> SecurityWalletServer::handleGetListDocumentsWithSecret(
     const Sender& sender, const std::vector<std::string>& params)
 {
     /*
@@ -459,6 +756,12 @@ std::string SecurityWalletServer::handleGetListDocumentsWithSecret(
      *
      * 0. name of the portfolio
      * 1. Usage of documents (optional)
+     * 2. Maximum number of documents of the reply (optional)
+     * 3. Cursor of the page, from the previous reply (optional)
+     * 4. Parts of the documents, see Projection (optional)
+     *
+     * With a limit, the second frame of the reply is the cursor of the next page:
+     * empty for the last page.
      */
 
 
@@ -469,7 +772,7 @@ std::string SecurityWalletServer::handleGetListDocumentsWithSecret(
     const std::string& portfolioName = params[0];
 
     // check global access
-    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName).getUsageIdsForConsummer(sender);
+    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName)->getUsageIdsForConsummer(sender);
 
     if (allowedUsageIds.size() == 0) {
         throw SecwIllegalAccess("You do not have access to this command");
@@ -492,8 +795,9 @@ std::string SecurityWalletServer::handleGetListDocumentsWithSecret(
 
     log_debug("%s", debugInfo.c_str());
 
-    // prepare result
-    std::string result;
+    size_t      limit      = getLimitParameter(params, 2);
+    std::string cursor     = (params.size() >= 4) ? params[3] : "";
+    Projection  projection = getProjectionParameter(params, 4);
 
     // check if the usage is accessible
     if (!usage.empty()) {
@@ -501,15 +805,13 @@ std::string SecurityWalletServer::handleGetListDocumentsWithSecret(
             throw SecwIllegalAccess("You do not have access to this command");
         }
 
-        result = serializeListDocumentsPrivate(portfolioName, {usage});
+        return serializeListDocumentsPrivate(portfolioName, {usage}, limit, cursor, projection);
     } else {
-        result = serializeListDocumentsPrivate(portfolioName, allowedUsageIds);
+        return serializeListDocumentsPrivate(portfolioName, allowedUsageIds, limit, cursor, projection);
     }
-
-    return result;
 }
 
-std::string SecurityWalletServer::handleGetListDocumentsWithoutSecret(
+std::vector<std::string> SecurityWalletServer::handleGetListDocumentsWithoutSecret(
     const Sender& /*sender*/, const std::vector<std::string>& params)
 {
     /*
@@ -517,6 +819,12 @@ std::string SecurityWalletServer::handleGetListDocumentsWithoutSecret(
      *
      * 0. name of the portfolio
      * 1. Usage of documents (optional)
+     * 2. Maximum number of documents of the reply (optional)
+     * 3. Cursor of the page, from the previous reply (optional)
+     * 4. Parts of the documents, see Projection (optional)
+     *
+     * With a limit, the second frame of the reply is the cursor of the next page:
+     * empty for the last page.
      */
 
     if (params.size() < 1) {
@@ -533,7 +841,7 @@ std::string SecurityWalletServer::handleGetListDocumentsWithoutSecret(
         usage = params[1];
     }
 
-    auto usageIDs = m_activeWallet.getConfiguration(portfolioName).getAllUsageId();
+    auto usageIDs = m_activeWallet.getConfiguration(portfolioName)->getAllUsageId();
     if (!usage.empty() && usageIDs.find(usage) == usageIDs.end()) {
         throw SecwUnknownUsageIDException(usage);
     }
@@ -546,22 +854,52 @@ std::string SecurityWalletServer::handleGetListDocumentsWithoutSecret(
 
     log_debug("%s", debugInfo.c_str());
 
-    // prepare request
-    std::string result;
+    size_t      limit      = getLimitParameter(params, 2);
+    std::string cursor     = (params.size() >= 4) ? params[3] : "";
+    Projection  projection = getProjectionParameter(params, 4);
 
     // check if the usage we specify a usage
     if (!usage.empty()) {
-        result = serializeListDocumentsPublic(portfolioName, {usage});
+        return serializeListDocumentsPublic(portfolioName, {usage}, limit, cursor, projection);
     } else {
-        result = serializeListDocumentsPublic(portfolioName, {});
+        return serializeListDocumentsPublic(portfolioName, {}, limit, cursor, projection);
     }
+}
 
-    return result;
+std::vector<std::string> SecurityWalletServer::handleGetChangesSince(
+    const Sender& /*sender*/, const std::vector<std::string>& params)
+{
+    /*
+     * Parameters for this command:
+     *
+     * 0. name of the portfolio
+     * 1. Generation of the previous reply (optional): without it, a full resync is required
+     *
+     * The reply gives the ids of the documents created, updated and deleted since the generation,
+     * or a full resync is required if these changes are no longer known.
+     */
+
+    if (params.size() < 1) {
+        throw SecwBadCommandArgumentException("Command needs at least argument");
+    }
+
+    const std::string& portfolioName = params[0];
+    const std::string  generation    = (params.size() >= 2) ? params[1] : "";
+
+    DocumentChanges changes = m_activeWallet.getPortfolio(portfolioName)->getChangesSince(generation);
+
+    log_debug("Do GetChangesSince on portfolio <%s> since <%s>: %s", portfolioName.c_str(), generation.c_str(),
+        changes.fullResync ? "full resync" : "delta");
+
+    cxxtools::SerializationInfo si;
+    si <<= changes;
+
+    return {serialize(si)};
 }
 
 /* Notifications */
 
-void SecurityWalletServer::sendNotificationOnCreate(const std::string& portfolio, const DocumentPtr newDocument)
+void SecurityWalletServer::sendNotificationOnCreate(const std::string& portfolio, const ConstDocumentPtr& newDocument)
 {
     try {
         cxxtools::SerializationInfo rootSi;
@@ -578,14 +916,20 @@ void SecurityWalletServer::sendNotificationOnCreate(const std::string& portfolio
     }
 }
 
-void SecurityWalletServer::sendNotificationOnDelete(const std::string& portfolio, const DocumentPtr oldDocument)
+void SecurityWalletServer::sendNotificationOnDelete(const std::string& portfolio, const ConstDocumentPtr& oldDocument)
 {
     try {
         cxxtools::SerializationInfo rootSi;
         rootSi.addMember("action") <<= "DELETED";
         rootSi.addMember("portfolio") <<= portfolio;
         rootSi.addMember("new_data");
-        oldDocument->fillSerializationInfoWithoutSecret(rootSi.addMember("old_data"));
+
+        // the header only for a document which could not be decoded
+        if (oldDocument->isPartial()) {
+            oldDocument->fillSerializationInfo(rootSi.addMember("old_data"), Projection::header());
+        } else {
+            oldDocument->fillSerializationInfoWithoutSecret(rootSi.addMember("old_data"));
+        }
 
         m_streamPublisher.publish({serialize(rootSi)});
     } catch (const std::exception& e) {
@@ -596,7 +940,7 @@ void SecurityWalletServer::sendNotificationOnDelete(const std::string& portfolio
 }
 
 void SecurityWalletServer::sendNotificationOnUpdate(
-    const std::string& portfolio, const DocumentPtr oldDocument, const DocumentPtr newDocument)
+    const std::string& portfolio, const ConstDocumentPtr& oldDocument, const ConstDocumentPtr& newDocument)
 {
     try {
         cxxtools::SerializationInfo rootSi;
@@ -616,7 +960,8 @@ void SecurityWalletServer::sendNotificationOnUpdate(
     }
 }
 
-std::string SecurityWalletServer::handleCreate(const Sender& sender, const std::vector<std::string>& params)
+std::vector<std::string> SecurityWalletServer::handleCreate(
+    const Sender& sender, const std::vector<std::string>& params)
 {
     /*
      * Parameters for this command:
@@ -629,195 +974,314 @@ std::string SecurityWalletServer::handleCreate(const Sender& sender, const std::
         throw SecwBadCommandArgumentException("Command need 2 arguments");
     }
 
-    const std::string& portfolioName = params[0];
-    const std::string& document      = params[1];
+    return handleBulkCreate(sender, {params[0], params[1]});
+}
 
-    // check global access
-    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName).getUsageIdsForProducer(sender);
+std::vector<std::string> SecurityWalletServer::handleDelete(
+    const Sender& sender, const std::vector<std::string>& params)
+{
+    /*
+     * Parameters for this command:
+     *
+     * 0. name of the portfolio
+     * 1. id of Document to be delete
+     */
 
-    if (allowedUsageIds.size() == 0) {
-        throw SecwIllegalAccess("You do not have access to this command");
+    if (params.size() < 2) {
+        throw SecwBadCommandArgumentException("Command need 2 arguments");
+    }
+
+    return handleBulkDelete(sender, {params[0], params[1]});
+}
+
+std::vector<std::string> SecurityWalletServer::handleUpdate(
+    const Sender& sender, const std::vector<std::string>& params)
+{
+    /*
+     * Parameters for this command:
+     *
+     * 0. name of the portfolio
+     * 1. Document to be update
+     */
+
+    if (params.size() < 2) {
+        throw SecwBadCommandArgumentException("Command need 2 arguments");
     }
 
-    log_debug("Do Create on portfolio <%s>", portfolioName.c_str());
+    return handleBulkUpdate(sender, {params[0], params[1]});
+}
 
-    Portfolio& portfolio = m_activeWallet.getPortfolio(portfolioName);
+// usages of the producer in the portfolio, throw if it has none
+static std::set<UsageId> getProducerUsageIds(
+    SecurityWallet& wallet, const std::string& portfolioName, const std::string& sender)
+{
+    std::set<UsageId> allowedUsageIds = wallet.getConfiguration(portfolioName)->getUsageIdsForProducer(sender);
 
-    // deserialize
-    const cxxtools::SerializationInfo si(deserialize(document));
-    DocumentPtr                       doc;
-    si >>= doc;
+    if (allowedUsageIds.size() == 0) {
+        throw SecwIllegalAccess("You do not have access to this command");
+    }
 
-    // check if the document is valid
-    doc->validate();
+    return allowedUsageIds;
+}
 
-    // check if we are allow to insert
-    for (const UsageId& usage : doc->getUsageIds()) {
-        // if on document usage do not belong to the user, reject the insert
+static void checkUsageAccess(const std::set<UsageId>& usages, const std::set<UsageId>& allowedUsageIds)
+{
+    for (const UsageId& usage : usages) {
+        // if on document usage do not belong to the user, reject the modification
         if (allowedUsageIds.count(usage) != 1) {
             throw SecwIllegalAccess("You do not have access to usage <" + usage + ">");
         }
     }
+}
 
-    // prepare result => new id
-    std::string newId = portfolio.add(doc);
-
-    m_activeWallet.save();
-
-    sendNotificationOnCreate(portfolioName, portfolio.getDocument(newId));
-    return newId;
+// each id at most once: the documents of a bulk command are checked against the portfolio before any modification
+static void checkUniqueId(std::set<Id>& ids, const Id& id)
+{
+    if (!ids.insert(id).second) {
+        throw SecwBadCommandArgumentException("Document <" + id + "> is given more than once");
+    }
 }
 
-std::string SecurityWalletServer::handleDelete(const Sender& sender, const std::vector<std::string>& params)
+std::vector<std::string> SecurityWalletServer::handleBulkCreate(
+    const Sender& sender, const std::vector<std::string>& params)
 {
     /*
      * Parameters for this command:
      *
      * 0. name of the portfolio
-     * 1. id of Document to be delete
+     * 1..n. Documents to be create
      */
 
     if (params.size() < 2) {
-        throw SecwBadCommandArgumentException("Command need 2 arguments");
+        throw SecwBadCommandArgumentException("Command needs at least 2 arguments");
     }
 
     const std::string& portfolioName = params[0];
-    const std::string& id            = params[1];
 
     // check global access
-    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName).getUsageIdsForProducer(sender);
-
-    if (allowedUsageIds.size() == 0) {
-        throw SecwIllegalAccess("You do not have access to this command");
-    }
+    std::set<UsageId> allowedUsageIds = getProducerUsageIds(m_activeWallet, portfolioName, sender);
 
+    log_debug("Do Create of %zu documents on portfolio <%s>", params.size() - 1, portfolioName.c_str());
 
-    log_debug("Do Delete on portfolio <%s> for id <%s>", portfolioName.c_str(), id.c_str());
+    PortfolioPtr portfolio = m_activeWallet.getPortfolio(portfolioName);
 
-    Portfolio& portfolio = m_activeWallet.getPortfolio(portfolioName);
+    std::vector<DocumentPtr> docs;
+    docs.reserve(params.size() - 1);
 
-    // get the document
-    DocumentPtr doc = portfolio.getDocument(id);
+    for (size_t index = 1; index < params.size(); index++) {
+        // deserialize
+        const cxxtools::SerializationInfo si(deserialize(params[index]));
+        DocumentPtr                       doc;
+        si >>= doc;
 
-    // check if we are allow to remove
-    for (const UsageId& usage : doc->getUsageIds()) {
-        // if on document usage do not belong to the user, reject the insert
-        if (allowedUsageIds.count(usage) != 1) {
-            throw SecwIllegalAccess("You do not have access to usage <" + usage + ">");
+        // some parts are missing: the document would be stored without them
+        if (doc->isPartial()) {
+            throw SecwInvalidDocumentFormatException(DOC_PARTIAL_ENTRY);
         }
+
+        // check if the document is valid
+        doc->validate();
+
+        // check if we are allow to insert
+        checkUsageAccess(doc->getUsageIds(), allowedUsageIds);
+
+        docs.push_back(doc);
     }
 
-    // remove and save
-    portfolio.remove(id);
+    // prepare result => new ids, nothing is added if one of the documents is refused
+    std::vector<std::string> newIds = portfolio->addDocuments(docs);
 
-    m_activeWallet.save();
+    m_activeWallet.requestSave();
 
-    sendNotificationOnDelete(portfolioName, doc);
-    return "OK";
+    for (const Id& newId : newIds) {
+        sendNotificationOnCreate(portfolioName, portfolio->getDocument(newId));
+    }
+
+    return newIds;
 }
 
-std::string SecurityWalletServer::handleUpdate(const Sender& sender, const std::vector<std::string>& params)
+std::vector<std::string> SecurityWalletServer::handleBulkDelete(
+    const Sender& sender, const std::vector<std::string>& params)
 {
     /*
      * Parameters for this command:
      *
      * 0. name of the portfolio
-     * 1. Document to be update
+     * 1..n. ids of Documents to be delete
      */
 
     if (params.size() < 2) {
-        throw SecwBadCommandArgumentException("Command need 2 arguments");
+        throw SecwBadCommandArgumentException("Command needs at least 2 arguments");
     }
 
     const std::string& portfolioName = params[0];
-    const std::string& document      = params[1];
 
     // check global access
-    std::set<UsageId> allowedUsageIds = m_activeWallet.getConfiguration(portfolioName).getUsageIdsForProducer(sender);
+    std::set<UsageId> allowedUsageIds = getProducerUsageIds(m_activeWallet, portfolioName, sender);
 
-    if (allowedUsageIds.size() == 0) {
-        throw SecwIllegalAccess("You do not have access to this command");
+    log_debug("Do Delete of %zu documents on portfolio <%s>", params.size() - 1, portfolioName.c_str());
+
+    PortfolioPtr portfolio = m_activeWallet.getPortfolio(portfolioName);
+
+    std::vector<Id>               ids(params.begin() + 1, params.end());
+    std::vector<ConstDocumentPtr> docs;
+    std::set<Id>                  uniqueIds;
+
+    for (const Id& id : ids) {
+        checkUniqueId(uniqueIds, id);
+
+        // get the document: one which cannot be decoded is deleted with its header only
+        ConstDocumentPtr doc = portfolio->getDocumentOrHeader(id);
+
+        // check if we are allow to remove
+        checkUsageAccess(doc->getUsageIds(), allowedUsageIds);
+
+        docs.push_back(doc);
     }
 
+    // remove and save
+    portfolio->removeDocuments(ids);
 
-    log_debug("Do Update on portfolio <%s>", portfolioName.c_str());
+    m_activeWallet.requestSave();
 
-    Portfolio& portfolio = m_activeWallet.getPortfolio(portfolioName);
+    for (const ConstDocumentPtr& doc : docs) {
+        sendNotificationOnDelete(portfolioName, doc);
+    }
 
-    // de-serialize
-    const cxxtools::SerializationInfo si(deserialize(document));
-    DocumentPtr                       doc;
-    si >>= doc;
+    return {"OK"};
+}
 
-    // std::cerr << "Received data:\n" << doc << std::endl;
+std::vector<std::string> SecurityWalletServer::handleBulkUpdate(
+    const Sender& sender, const std::vector<std::string>& params)
+{
+    /*
+     * Parameters for this command:
+     *
+     * 0. name of the portfolio
+     * 1..n. Documents to be update
+     */
 
-    // recover the existing
-    DocumentPtr copyOfExistingDoc = portfolio.getDocument(doc->getId());
-    // clone the old document for notification purposes
-    DocumentPtr docBeforeUpdate = copyOfExistingDoc->clone();
+    if (params.size() < 2) {
+        throw SecwBadCommandArgumentException("Command needs at least 2 arguments");
+    }
 
-    // std::cerr << "Existing data:\n" << copyOfExistingDoc << std::endl;
+    const std::string& portfolioName = params[0];
 
-    // check that we can do this kind of update
-    std::set<UsageId> diff = differenceBetween2UsagesIdSet(doc->getUsageIds(), copyOfExistingDoc->getUsageIds());
+    // check global access
+    std::set<UsageId> allowedUsageIds = getProducerUsageIds(m_activeWallet, portfolioName, sender);
 
-    for (const UsageId& usage : diff) {
-        // if on document usage do not belong to the user, reject the update
-        if (allowedUsageIds.count(usage) != 1) {
-            throw SecwIllegalAccess("You do not have access to usage <" + usage + ">");
+    log_debug("Do Update of %zu documents on portfolio <%s>", params.size() - 1, portfolioName.c_str());
+
+    PortfolioPtr portfolio = m_activeWallet.getPortfolio(portfolioName);
+
+    std::vector<DocumentPtr>      updatedDocs;
+    std::vector<ConstDocumentPtr> docsBeforeUpdate;
+    std::vector<DocumentPtr>      receivedDocs;
+    std::set<Id>                  uniqueIds;
+
+    for (size_t index = 1; index < params.size(); index++) {
+        // de-serialize
+        const cxxtools::SerializationInfo si(deserialize(params[index]));
+        DocumentPtr                       doc;
+        si >>= doc;
+
+        // some parts are missing: the document would be stored without them
+        if (doc->isPartial()) {
+            throw SecwInvalidDocumentFormatException(DOC_PARTIAL_ENTRY);
         }
-    }
 
-    // override the copy of existing doc
-    si >>= copyOfExistingDoc;
+        checkUniqueId(uniqueIds, doc->getId());
+
+        // recover the existing: the shared version is not modified => kept for notification purposes
+        ConstDocumentPtr docBeforeUpdate = portfolio->getDocument(doc->getId());
+
+        // check that we can do this kind of update
+        checkUsageAccess(differenceBetween2UsagesIdSet(doc->getUsageIds(), docBeforeUpdate->getUsageIds()),
+            allowedUsageIds);
+
+        // override a copy of existing doc
+        DocumentPtr copyOfExistingDoc = docBeforeUpdate->clone();
+        si >>= copyOfExistingDoc;
 
-    // std::cerr << "Updated data:\n" << copyOfExistingDoc << std::endl;
+        copyOfExistingDoc->validate();
 
-    copyOfExistingDoc->validate();
+        updatedDocs.push_back(copyOfExistingDoc);
+        docsBeforeUpdate.push_back(docBeforeUpdate);
+        receivedDocs.push_back(doc);
+    }
 
     // do the update
-    portfolio.update(copyOfExistingDoc);
-    m_activeWallet.save();
+    portfolio->updateDocuments(updatedDocs);
+    m_activeWallet.requestSave();
+
+    for (size_t index = 0; index < receivedDocs.size(); index++) {
+        sendNotificationOnUpdate(portfolioName, docsBeforeUpdate[index], receivedDocs[index]);
+    }
 
-    sendNotificationOnUpdate(portfolioName, docBeforeUpdate, doc);
-    return "OK";
+    return {"OK"};
 }
 
-std::string SecurityWalletServer::serializeListDocumentsPublic(
-    const std::string& portfolioName, const std::set<UsageId>& usages)
+std::vector<std::string> SecurityWalletServer::serializeListDocumentsPublic(
+    const std::string& portfolioName, const std::set<UsageId>& usages, size_t limit, const std::string& cursor,
+    const Projection& projection)
 {
-    Portfolio& portfolio = m_activeWallet.getPortfolio(portfolioName);
+    PortfolioPtr portfolio = m_activeWallet.getPortfolio(portfolioName);
+
+    // get the documents: the filter is done on the headers => the other documents are not decoded
+    DocumentPage page;
+
+    if (limit == 0) {
+        page.documents = usages.empty() ? portfolio->getListDocuments() : portfolio->getListDocuments(usages);
+    } else {
+        page = usages.empty() ? portfolio->getPageDocuments(cursor, limit)
+                              : portfolio->getPageDocuments(usages, cursor, limit);
+    }
 
-    // get the documents
     cxxtools::SerializationInfo si;
 
-    for (const auto& pDoc : portfolio.getListDocuments()) {
-        if ((usages.empty()) || (hasCommonUsageIds(pDoc->getUsageIds(), usages))) {
-            pDoc->fillSerializationInfoWithoutSecret(si.addMember(""));
-        }
+    Projection publicProjection  = projection;
+    publicProjection.privatePart = false;
+
+    for (const auto& pDoc : page.documents) {
+        pDoc->fillSerializationInfo(si.addMember(""), publicProjection);
     }
 
     si.setCategory(cxxtools::SerializationInfo::Array);
 
-    return serialize(si);
+    if (limit == 0) {
+        return {serialize(si)};
+    }
+
+    return {serialize(si), page.nextCursor};
 }
 
-std::string SecurityWalletServer::serializeListDocumentsPrivate(
-    const std::string& portfolioName, const std::set<UsageId>& usages)
+std::vector<std::string> SecurityWalletServer::serializeListDocumentsPrivate(
+    const std::string& portfolioName, const std::set<UsageId>& usages, size_t limit, const std::string& cursor,
+    const Projection& projection)
 {
-    Portfolio& portfolio = m_activeWallet.getPortfolio(portfolioName);
+    PortfolioPtr portfolio = m_activeWallet.getPortfolio(portfolioName);
 
     // get the documents
+    DocumentPage page;
+
+    if (limit == 0) {
+        page.documents = portfolio->getListDocuments(usages);
+    } else {
+        page = portfolio->getPageDocuments(usages, cursor, limit);
+    }
+
     cxxtools::SerializationInfo si;
 
-    for (const auto& pDoc : portfolio.getListDocuments()) {
-        if (hasCommonUsageIds(pDoc->getUsageIds(), usages)) {
-            pDoc->fillSerializationInfoWithSecret(si.addMember(""));
-        }
+    for (const auto& pDoc : page.documents) {
+        pDoc->fillSerializationInfo(si.addMember(""), projection);
     }
 
     si.setCategory(cxxtools::SerializationInfo::Array);
 
-    return serialize(si);
+    if (limit == 0) {
+        return {serialize(si)};
+    }
+
+    return {serialize(si), page.nextCursor};
 }
 } // namespace secw
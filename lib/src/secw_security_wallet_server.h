@@ -26,6 +26,7 @@
 #include <fty_common_sync_server.h>
 #include <functional>
 #include <memory>
+#include <mutex>
 
 namespace dto::srr {
 class SaveQuery;
@@ -47,7 +48,9 @@ namespace secw {
 using Command = std::string;
 using Sender  = std::string;
 
-using FctCommandHandler = std::function<std::string(const Sender&, const std::vector<std::string>&)>;
+/// The handlers return the frames of the reply
+using FctCommandHandler =
+    std::function<std::vector<std::string>(const Sender&, const std::vector<std::string>&)>;
 
 class SecurityWalletServer final : public fty::SyncServer
 {
@@ -55,7 +58,7 @@ class SecurityWalletServer final : public fty::SyncServer
 public:
     explicit SecurityWalletServer(const std::string& configurationPath, const std::string& databasePath,
         fty::StreamPublisher& streamPublisher, const std::string& srrEndpoint = "",
-        const std::string& srrAgentName = "");
+        const std::string& srrAgentName = "", const StorageOptions& storageOptions = StorageOptions());
 
     ~SecurityWalletServer();
 
@@ -65,37 +68,69 @@ private:
     // List of supported commands with a reference to the handler for this command.
     std::map<Command, FctCommandHandler> m_supportedCommands;
 
+    // Commands which do not modify the wallet: they can be executed concurrently with any other command.
+    std::set<Command> m_readOnlyCommands;
+
     SecurityWallet        m_activeWallet;
     fty::StreamPublisher& m_streamPublisher;
 
     // Handler for all supported commands
-    std::string handleGetListDocumentsWithSecret(const Sender& sender, const std::vector<std::string>& params);
-    std::string handleGetListDocumentsWithoutSecret(const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleGetListDocumentsWithSecret(
+        const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleGetListDocumentsWithoutSecret(
+        const Sender& sender, const std::vector<std::string>& params);
+
+    std::vector<std::string> handleGetDocumentWithSecret(const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleGetDocumentWithoutSecret(
+        const Sender& sender, const std::vector<std::string>& params);
+
+    std::vector<std::string> handleGetDocumentWithSecretByName(
+        const Sender& sender, const std::vector<std::string>& params);
+
+    // documents found and status of each id, in one pass on the same snapshot
+    std::vector<std::string> handleGetDocumentsWithoutSecretByIds(
+        const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleGetDocumentsWithSecretByIds(
+        const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleGetDocumentWithoutSecretByName(
+        const Sender& sender, const std::vector<std::string>& params);
+
+    std::vector<std::string> handleGetListPortfolio(const Sender& sender, const std::vector<std::string>& params);
+
+    std::vector<std::string> handleGetChangesSince(const Sender& sender, const std::vector<std::string>& params);
 
-    std::string handleGetDocumentWithSecret(const Sender& sender, const std::vector<std::string>& params);
-    std::string handleGetDocumentWithoutSecret(const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleGetConsumerUsages(const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleGetProducerUsages(const Sender& sender, const std::vector<std::string>& params);
 
-    std::string handleGetDocumentWithSecretByName(const Sender& sender, const std::vector<std::string>& params);
-    std::string handleGetDocumentWithoutSecretByName(const Sender& sender, const std::vector<std::string>& params);
+    // throw if the command is not supported
+    const FctCommandHandler& getCommandHandler(const Command& cmd) const;
 
-    std::string handleGetListPortfolio(const Sender& sender, const std::vector<std::string>& params);
+    // several commands in one request, the writers under one lock
+    std::vector<std::string> handleBatch(const Sender& sender, const std::vector<std::string>& params);
 
-    std::string handleGetConsumerUsages(const Sender& sender, const std::vector<std::string>& params);
-    std::string handleGetProducerUsages(const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleCreate(const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleDelete(const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleUpdate(const Sender& sender, const std::vector<std::string>& params);
 
-    std::string handleCreate(const Sender& sender, const std::vector<std::string>& params);
-    std::string handleDelete(const Sender& sender, const std::vector<std::string>& params);
-    std::string handleUpdate(const Sender& sender, const std::vector<std::string>& params);
+    // all or nothing: the documents are checked before any modification, saved and notified together
+    std::vector<std::string> handleBulkCreate(const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleBulkDelete(const Sender& sender, const std::vector<std::string>& params);
+    std::vector<std::string> handleBulkUpdate(const Sender& sender, const std::vector<std::string>& params);
 
     // Notification
-    void sendNotificationOnCreate(const std::string& portfolio, const DocumentPtr newDocument);
-    void sendNotificationOnDelete(const std::string& portfolio, const DocumentPtr oldDocument);
+    void sendNotificationOnCreate(const std::string& portfolio, const ConstDocumentPtr& newDocument);
+    void sendNotificationOnDelete(const std::string& portfolio, const ConstDocumentPtr& oldDocument);
     void sendNotificationOnUpdate(
-        const std::string& portfolio, const DocumentPtr oldDocument, const DocumentPtr newDocument);
+        const std::string& portfolio, const ConstDocumentPtr& oldDocument, const ConstDocumentPtr& newDocument);
 
 
-    std::string serializeListDocumentsPrivate(const std::string& portfolioName, const std::set<UsageId>& usages);
-    std::string serializeListDocumentsPublic(const std::string& portfolioName, const std::set<UsageId>& usages);
+    // limit 0: all the documents in one frame, else a page of documents and the cursor of the next page
+    std::vector<std::string> serializeListDocumentsPrivate(const std::string& portfolioName,
+        const std::set<UsageId>& usages, size_t limit = 0, const std::string& cursor = "",
+        const Projection& projection = Projection());
+    std::vector<std::string> serializeListDocumentsPublic(const std::string& portfolioName,
+        const std::set<UsageId>& usages, size_t limit = 0, const std::string& cursor = "",
+        const Projection& projection = Projection());
 
     // srr
     void                      handleSRRRequest(messagebus::Message msg);
@@ -113,9 +148,19 @@ public:
     static constexpr const char* GET_WITHOUT_SECRET_BY_NAME = "GET_WITHOUT_SECRET_BY_NAME";
     static constexpr const char* GET_WITH_SECRET            = "GET_WITH_SECRET";
     static constexpr const char* GET_WITH_SECRET_BY_NAME    = "GET_WITH_SECRET_BY_NAME";
+    static constexpr const char* GET_WITHOUT_SECRET_BY_IDS  = "GET_WITHOUT_SECRET_BY_IDS";
+    static constexpr const char* GET_WITH_SECRET_BY_IDS     = "GET_WITH_SECRET_BY_IDS";
     static constexpr const char* CREATE                     = "CREATE";
     static constexpr const char* DELETE                     = "DELETE";
     static constexpr const char* UPDATE                     = "UPDATE";
+    static constexpr const char* GET_CHANGES_SINCE          = "GET_CHANGES_SINCE";
+    static constexpr const char* BULK_CREATE                = "BULK_CREATE";
+    static constexpr const char* BULK_DELETE                = "BULK_DELETE";
+    static constexpr const char* BULK_UPDATE                = "BULK_UPDATE";
+    static constexpr const char* BATCH                      = "BATCH";
+
+    // Reply of the get commands when the client has the current version of the document
+    static constexpr const char* NOT_MODIFIED = "NOT_MODIFIED";
 
     // SRR
     std::unique_ptr<messagebus::MessageBus>      m_msgBus;
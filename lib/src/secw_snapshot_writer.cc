@@ -0,0 +1,261 @@
+/*  =========================================================================
+    secw_snapshot_writer - Crash-safe replacement of a file content
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_snapshot_writer - Crash-safe replacement of a file content
+@discuss
+@end
+*/
+
+#include "secw_snapshot_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <fty_log.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace secw {
+
+using namespace std::chrono;
+
+/*----------------------------------------------------------------------*/
+/*   FsyncPolicy                                                        */
+/*----------------------------------------------------------------------*/
+FsyncPolicy::FsyncPolicy(Mode mode, milliseconds period)
+    : m_mode(mode)
+    , m_period(period)
+{
+}
+
+FsyncPolicy::Mode FsyncPolicy::modeFromString(const std::string& mode)
+{
+    if (mode == "always") {
+        return Mode::ALWAYS;
+    } else if (mode == "periodic") {
+        return Mode::PERIODIC;
+    } else if (mode == "never") {
+        return Mode::NEVER;
+    }
+
+    throw std::runtime_error("Unknown fsync policy '" + mode + "'");
+}
+
+bool FsyncPolicy::isSyncNeeded()
+{
+    switch (m_mode) {
+        case Mode::ALWAYS:
+            return true;
+        case Mode::NEVER:
+            return false;
+        case Mode::PERIODIC:
+            break;
+    }
+
+    steady_clock::time_point now = steady_clock::now();
+
+    if (m_neverSynced || ((now - m_lastSync) >= m_period)) {
+        setSynced();
+        return true;
+    }
+
+    m_pendingSync = true;
+    return false;
+}
+
+void FsyncPolicy::setSynced()
+{
+    m_neverSynced = false;
+    m_pendingSync = false;
+    m_lastSync    = steady_clock::now();
+}
+
+/*----------------------------------------------------------------------*/
+/*   FsyncTimer                                                         */
+/*----------------------------------------------------------------------*/
+FsyncTimer::FsyncTimer(const FsyncPolicy& policy, FctSyncPending syncPending)
+    : m_period(policy.getPeriod())
+    , m_syncPending(syncPending)
+{
+    if (policy.getMode() == FsyncPolicy::Mode::PERIODIC) {
+        m_thread = std::thread(&FsyncTimer::run, this);
+    }
+}
+
+FsyncTimer::~FsyncTimer()
+{
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_stop = true;
+    }
+    m_stopRequested.notify_all();
+
+    m_thread.join();
+}
+
+void FsyncTimer::run()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    while (!m_stop) {
+        m_stopRequested.wait_for(lock, m_period, [this]() {
+            return m_stop;
+        });
+
+        lock.unlock();
+        syncPending();
+        lock.lock();
+    }
+}
+
+void FsyncTimer::syncPending()
+{
+    try {
+        m_syncPending();
+    } catch (const std::exception& e) {
+        log_error("Error while synchronizing the pending writes: %s", e.what());
+    }
+}
+
+/*----------------------------------------------------------------------*/
+/*   WriteStatistics                                                    */
+/*----------------------------------------------------------------------*/
+void WriteStatistics::addWrite(microseconds duration)
+{
+    nbWrites++;
+    lastWrite = duration;
+    maxWrite  = std::max(maxWrite, duration);
+    totalWrite += duration;
+}
+
+void WriteStatistics::addSync(microseconds duration)
+{
+    nbSyncs++;
+    lastSync = duration;
+    maxSync  = std::max(maxSync, duration);
+    totalSync += duration;
+}
+
+/*----------------------------------------------------------------------*/
+/*   SnapshotWriter                                                     */
+/*----------------------------------------------------------------------*/
+SnapshotWriter::SnapshotWriter(const std::string& path, const FsyncPolicy& policy)
+    : m_path(path)
+    , m_policy(policy)
+{
+}
+
+void SnapshotWriter::write(const FctWriteContent& writeContent)
+{
+    // same directory => same file system for the rename
+    const std::string tmpPath = m_path + ".tmp";
+
+    steady_clock::time_point start = steady_clock::now();
+    microseconds             syncDuration(0);
+
+    try {
+        {
+            std::ofstream output(tmpPath, std::ios::binary | std::ios::trunc);
+            writeContent(output);
+            output.flush();
+
+            if (!output) {
+                throw std::runtime_error("Impossible to write file " + tmpPath);
+            }
+        }
+
+        // keep the rights of the former file: it may contain secrets
+        struct stat buffer;
+        if (stat(m_path.c_str(), &buffer) == 0) {
+            chmod(tmpPath.c_str(), buffer.st_mode & 07777);
+        }
+
+        steady_clock::time_point written = steady_clock::now();
+        m_statistics.addWrite(duration_cast<microseconds>(written - start));
+
+        // whatever the policy: the rename must not reach the disk before the content
+        syncPath(tmpPath);
+
+        if (rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+            throw std::runtime_error("Impossible to rename " + tmpPath + ": " + std::string(strerror(errno)));
+        }
+
+        // make the rename itself durable
+        if (m_policy.isSyncNeeded()) {
+            syncPath(getDirectory());
+        }
+
+        syncDuration = duration_cast<microseconds>(steady_clock::now() - written);
+        m_statistics.addSync(syncDuration);
+    } catch (...) {
+        unlink(tmpPath.c_str());
+        throw;
+    }
+
+    log_debug("File %s written in %lld us (fsync %lld us), max %lld us (fsync %lld us)", m_path.c_str(),
+        static_cast<long long>(m_statistics.lastWrite.count()), static_cast<long long>(syncDuration.count()),
+        static_cast<long long>(m_statistics.maxWrite.count()), static_cast<long long>(m_statistics.maxSync.count()));
+}
+
+void SnapshotWriter::syncPending()
+{
+    if (m_policy.hasPendingSync()) {
+        steady_clock::time_point start = steady_clock::now();
+
+        syncPath(getDirectory());
+        m_policy.setSynced();
+
+        m_statistics.addSync(duration_cast<microseconds>(steady_clock::now() - start));
+    }
+}
+
+std::string SnapshotWriter::getDirectory() const
+{
+    size_t separator = m_path.find_last_of('/');
+    return (separator == std::string::npos) ? "." : m_path.substr(0, separator + 1);
+}
+
+void SnapshotWriter::syncPath(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1) {
+        throw std::runtime_error("Impossible to open " + path + ": " + std::string(strerror(errno)));
+    }
+
+    if (fsync(fd) != 0) {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error("Impossible to fsync " + path + ": " + std::string(strerror(err)));
+    }
+
+    close(fd);
+}
+
+} // namespace secw
@@ -0,0 +1,167 @@
+/*  =========================================================================
+    secw_snapshot_writer - Crash-safe replacement of a file content
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace secw {
+
+/// @brief When the written data are forced to the disk (fsync)
+class FsyncPolicy
+{
+public:
+    enum class Mode
+    {
+        ALWAYS,   ///< after each write
+        PERIODIC, ///< at most once per period, the other writes are synchronized at the end of the period
+        NEVER     ///< let the system decide
+    };
+
+    explicit FsyncPolicy(Mode mode = Mode::ALWAYS, std::chrono::milliseconds period = std::chrono::milliseconds(1000));
+
+    /// Parse "always", "periodic" or "never"
+    static Mode modeFromString(const std::string& mode);
+
+    Mode getMode() const
+    {
+        return m_mode;
+    }
+
+    std::chrono::milliseconds getPeriod() const
+    {
+        return m_period;
+    }
+
+    /// Tell if the write done now has to be synchronized, otherwise the write stays pending
+    bool isSyncNeeded();
+
+    /// Tell if a write was not synchronized yet (periodic policy)
+    bool hasPendingSync() const
+    {
+        return m_pendingSync;
+    }
+
+    /// To be called once the pending writes are synchronized
+    void setSynced();
+
+private:
+    Mode                                  m_mode;
+    std::chrono::milliseconds             m_period;
+    std::chrono::steady_clock::time_point m_lastSync;
+    bool                                  m_neverSynced = true;
+    bool                                  m_pendingSync = false;
+};
+
+/// @brief Thread synchronizing the pending writes at the end of each period of a periodic policy
+///
+/// Without it, a write done just after a synchronization would stay in the page cache until
+/// the next write. Nothing is started for the other policies.
+class FsyncTimer
+{
+public:
+    using FctSyncPending = std::function<void()>;
+
+    FsyncTimer(const FsyncPolicy& policy, FctSyncPending syncPending);
+
+    /// Synchronize the pending writes a last time
+    ~FsyncTimer();
+
+    FsyncTimer(const FsyncTimer&) = delete;
+    FsyncTimer& operator=(const FsyncTimer&) = delete;
+
+private:
+    std::chrono::milliseconds m_period;
+    FctSyncPending            m_syncPending;
+
+    std::mutex              m_lock;
+    std::condition_variable m_stopRequested;
+    bool                    m_stop = false;
+    std::thread             m_thread;
+
+    void run();
+    void syncPending();
+};
+
+/// @brief Latency of the writes and of the synchronizations on the disk
+struct WriteStatistics
+{
+    uint64_t                  nbWrites = 0;
+    std::chrono::microseconds lastWrite{0};
+    std::chrono::microseconds maxWrite{0};
+    std::chrono::microseconds totalWrite{0};
+
+    uint64_t                  nbSyncs = 0;
+    std::chrono::microseconds lastSync{0};
+    std::chrono::microseconds maxSync{0};
+    std::chrono::microseconds totalSync{0};
+
+    void addWrite(std::chrono::microseconds duration);
+    void addSync(std::chrono::microseconds duration);
+};
+
+/// @brief Replace the content of a file atomically
+///
+/// The content is written in a temporary file of the same directory, synchronized on the disk,
+/// then renamed over the file: after a crash, the file has either its former or its new content.
+/// The policy tells when the rename is synchronized (fsync of the directory).
+class SnapshotWriter
+{
+public:
+    using FctWriteContent = std::function<void(std::ostream&)>;
+
+    explicit SnapshotWriter(const std::string& path, const FsyncPolicy& policy = FsyncPolicy());
+
+    const std::string& getPath() const
+    {
+        return m_path;
+    }
+
+    /// Write the new content of the file
+    /// @exceptions: In case of error, the file keeps its former content.
+    void write(const FctWriteContent& writeContent);
+
+    /// Synchronize the renames not synchronized by the policy
+    void syncPending();
+
+    const WriteStatistics& getStatistics() const
+    {
+        return m_statistics;
+    }
+
+    /// fsync a file or a directory
+    static void syncPath(const std::string& path);
+
+private:
+    std::string     m_path;
+    FsyncPolicy     m_policy;
+    WriteStatistics m_statistics;
+
+    std::string getDirectory() const;
+};
+
+} // namespace secw
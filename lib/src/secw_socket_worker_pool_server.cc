@@ -0,0 +1,338 @@
+/*  =========================================================================
+    secw_socket_worker_pool_server - Socket server dispatching requests to a pool of workers
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_socket_worker_pool_server - Socket server dispatching requests to a pool of workers
+@discuss
+@end
+*/
+
+#include "secw_socket_worker_pool_server.h"
+#include <cstring>
+#include <fcntl.h>
+#include <fty_common_socket_helpers.h>
+#include <fty_log.h>
+#include <poll.h>
+#include <pwd.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace secw {
+
+SocketWorkerPoolServer::SocketWorkerPoolServer(fty::SyncServer& server, const std::string& socketPath,
+    size_t nbWorkers, size_t maxClient, std::chrono::milliseconds ioTimeout)
+    : m_server(server)
+    , m_socketPath(socketPath)
+    , m_nbWorkers(nbWorkers == 0 ? 1 : nbWorkers)
+    , m_maxClient(maxClient)
+    , m_ioTimeout(ioTimeout)
+{
+    if (pipe2(m_stopPipe, O_CLOEXEC) != 0) {
+        throw std::runtime_error("Impossible to create the stop pipe: " + std::string(strerror(errno)));
+    }
+
+    if (pipe2(m_wakeUpPipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        int err = errno;
+        close(m_stopPipe[0]);
+        close(m_stopPipe[1]);
+        throw std::runtime_error("Impossible to create the wake up pipe: " + std::string(strerror(err)));
+    }
+
+    try {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+
+        if (m_socketPath.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error("Socket path too long: " + m_socketPath);
+        }
+        strncpy(addr.sun_path, m_socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+        m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_socket == -1) {
+            throw std::runtime_error("Impossible to create the socket: " + std::string(strerror(errno)));
+        }
+
+        unlink(m_socketPath.c_str());
+
+        if (bind(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+            throw std::runtime_error(
+                "Impossible to bind the socket " + m_socketPath + ": " + std::string(strerror(errno)));
+        }
+
+        // every local user can connect, the rights are checked using the credentials of the peer
+        chmod(m_socketPath.c_str(), 0777);
+
+        if (listen(m_socket, int(m_maxClient)) == -1) {
+            throw std::runtime_error("Impossible to listen on " + m_socketPath + ": " + std::string(strerror(errno)));
+        }
+    } catch (...) {
+        if (m_socket != -1) {
+            close(m_socket);
+        }
+        close(m_stopPipe[0]);
+        close(m_stopPipe[1]);
+        close(m_wakeUpPipe[0]);
+        close(m_wakeUpPipe[1]);
+        throw;
+    }
+}
+
+SocketWorkerPoolServer::~SocketWorkerPoolServer()
+{
+    for (int clientSocket : m_idleConnections) {
+        close(clientSocket);
+    }
+
+    close(m_socket);
+    unlink(m_socketPath.c_str());
+
+    close(m_stopPipe[0]);
+    close(m_stopPipe[1]);
+    close(m_wakeUpPipe[0]);
+    close(m_wakeUpPipe[1]);
+}
+
+void SocketWorkerPoolServer::requestStop()
+{
+    char stop = 's';
+    if (write(m_stopPipe[1], &stop, 1) != 1) {
+        log_error("Impossible to request the stop of the socket server %s", m_socketPath.c_str());
+    }
+}
+
+void SocketWorkerPoolServer::run()
+{
+    log_debug("Start socket server on %s with %zu workers", m_socketPath.c_str(), m_nbWorkers);
+
+    m_stopWorkers = false;
+
+    std::vector<std::thread> workers;
+    for (size_t index = 0; index < m_nbWorkers; index++) {
+        workers.emplace_back(&SocketWorkerPoolServer::worker, this);
+    }
+
+    std::vector<pollfd> pollFds;
+
+    while (true) {
+        pollFds.clear();
+        pollFds.push_back({m_stopPipe[0], POLLIN, 0});
+        pollFds.push_back({m_wakeUpPipe[0], POLLIN, 0});
+        pollFds.push_back({m_socket, POLLIN, 0});
+
+        for (int clientSocket : m_idleConnections) {
+            pollFds.push_back({clientSocket, POLLIN, 0});
+        }
+
+        if (poll(pollFds.data(), pollFds.size(), -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("Error while waiting on socket %s: %s", m_socketPath.c_str(), strerror(errno));
+            break;
+        }
+
+        if (pollFds[0].revents != 0) {
+            break;
+        }
+
+        if (pollFds[1].revents != 0) {
+            collectDoneConnections();
+        }
+
+        if (pollFds[2].revents & POLLIN) {
+            acceptConnection();
+        }
+
+        // hand the connections with a pending request to the workers
+        for (size_t index = 3; index < pollFds.size(); index++) {
+            if (pollFds[index].revents != 0) {
+                m_idleConnections.erase(pollFds[index].fd);
+                pushJob(pollFds[index].fd);
+            }
+        }
+    }
+
+    // let the workers finish the requests already dispatched
+    {
+        std::unique_lock<std::mutex> lock(m_jobsLock);
+        m_stopWorkers = true;
+    }
+    m_jobsAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    collectDoneConnections();
+
+    log_debug("Socket server on %s stopped", m_socketPath.c_str());
+}
+
+void SocketWorkerPoolServer::acceptConnection()
+{
+    int clientSocket = accept4(m_socket, nullptr, nullptr, SOCK_CLOEXEC);
+
+    if (clientSocket == -1) {
+        log_error("Error while accepting connection on %s: %s", m_socketPath.c_str(), strerror(errno));
+        return;
+    }
+
+    // the connections being served count as well
+    if (m_nbConnections >= m_maxClient) {
+        log_warning("Too many clients on %s: connection refused", m_socketPath.c_str());
+        close(clientSocket);
+        return;
+    }
+
+    // bound the time a worker waits for a client sending or reading slowly
+    timeval timeout;
+    timeout.tv_sec  = time_t(m_ioTimeout.count() / 1000);
+    timeout.tv_usec = suseconds_t((m_ioTimeout.count() % 1000) * 1000);
+
+    if ((setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) ||
+        (setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0)) {
+        log_error("Impossible to set the timeouts of a connection on %s: %s", m_socketPath.c_str(), strerror(errno));
+        close(clientSocket);
+        return;
+    }
+
+    m_nbConnections++;
+    m_idleConnections.insert(clientSocket);
+}
+
+void SocketWorkerPoolServer::closeConnection(int clientSocket)
+{
+    close(clientSocket);
+    m_nbConnections--;
+}
+
+void SocketWorkerPoolServer::pushJob(int clientSocket)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_jobsLock);
+        m_jobs.push_back(clientSocket);
+    }
+    m_jobsAvailable.notify_one();
+}
+
+void SocketWorkerPoolServer::collectDoneConnections()
+{
+    // empty the wake up pipe
+    char buffer[64];
+    while (read(m_wakeUpPipe[0], buffer, sizeof(buffer)) > 0) {
+    }
+
+    std::unique_lock<std::mutex> lock(m_doneLock);
+    m_idleConnections.insert(m_doneConnections.begin(), m_doneConnections.end());
+    m_doneConnections.clear();
+}
+
+void SocketWorkerPoolServer::worker()
+{
+    while (true) {
+        int clientSocket;
+
+        {
+            std::unique_lock<std::mutex> lock(m_jobsLock);
+            m_jobsAvailable.wait(lock, [this]() {
+                return m_stopWorkers || !m_jobs.empty();
+            });
+
+            if (m_jobs.empty()) {
+                // stop requested and nothing left to do
+                return;
+            }
+
+            clientSocket = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        if (!handleClientSocket(clientSocket)) {
+            closeConnection(clientSocket);
+            continue;
+        }
+
+        // give the connection back to the main loop to wait for the next request
+        {
+            std::unique_lock<std::mutex> lock(m_doneLock);
+            m_doneConnections.push_back(clientSocket);
+        }
+
+        char wakeUp = 'w';
+        if (write(m_wakeUpPipe[1], &wakeUp, 1) == -1 && errno != EAGAIN) {
+            log_error("Impossible to wake up the socket server %s: %s", m_socketPath.c_str(), strerror(errno));
+        }
+    }
+}
+
+bool SocketWorkerPoolServer::handleClientSocket(int clientSocket)
+{
+    std::vector<std::string> payload;
+
+    try {
+        payload = fty::Payload::recvFrames(clientSocket);
+    } catch (const std::exception&) {
+        // the client closed the connection, or did not send the rest of the request in time
+        return false;
+    }
+
+    try {
+        std::string sender = getSender(clientSocket);
+
+        std::vector<std::string> reply = m_server.handleRequest(sender, payload);
+
+        fty::Payload::sendFrames(clientSocket, reply);
+    } catch (const std::exception& e) {
+        log_error("Error while handling request on %s: %s", m_socketPath.c_str(), e.what());
+        return false;
+    }
+
+    return true;
+}
+
+std::string SocketWorkerPoolServer::getSender(int clientSocket)
+{
+    ucred     cred;
+    socklen_t credLength = sizeof(cred);
+
+    if (getsockopt(clientSocket, SOL_SOCKET, SO_PEERCRED, &cred, &credLength) == -1) {
+        throw std::runtime_error("Impossible to get the credentials of the client: " + std::string(strerror(errno)));
+    }
+
+    passwd  pwd;
+    passwd* result = nullptr;
+
+    std::vector<char> buffer(4096);
+
+    if ((getpwuid_r(cred.uid, &pwd, buffer.data(), buffer.size(), &result) != 0) || (result == nullptr)) {
+        throw std::runtime_error("Impossible to get the user name of uid " + std::to_string(cred.uid));
+    }
+
+    return std::string(pwd.pw_name);
+}
+
+} // namespace secw
@@ -0,0 +1,110 @@
+/*  =========================================================================
+    secw_socket_worker_pool_server - Socket server dispatching requests to a pool of workers
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fty_common_sync_server.h>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace secw {
+
+/**
+ * \brief Unix socket server executing the requests on a pool of worker threads.
+ *
+ * Drop-in replacement of fty::SocketBasicServer: the main loop (run) accepts the connections
+ * and waits for incoming data, then hands each readable connection to one worker. A connection
+ * is watched again only once the reply of its current request has been sent, so replies are
+ * always received in the order of the requests for a given connection.
+ *
+ * A worker waits at most ioTimeout for the rest of a request or for the client to read its
+ * reply, then closes the connection: a stalled client cannot pin a worker.
+ *
+ * The sync server must support concurrent calls to handleRequest.
+ */
+class SocketWorkerPoolServer
+{
+public:
+    explicit SocketWorkerPoolServer(fty::SyncServer& server, const std::string& socketPath, size_t nbWorkers,
+        size_t maxClient = MAX_CLIENT, std::chrono::milliseconds ioTimeout = IO_TIMEOUT);
+
+    ~SocketWorkerPoolServer();
+
+    SocketWorkerPoolServer(const SocketWorkerPoolServer&) = delete;
+    SocketWorkerPoolServer& operator=(const SocketWorkerPoolServer&) = delete;
+
+    /// Main loop: returns once requestStop() has been called and the pending requests are done.
+    void run();
+
+    /// Can be called from any thread.
+    void requestStop();
+
+    static constexpr size_t                    MAX_CLIENT = 100;
+    static constexpr std::chrono::milliseconds IO_TIMEOUT{5000};
+
+private:
+    fty::SyncServer& m_server;
+    std::string      m_socketPath;
+    size_t           m_nbWorkers;
+    size_t           m_maxClient;
+
+    std::chrono::milliseconds m_ioTimeout;
+
+    int m_socket = -1;
+    int m_stopPipe[2];
+    int m_wakeUpPipe[2];
+
+    // connections waiting for a request, watched by the main loop
+    std::set<int> m_idleConnections;
+
+    // all the open connections: idle, waiting for a worker or being served
+    std::atomic<size_t> m_nbConnections{0};
+
+    // connections with a request to execute => consumed by the workers
+    std::mutex              m_jobsLock;
+    std::condition_variable m_jobsAvailable;
+    std::deque<int>         m_jobs;
+    bool                    m_stopWorkers = false;
+
+    // connections whose request has been executed => given back to the main loop
+    std::mutex       m_doneLock;
+    std::vector<int> m_doneConnections;
+
+    void worker();
+    bool handleClientSocket(int clientSocket);
+
+    void acceptConnection();
+    void closeConnection(int clientSocket);
+
+    void pushJob(int clientSocket);
+    void collectDoneConnections();
+
+    static std::string getSender(int clientSocket);
+};
+
+} // namespace secw
@@ -0,0 +1,728 @@
+/*  =========================================================================
+    secw_storage_format - Encoding of the database and mapping files
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_storage_format - Encoding of the database and mapping files
+@discuss
+@end
+*/
+
+#include "secw_storage_format.h"
+#include "secw_snapshot_writer.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxtools/jsondeserializer.h>
+#include <cxxtools/jsonserializer.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace secw {
+
+namespace {
+
+constexpr const char   BINARY_MAGIC[8]    = {'S', 'E', 'C', 'W', 'B', 'I', 'N', '\0'};
+constexpr const size_t MAX_DEPTH          = 64;
+constexpr const size_t TABLE_ENTRY_SIZE   = 16;
+constexpr const size_t FIRST_READ_VERSION = 1;
+
+enum class ValueType : uint8_t
+{
+    NONE   = 0,
+    BOOL   = 1,
+    INT    = 2,
+    UINT   = 3,
+    FLOAT  = 4,
+    STRING = 5,
+    OBJECT = 6,
+    ARRAY  = 7,
+    TABLE  = 8 ///< array of objects with an offset table
+};
+
+/*----------------------------------------------------------------------*/
+/*   Encoding                                                           */
+/*----------------------------------------------------------------------*/
+void writeFixed(std::string& buffer, uint64_t value, size_t nbBytes)
+{
+    for (size_t index = 0; index < nbBytes; index++) {
+        buffer.push_back(char((value >> (8 * index)) & 0xFF));
+    }
+}
+
+void writeVarint(std::string& buffer, uint64_t value)
+{
+    while (value >= 0x80) {
+        buffer.push_back(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    buffer.push_back(char(value));
+}
+
+void writeString(std::string& buffer, const std::string& value)
+{
+    writeVarint(buffer, value.size());
+    buffer.append(value);
+}
+
+bool isObject(const cxxtools::SerializationInfo& si)
+{
+    return (si.category() != cxxtools::SerializationInfo::Array) &&
+           ((si.category() == cxxtools::SerializationInfo::Object) || (si.memberCount() > 0));
+}
+
+bool isArrayOfObjects(const cxxtools::SerializationInfo& si)
+{
+    if ((si.category() != cxxtools::SerializationInfo::Array) || (si.memberCount() == 0)) {
+        return false;
+    }
+
+    for (const cxxtools::SerializationInfo& member : si) {
+        if (!isObject(member)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// return the size of the header of the value: the bytes before its body for an object, else the whole value
+size_t encodeValue(std::string& buffer, const cxxtools::SerializationInfo& si)
+{
+    const size_t begin      = buffer.size();
+    size_t       headerSize = 0;
+
+    if (isArrayOfObjects(si)) {
+        std::string table;
+        std::string elements;
+
+        for (const cxxtools::SerializationInfo& member : si) {
+            size_t offset = elements.size();
+
+            writeFixed(table, offset, 8);
+            writeFixed(table, encodeValue(elements, member), 8);
+        }
+
+        buffer.push_back(char(ValueType::TABLE));
+        writeVarint(buffer, si.memberCount());
+        writeFixed(buffer, elements.size(), 8);
+        buffer.append(table);
+        buffer.append(elements);
+    } else if (si.category() == cxxtools::SerializationInfo::Array) {
+        buffer.push_back(char(ValueType::ARRAY));
+        writeVarint(buffer, si.memberCount());
+
+        for (const cxxtools::SerializationInfo& member : si) {
+            encodeValue(buffer, member);
+        }
+    } else if (isObject(si)) {
+        buffer.push_back(char(ValueType::OBJECT));
+        writeVarint(buffer, si.memberCount());
+
+        for (const cxxtools::SerializationInfo& member : si) {
+            // the body starts with the first member holding an object
+            if ((headerSize == 0) && isObject(member)) {
+                headerSize = buffer.size() - begin;
+            }
+
+            writeString(buffer, member.name());
+            encodeValue(buffer, member);
+        }
+    } else if (si.isNull()) {
+        buffer.push_back(char(ValueType::NONE));
+    } else if (si.isBool()) {
+        bool value = false;
+        si.getValue(value);
+
+        buffer.push_back(char(ValueType::BOOL));
+        buffer.push_back(char(value ? 1 : 0));
+    } else if (si.isInt()) {
+        long long value = 0;
+        si.getValue(value);
+
+        // zigzag => small negative numbers stay short
+        buffer.push_back(char(ValueType::INT));
+        writeVarint(buffer, (uint64_t(value) << 1) ^ uint64_t(value >> 63));
+    } else if (si.isUInt()) {
+        unsigned long long value = 0;
+        si.getValue(value);
+
+        buffer.push_back(char(ValueType::UINT));
+        writeVarint(buffer, value);
+    } else if (si.isFloat()) {
+        long double value = 0;
+        si.getValue(value);
+
+        // the text keeps the whole precision, whatever the architecture
+        char text[64];
+        snprintf(text, sizeof(text), "%.21Lg", value);
+
+        buffer.push_back(char(ValueType::FLOAT));
+        writeString(buffer, text);
+    } else {
+        std::string value;
+        si.getValue(value);
+
+        buffer.push_back(char(ValueType::STRING));
+        writeString(buffer, value);
+    }
+
+    return (headerSize == 0) ? buffer.size() - begin : headerSize;
+}
+
+void writeBinary(std::ostream& output, const cxxtools::SerializationInfo& si)
+{
+    if ((si.category() != cxxtools::SerializationInfo::Object) && (si.memberCount() == 0)) {
+        throw std::runtime_error("Only an object can be written in binary format");
+    }
+
+    std::string records;
+    std::string header(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+
+    writeFixed(header, STORAGE_BINARY_VERSION, 4);
+    writeFixed(header, si.memberCount(), 4);
+
+    for (const cxxtools::SerializationInfo& member : si) {
+        size_t offset = records.size();
+        encodeValue(records, member);
+
+        writeString(header, member.name());
+        writeFixed(header, offset, 8);
+        writeFixed(header, records.size() - offset, 8);
+    }
+
+    output.write(header.data(), std::streamsize(header.size()));
+    output.write(records.data(), std::streamsize(records.size()));
+}
+
+/*----------------------------------------------------------------------*/
+/*   Decoding                                                           */
+/*----------------------------------------------------------------------*/
+class Reader
+{
+public:
+    Reader(const char* begin, const char* end)
+        : m_current(begin)
+        , m_end(end)
+    {
+    }
+
+    bool atEnd() const
+    {
+        return m_current == m_end;
+    }
+
+    const char* position() const
+    {
+        return m_current;
+    }
+
+    uint8_t readByte()
+    {
+        check(1);
+        return uint8_t(*m_current++);
+    }
+
+    uint64_t readFixed(size_t nbBytes)
+    {
+        check(nbBytes);
+
+        uint64_t value = 0;
+        for (size_t index = 0; index < nbBytes; index++) {
+            value |= uint64_t(uint8_t(*m_current++)) << (8 * index);
+        }
+
+        return value;
+    }
+
+    uint64_t readVarint()
+    {
+        uint64_t value = 0;
+
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = readByte();
+            value |= uint64_t(byte & 0x7F) << shift;
+
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+
+        throw std::runtime_error("Corrupted binary storage: bad integer");
+    }
+
+    std::string readString()
+    {
+        uint64_t size = readVarint();
+        check(size);
+
+        std::string value(m_current, size_t(size));
+        m_current += size;
+        return value;
+    }
+
+    void skipString()
+    {
+        skip(readVarint());
+    }
+
+    void skip(uint64_t size)
+    {
+        check(size);
+        m_current += size;
+    }
+
+    // count and size of the elements of a table, the reader is positioned on the first element
+    std::pair<uint64_t, uint64_t> readTableHeader()
+    {
+        uint64_t count        = readVarint();
+        uint64_t elementsSize = readFixed(8);
+
+        if (count > uint64_t(m_end - m_current) / TABLE_ENTRY_SIZE) {
+            throw std::runtime_error("Corrupted binary storage: truncated content");
+        }
+
+        m_current += count * TABLE_ENTRY_SIZE;
+        check(elementsSize);
+
+        return {count, elementsSize};
+    }
+
+private:
+    const char* m_current;
+    const char* m_end;
+
+    void check(uint64_t size) const
+    {
+        if (uint64_t(m_end - m_current) < size) {
+            throw std::runtime_error("Corrupted binary storage: truncated content");
+        }
+    }
+};
+
+void skipValue(Reader& reader, size_t depth)
+{
+    if (depth > MAX_DEPTH) {
+        throw std::runtime_error("Corrupted binary storage: too many levels");
+    }
+
+    switch (ValueType(reader.readByte())) {
+        case ValueType::NONE:
+            break;
+        case ValueType::BOOL:
+            reader.readByte();
+            break;
+        case ValueType::INT:
+        case ValueType::UINT:
+            reader.readVarint();
+            break;
+        case ValueType::FLOAT:
+        case ValueType::STRING:
+            reader.skipString();
+            break;
+        case ValueType::OBJECT: {
+            uint64_t count = reader.readVarint();
+
+            for (uint64_t index = 0; index < count; index++) {
+                reader.skipString();
+                skipValue(reader, depth + 1);
+            }
+            break;
+        }
+        case ValueType::ARRAY: {
+            uint64_t count = reader.readVarint();
+
+            for (uint64_t index = 0; index < count; index++) {
+                skipValue(reader, depth + 1);
+            }
+            break;
+        }
+        case ValueType::TABLE:
+            reader.skip(reader.readTableHeader().second);
+            break;
+        default:
+            throw std::runtime_error("Corrupted binary storage: unknown type");
+    }
+}
+
+void decodeValue(Reader& reader, cxxtools::SerializationInfo& si, size_t depth)
+{
+    if (depth > MAX_DEPTH) {
+        throw std::runtime_error("Corrupted binary storage: too many levels");
+    }
+
+    switch (ValueType(reader.readByte())) {
+        case ValueType::NONE:
+            si.setNull();
+            break;
+        case ValueType::BOOL:
+            si.setValue(reader.readByte() != 0);
+            break;
+        case ValueType::INT: {
+            uint64_t zigzag = reader.readVarint();
+            si.setValue((long long)((zigzag >> 1) ^ (~(zigzag & 1) + 1)));
+            break;
+        }
+        case ValueType::UINT:
+            si.setValue((unsigned long long)reader.readVarint());
+            break;
+        case ValueType::FLOAT:
+            si.setValue(strtold(reader.readString().c_str(), nullptr));
+            break;
+        case ValueType::STRING:
+            si.setValue(reader.readString());
+            break;
+        case ValueType::OBJECT: {
+            uint64_t count = reader.readVarint();
+
+            for (uint64_t index = 0; index < count; index++) {
+                std::string name = reader.readString();
+                decodeValue(reader, si.addMember(name), depth + 1);
+            }
+
+            si.setCategory(cxxtools::SerializationInfo::Object);
+            break;
+        }
+        case ValueType::ARRAY: {
+            uint64_t count = reader.readVarint();
+
+            for (uint64_t index = 0; index < count; index++) {
+                decodeValue(reader, si.addMember(""), depth + 1);
+            }
+
+            si.setCategory(cxxtools::SerializationInfo::Array);
+            break;
+        }
+        case ValueType::TABLE: {
+            // the elements follow each other: the table is not needed to decode all of them
+            auto        table = reader.readTableHeader();
+            const char* begin = reader.position();
+
+            for (uint64_t index = 0; index < table.first; index++) {
+                decodeValue(reader, si.addMember(""), depth + 1);
+            }
+
+            if (uint64_t(reader.position() - begin) != table.second) {
+                throw std::runtime_error("Corrupted binary storage: bad length of a table");
+            }
+
+            si.setCategory(cxxtools::SerializationInfo::Array);
+            break;
+        }
+        default:
+            throw std::runtime_error("Corrupted binary storage: unknown type");
+    }
+}
+
+// Records of a binary content, with the position given by the index
+BinaryValue::Members readIndex(const char* data, size_t size)
+{
+    Reader reader(data, data + size);
+
+    reader.readFixed(sizeof(BINARY_MAGIC));
+
+    uint32_t version = uint32_t(reader.readFixed(4));
+    if ((version < FIRST_READ_VERSION) || (version > STORAGE_BINARY_VERSION)) {
+        throw std::runtime_error("Binary storage version " + std::to_string(version) + " not supported");
+    }
+
+    struct IndexEntry
+    {
+        std::string name;
+        uint64_t    offset;
+        uint64_t    length;
+    };
+
+    std::vector<IndexEntry> index;
+    uint32_t                nbRecords = uint32_t(reader.readFixed(4));
+
+    for (uint32_t count = 0; count < nbRecords; count++) {
+        IndexEntry entry;
+        entry.name   = reader.readString();
+        entry.offset = reader.readFixed(8);
+        entry.length = reader.readFixed(8);
+        index.push_back(entry);
+    }
+
+    // the offsets start at the end of the index
+    const char* recordsBegin = reader.position();
+    uint64_t    recordsSize  = uint64_t(data + size - recordsBegin);
+
+    BinaryValue::Members records;
+
+    for (const IndexEntry& entry : index) {
+        if ((entry.offset > recordsSize) || (entry.length > recordsSize - entry.offset)) {
+            throw std::runtime_error("Corrupted binary storage: bad index for " + entry.name);
+        }
+
+        records.emplace_back(entry.name, BinaryValue(recordsBegin + entry.offset, size_t(entry.length)));
+    }
+
+    return records;
+}
+
+cxxtools::SerializationInfo readBinary(const std::string& content)
+{
+    cxxtools::SerializationInfo rootSi;
+
+    for (const auto& record : readIndex(content.data(), content.size())) {
+        record.second.decode(rootSi.addMember(record.first));
+    }
+
+    rootSi.setCategory(cxxtools::SerializationInfo::Object);
+    return rootSi;
+}
+
+} // namespace
+
+/*----------------------------------------------------------------------*/
+/*   Public functions                                                   */
+/*----------------------------------------------------------------------*/
+StorageFormat storageFormatFromString(const std::string& format)
+{
+    if (format == "json") {
+        return StorageFormat::JSON;
+    } else if (format == "binary") {
+        return StorageFormat::BINARY;
+    }
+
+    throw std::runtime_error("Unknown storage format '" + format + "'");
+}
+
+StorageFormat detectStorageFormat(std::istream& input)
+{
+    std::streampos start = input.tellg();
+
+    char magic[sizeof(BINARY_MAGIC)];
+    input.read(magic, sizeof(magic));
+
+    bool isBinary = (input.gcount() == sizeof(magic)) && (memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0);
+
+    input.clear();
+    input.seekg(start);
+
+    return isBinary ? StorageFormat::BINARY : StorageFormat::JSON;
+}
+
+cxxtools::SerializationInfo readStorage(std::istream& input)
+{
+    if (detectStorageFormat(input) == StorageFormat::BINARY) {
+        std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        return readBinary(content);
+    }
+
+    cxxtools::SerializationInfo rootSi;
+    cxxtools::JsonDeserializer  deserializer(input);
+    deserializer.deserialize(rootSi);
+
+    return rootSi;
+}
+
+void writeStorage(std::ostream& output, const cxxtools::SerializationInfo& si, StorageFormat format)
+{
+    if (format == StorageFormat::BINARY) {
+        writeBinary(output, si);
+    } else {
+        cxxtools::JsonSerializer serializer(output);
+        serializer.beautify(true);
+        serializer.serialize(si);
+    }
+}
+
+void convertStorageFile(const std::string& inputPath, const std::string& outputPath, StorageFormat format)
+{
+    std::ifstream input(inputPath, std::ios::binary);
+
+    if (!input) {
+        throw std::runtime_error("Impossible to open " + inputPath);
+    }
+
+    cxxtools::SerializationInfo rootSi = readStorage(input);
+
+    SnapshotWriter writer(outputPath);
+    writer.write([&rootSi, format](std::ostream& output) {
+        writeStorage(output, rootSi, format);
+    });
+}
+
+/*----------------------------------------------------------------------*/
+/*   BinaryValue                                                        */
+/*----------------------------------------------------------------------*/
+BinaryValue::BinaryValue(const char* data, size_t size)
+    : m_data(data)
+    , m_size(size)
+    , m_headerSize(size)
+{
+}
+
+BinaryValue::BinaryValue(const char* data, size_t size, size_t headerSize)
+    : m_data(data)
+    , m_size(size)
+    , m_headerSize(headerSize)
+{
+}
+
+BinaryValue::Members BinaryValue::getMembers() const
+{
+    return readMembers(m_size);
+}
+
+BinaryValue::Members BinaryValue::getHeaderMembers() const
+{
+    return readMembers(m_headerSize);
+}
+
+// the members starting in the first maxSize bytes
+BinaryValue::Members BinaryValue::readMembers(size_t maxSize) const
+{
+    Reader reader(m_data, m_data + m_size);
+
+    ValueType type = ValueType(reader.readByte());
+    if ((type != ValueType::OBJECT) && (type != ValueType::ARRAY) && (type != ValueType::TABLE)) {
+        throw std::runtime_error("Binary value has no member");
+    }
+
+    Members members;
+
+    if (type == ValueType::TABLE) {
+        auto        table    = reader.readTableHeader();
+        const char* elements = reader.position();
+        Reader      entries(elements - table.first * TABLE_ENTRY_SIZE, elements);
+
+        members.reserve(size_t(table.first));
+
+        uint64_t next = (table.first > 0) ? entries.readFixed(8) : 0;
+
+        for (uint64_t index = 0; index < table.first; index++) {
+            uint64_t offset     = next;
+            uint64_t headerSize = entries.readFixed(8);
+
+            // an element ends where the next one starts
+            next = (index + 1 < table.first) ? entries.readFixed(8) : table.second;
+
+            if ((offset > next) || (next > table.second) || (headerSize > next - offset)) {
+                throw std::runtime_error("Corrupted binary storage: bad offset table");
+            }
+
+            members.emplace_back("", BinaryValue(elements + offset, size_t(next - offset), size_t(headerSize)));
+        }
+
+        return members;
+    }
+
+    uint64_t count = reader.readVarint();
+
+    for (uint64_t index = 0; (index < count) && (reader.position() < m_data + maxSize); index++) {
+        std::string name;
+        if (type == ValueType::OBJECT) {
+            name = reader.readString();
+        }
+
+        const char* begin = reader.position();
+        skipValue(reader, 1);
+
+        members.emplace_back(name, BinaryValue(begin, size_t(reader.position() - begin)));
+    }
+
+    return members;
+}
+
+void BinaryValue::decode(cxxtools::SerializationInfo& si) const
+{
+    Reader reader(m_data, m_data + m_size);
+    decodeValue(reader, si, 1);
+
+    if (!reader.atEnd()) {
+        throw std::runtime_error("Corrupted binary storage: bad length of a value");
+    }
+}
+
+/*----------------------------------------------------------------------*/
+/*   MappedStorage                                                      */
+/*----------------------------------------------------------------------*/
+MappedStorage::MappedStorage(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::runtime_error("Impossible to open " + path + ": " + strerror(errno));
+    }
+
+    struct stat buffer;
+    if (fstat(fd, &buffer) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("Impossible to get the size of " + path + ": " + strerror(error));
+    }
+
+    m_size = size_t(buffer.st_size);
+
+    if (m_size > 0) {
+        m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    // the mapping stays valid once the file is closed
+    close(fd);
+
+    if ((m_size == 0) || (m_data == MAP_FAILED)) {
+        m_data = nullptr;
+        throw std::runtime_error("Impossible to map " + path);
+    }
+
+    const char* data = static_cast<const char*>(m_data);
+
+    if ((m_size < sizeof(BINARY_MAGIC)) || (memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0)) {
+        munmap(m_data, m_size);
+        throw std::runtime_error(path + " is not in binary format");
+    }
+
+    try {
+        m_records = readIndex(data, m_size);
+    } catch (const std::exception&) {
+        munmap(m_data, m_size);
+        throw;
+    }
+}
+
+MappedStorage::~MappedStorage()
+{
+    munmap(m_data, m_size);
+}
+
+BinaryValue MappedStorage::getRecord(const std::string& name) const
+{
+    for (const auto& record : m_records) {
+        if (record.first == name) {
+            return record.second;
+        }
+    }
+
+    throw std::runtime_error("No record " + name + " in binary storage");
+}
+
+} // namespace secw
@@ -0,0 +1,140 @@
+/*  =========================================================================
+    secw_storage_format - Encoding of the database and mapping files
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cxxtools/serializationinfo.h>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace secw {
+
+/// @brief Encoding of the files written by the storages
+///
+/// The binary format is made of:
+///  - a header: magic "SECWBIN\0", format version (uint32), number of records (uint32)
+///  - an index: for each record, its name, offset and length (uint64) from the end of the index
+///  - the records: one per member of the root object, each one encoding a complete tree
+///
+/// The integers of the header and the index are little endian. In the records, lengths and
+/// integers are varints (zigzag for the signed ones).
+///
+/// An array of objects starts with a table giving, for each object, its offset and the size of its
+/// header: the members before its first member holding an object (its body). The objects and their
+/// headers are reached without reading the rest of the array.
+enum class StorageFormat
+{
+    JSON,  ///< human readable
+    BINARY ///< compact and fast to parse
+};
+
+/// Version of the binary format, the former ones are still read
+static constexpr const uint32_t STORAGE_BINARY_VERSION = 2;
+
+/// Parse "json" or "binary"
+StorageFormat storageFormatFromString(const std::string& format);
+
+/// Detect the format of the content, the stream is positioned back at its beginning
+StorageFormat detectStorageFormat(std::istream& input);
+
+/// Read a content in any format
+cxxtools::SerializationInfo readStorage(std::istream& input);
+
+/// Write the content in the given format. The binary format requires an object as root.
+void writeStorage(std::ostream& output, const cxxtools::SerializationInfo& si, StorageFormat format);
+
+/// Convert a file from any format to the given one, without any loss
+void convertStorageFile(const std::string& inputPath, const std::string& outputPath, StorageFormat format);
+
+/// @brief Encoded value of a binary content, decoded on demand
+///
+/// The value points into the content, which must outlive it.
+class BinaryValue
+{
+public:
+    using Members = std::vector<std::pair<std::string, BinaryValue>>;
+
+    BinaryValue() = default;
+    BinaryValue(const char* data, size_t size);
+
+    /// Value of an array with an offset table, the size of its header is known
+    BinaryValue(const char* data, size_t size, size_t headerSize);
+
+    /// Members of an object (with their names) or of an array, without decoding them
+    Members getMembers() const;
+
+    /// Members of an object before its body, without reading the body.
+    /// All the members when the size of the header is not known.
+    Members getHeaderMembers() const;
+
+    /// Decode the value with all its members
+    void decode(cxxtools::SerializationInfo& si) const;
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    const char* m_data       = nullptr;
+    size_t      m_size       = 0;
+    size_t      m_headerSize = 0;
+
+    Members readMembers(size_t maxSize) const;
+};
+
+/// @brief File in binary format mapped in memory, read only
+///
+/// Only the index is read at creation, the records are paged in when they are decoded.
+/// The file must be replaced by a rename and never modified in place: the mapping keeps
+/// the former content as long as it exists.
+class MappedStorage
+{
+public:
+    /// Throw if the file is not in binary format
+    explicit MappedStorage(const std::string& path);
+    ~MappedStorage();
+
+    MappedStorage(const MappedStorage&) = delete;
+    MappedStorage& operator=(const MappedStorage&) = delete;
+
+    /// Members of the root object, in the order of the file
+    const BinaryValue::Members& getRecords() const
+    {
+        return m_records;
+    }
+
+    /// Throw if the record does not exist
+    BinaryValue getRecord(const std::string& name) const;
+
+private:
+    void*                m_data = nullptr;
+    size_t               m_size = 0;
+    BinaryValue::Members m_records;
+};
+
+using MappedStoragePtr = std::shared_ptr<const MappedStorage>;
+
+} // namespace secw
@@ -0,0 +1,128 @@
+/*  =========================================================================
+    secw_string_pool - Shared storage of the tags and usages
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_string_pool - Shared storage of the tags and usages
+@discuss
+@end
+*/
+
+#include "secw_string_pool.h"
+#include <array>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace secw {
+
+namespace {
+
+struct Table
+{
+    std::mutex lock;
+
+    // the keys are views on the interned strings
+    std::unordered_map<std::string_view, std::weak_ptr<const std::string>> values;
+};
+
+// the values are spread over several tables so the parallel loads do not serialize on one lock
+static constexpr size_t NB_TABLES = 32;
+
+using Tables = std::array<Table, NB_TABLES>;
+
+// never destroyed: static documents may be released after the end of main
+Tables& getTables()
+{
+    static Tables* tables = new Tables();
+    return *tables;
+}
+
+Table& getTable(std::string_view value)
+{
+    return getTables()[std::hash<std::string_view>()(value) % NB_TABLES];
+}
+
+void release(const std::string* value)
+{
+    {
+        Table&                       table = getTable(*value);
+        std::unique_lock<std::mutex> lock(table.lock);
+
+        // the value may have been interned again since its last reference was dropped
+        auto it = table.values.find(*value);
+        if ((it != table.values.end()) && (it->first.data() == value->data())) {
+            table.values.erase(it);
+        }
+    }
+
+    delete value;
+}
+
+} // namespace
+
+InternedString StringPool::intern(std::string_view value)
+{
+    Table&                       table = getTable(value);
+    std::unique_lock<std::mutex> lock(table.lock);
+
+    auto it = table.values.find(value);
+    if (it != table.values.end()) {
+        InternedString existing = it->second.lock();
+        if (existing) {
+            return existing;
+        }
+
+        // being released by another thread
+        table.values.erase(it);
+    }
+
+    InternedString interned(new std::string(value), release);
+    table.values.emplace(std::string_view(*interned), interned);
+
+    return interned;
+}
+
+std::vector<InternedString> StringPool::intern(const std::set<std::string>& values)
+{
+    std::vector<InternedString> interned;
+    interned.reserve(values.size());
+
+    for (const std::string& value : values) {
+        interned.push_back(intern(value));
+    }
+
+    return interned;
+}
+
+size_t StringPool::size()
+{
+    size_t size = 0;
+
+    for (Table& table : getTables()) {
+        std::unique_lock<std::mutex> lock(table.lock);
+        size += table.values.size();
+    }
+
+    return size;
+}
+
+} // namespace secw
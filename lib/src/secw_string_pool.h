@@ -0,0 +1,51 @@
+/*  =========================================================================
+    secw_string_pool - Shared storage of the tags and usages
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "secw_document.h"
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace secw {
+
+/// @brief Table of the tags and usages of the process
+///
+/// The documents share a few distinct tags and usages: each value is stored once and the
+/// documents hold a shared pointer on it. A value leaves the table when the last document
+/// holding it is destroyed, so the table does not grow with the values no longer used.
+/// The table is split in shards locked separately, picked by the hash of the value.
+class StringPool
+{
+public:
+    /// Thread safe
+    static InternedString intern(std::string_view value);
+
+    /// Values sorted by text
+    static std::vector<InternedString> intern(const std::set<std::string>& values);
+
+    /// Number of distinct values in use
+    static size_t size();
+};
+
+} // namespace secw
@@ -0,0 +1,184 @@
+/*  =========================================================================
+    secw_validation_cache - Cache of the documents already validated
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    secw_validation_cache - Cache of the documents already validated
+@discuss
+@end
+*/
+
+#include "secw_validation_cache.h"
+#include "secw_external_certificate.h"
+#include "secw_internal_certificate.h"
+#include "secw_json_writer.h"
+#include "secw_openssl_wrapper.h"
+#include "secw_snapshot_writer.h"
+#include "secw_storage_format.h"
+#include <algorithm>
+#include <fstream>
+#include <fty_log.h>
+#include <sstream>
+
+namespace secw {
+
+// below this number, the digests not used are kept
+static constexpr const size_t MIN_KEPT_DIGESTS = 1024;
+
+void ValidationCache::validate(const Document& document)
+{
+    if (!isCached(document)) {
+        document.validate();
+        return;
+    }
+
+    std::string digest = computeDigest(document);
+
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+
+        if (m_digests.count(digest) > 0) {
+            m_usedDigests.insert(digest);
+            m_hits++;
+            return;
+        }
+    }
+
+    m_misses++;
+
+    // not locked: several documents are validated in parallel
+    document.validate();
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_digests.insert(digest);
+    m_usedDigests.insert(digest);
+    m_modified = true;
+}
+
+void ValidationCache::load(const std::string& path)
+{
+    std::set<std::string> digests;
+
+    try {
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            return;
+        }
+
+        cxxtools::SerializationInfo rootSi = readStorage(input);
+
+        uint32_t rulesVersion = 0;
+        rootSi.getMember("rules_version") >>= rulesVersion;
+
+        if (rulesVersion != VALIDATION_RULES_VERSION) {
+            log_info("Validation cache %s is dropped: rules version %u", path.c_str(), unsigned(rulesVersion));
+            return;
+        }
+
+        rootSi.getMember("digests") >>= digests;
+    } catch (const std::exception& e) {
+        log_warning("Validation cache %s is dropped: %s", path.c_str(), e.what());
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_digests = digests;
+    m_usedDigests.clear();
+    m_modified = false;
+}
+
+void ValidationCache::save(const std::string& path)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    // the digests of the documents removed or modified are dropped from time to time
+    if (m_digests.size() > std::max(2 * m_usedDigests.size(), MIN_KEPT_DIGESTS)) {
+        m_digests  = m_usedDigests;
+        m_modified = true;
+    }
+
+    if (!m_modified) {
+        return;
+    }
+
+    SnapshotWriter writer(path, FsyncPolicy(FsyncPolicy::Mode::NEVER));
+
+    writer.write([this](std::ostream& output) {
+        JsonWriter jsonWriter(output);
+
+        jsonWriter.beginObject();
+        jsonWriter.key("rules_version").value(uint64_t(VALIDATION_RULES_VERSION));
+        jsonWriter.key("digests").beginArray();
+
+        for (const std::string& digest : m_digests) {
+            jsonWriter.value(digest);
+        }
+
+        jsonWriter.endArray();
+        jsonWriter.endObject();
+        jsonWriter.flush();
+    });
+
+    m_modified = false;
+}
+
+ValidationCache::Statistics ValidationCache::getStatistics() const
+{
+    Statistics statistics;
+    statistics.hits   = m_hits;
+    statistics.misses = m_misses;
+    return statistics;
+}
+
+bool ValidationCache::isCached(const Document& document)
+{
+    // the other validations are cheaper than the digest
+    return (document.getType() == INTERNAL_CERTIFICATE_TYPE) || (document.getType() == EXTERNAL_CERTIFICATE_TYPE);
+}
+
+std::string ValidationCache::computeDigest(const Document& document)
+{
+    static const char* HEX = "0123456789abcdef";
+
+    cxxtools::SerializationInfo si;
+    document.fillSerializationInfoWithSecret(si);
+
+    std::ostringstream content;
+    {
+        JsonWriter writer(content);
+        writer.value(si);
+        writer.flush();
+    }
+
+    ByteField digest = generateSHA256Digest(strToBytes(content.str()));
+
+    std::string text;
+    for (Byte byte : digest) {
+        text.push_back(HEX[byte >> 4]);
+        text.push_back(HEX[byte & 0x0F]);
+    }
+
+    clean(digest);
+
+    return text;
+}
+
+} // namespace secw
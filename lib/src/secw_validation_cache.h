@@ -0,0 +1,81 @@
+/*  =========================================================================
+    secw_validation_cache - Cache of the documents already validated
+
+    Copyright (C) 2019 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "secw_document.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace secw {
+
+/// @brief Cache of the documents already validated, persisted between the starts
+///
+/// Only the documents with a costly validation (certificates) are cached: they are
+/// identified by a SHA256 digest of their complete content, so a modified document is
+/// validated again. Only the valid documents are kept.
+class ValidationCache
+{
+public:
+    /// Version of the validation rules: the cache is dropped when it changes.
+    /// Must be incremented when a validate() method becomes stricter.
+    static constexpr const uint32_t VALIDATION_RULES_VERSION = 1;
+
+    struct Statistics
+    {
+        uint64_t hits   = 0;
+        uint64_t misses = 0;
+    };
+
+    /// Validate the document, unless the same content was already validated
+    /// @exceptions: Same as Document::validate. Can be called from several threads.
+    void validate(const Document& document);
+
+    /// Load the digests saved before, a missing or invalid file gives an empty cache
+    void load(const std::string& path);
+
+    /// Write the cache if it was modified since its load.
+    /// The digests not used since the load are dropped when they are the majority.
+    void save(const std::string& path);
+
+    Statistics getStatistics() const;
+
+    /// Tell if the validation of the document is cached
+    static bool isCached(const Document& document);
+
+private:
+    mutable std::mutex    m_lock;
+    std::set<std::string> m_digests;
+    std::set<std::string> m_usedDigests;
+    bool                  m_modified = false;
+
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+
+    static std::string computeDigest(const Document& document);
+};
+
+using ValidationCachePtr = std::shared_ptr<ValidationCache>;
+
+} // namespace secw
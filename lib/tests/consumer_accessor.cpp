@@ -102,6 +102,31 @@ void secwConsumerAccessorTest(fty::SocketSyncClient& syncClient, mlm::MlmStreamC
         }
     }
 
+    // test 3.4 => getDocumentsWithPrivateData with list of id
+    {
+        secw::ConsumerAccessor consumerAccessor(syncClient, streamClient);
+        try {
+            std::vector<secw::Id> ids = {"id_readable", "XXXXX-XXXXXXXXX", "id_notReadable"};
+            secw::DocumentsByIds  docs = consumerAccessor.getDocumentsWithPrivateData("default", ids);
+
+            std::vector<secw::DocumentStatus> statuses = {secw::DocumentStatus::FOUND,
+                secw::DocumentStatus::DOES_NOT_EXIST, secw::DocumentStatus::ILLEGAL_ACCESS};
+
+            if (docs.statuses != statuses)
+                throw std::runtime_error("Bad statuses returned");
+            if ((docs.documents.size() != 1) || (docs.documents.at(0)->getId() != "id_readable"))
+                throw std::runtime_error("Bad documents returned");
+            if (!docs.documents.at(0)->isContainingPrivateData())
+                throw std::runtime_error("Document is not containing private data");
+
+            // same documents as the former list
+            if (consumerAccessor.getListDocumentsWithPrivateData("default", ids).size() != 1)
+                throw std::runtime_error("Bad number of documents returned");
+        } catch (const std::exception& e) {
+            FAIL(e.what());
+        }
+    }
+
     // test 4.1 => getDocumentWithPrivateData
     {
         secw::ConsumerAccessor consumerAccessor(syncClient, streamClient);
@@ -155,4 +180,38 @@ void secwConsumerAccessorTest(fty::SocketSyncClient& syncClient, mlm::MlmStreamC
             FAIL(e.what());
         }
     }
+
+    // test 5.1 => sendBatch
+    {
+        secw::ConsumerAccessor consumerAccessor(syncClient, streamClient);
+        try {
+            secw::ConsumerBatch batch;
+
+            size_t portfolios = batch.addPortfolioList();
+            size_t usages     = batch.addConsumerUsages();
+            size_t byId       = batch.addDocumentWithPrivateData("default", "id_readable");
+            size_t unknown    = batch.addDocumentWithPrivateData("default", "XXXXX-XXXXXXXXX");
+            size_t byName     = batch.addDocumentWithPrivateDataByName("default", "myFirstDoc");
+
+            consumerAccessor.sendBatch(batch);
+
+            if (batch.getPortfolioList(portfolios) != consumerAccessor.getPortfolioList())
+                throw std::runtime_error("Bad portfolio list");
+            if (batch.getConsumerUsages(usages) != consumerAccessor.getConsumerUsages())
+                throw std::runtime_error("Bad consumer usages");
+            if (!batch.getDocumentWithPrivateData(byId)->isContainingPrivateData())
+                throw std::runtime_error("Document is not containing private data");
+            if (batch.getDocumentWithPrivateData(byName)->getName() != "myFirstDoc")
+                throw std::runtime_error("Bad document by name");
+
+            // the error of a request does not affect the other ones
+            try {
+                batch.getDocumentWithPrivateData(unknown);
+                throw std::runtime_error("Document is return");
+            } catch (const secw::SecwDocumentDoNotExistException&) {
+            }
+        } catch (const std::exception& e) {
+            FAIL(e.what());
+        }
+    }
 }
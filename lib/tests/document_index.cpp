@@ -0,0 +1,365 @@
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <secw_user_and_password.h>
+#include <src/secw_document_index.h>
+#include <src/secw_document_order.h>
+#include <src/secw_portfolio.h>
+
+namespace {
+
+secw::DocumentEntryPtr createEntry(const std::string& id, const std::string& name)
+{
+    secw::UserAndPassword doc(name, "user", "password");
+
+    cxxtools::SerializationInfo si;
+    si <<= doc;
+    si.findMember(secw::DOC_ID_ENTRY)->setValue(id);
+
+    secw::DocumentPtr document;
+    si >>= document;
+
+    return std::make_shared<secw::DocumentEntry>(document);
+}
+
+} // namespace
+
+TEST_CASE("Document index")
+{
+    secw::DocumentIndex                           index(secw::DocumentIndex::Key::ID);
+    std::map<std::string, secw::DocumentEntryPtr> reference;
+
+    // random insertions, replacements and removals: long sequences of used slots are shifted back
+    std::mt19937 random(42);
+
+    for (size_t operation = 0; operation < 20000; operation++) {
+        std::string id = std::to_string(random() % 2000);
+
+        if (random() % 3 == 0) {
+            CHECK(index.erase(id) == (reference.erase(id) > 0));
+        } else {
+            secw::DocumentEntryPtr entry = createEntry(id, "name " + id);
+            index.insert(entry);
+            reference[id] = entry;
+        }
+    }
+
+    REQUIRE(index.size() == reference.size());
+
+    size_t nbIterated = 0;
+    for (const secw::DocumentEntryPtr& entry : index) {
+        CHECK(reference.at(entry->getId().toString()) == entry);
+        nbIterated++;
+    }
+    CHECK(nbIterated == reference.size());
+
+    for (size_t id = 0; id < 2000; id++) {
+        const secw::DocumentEntryPtr* entry = index.find(std::to_string(id));
+
+        auto it = reference.find(std::to_string(id));
+        CHECK((entry ? *entry : nullptr) == ((it != reference.end()) ? it->second : nullptr));
+    }
+
+    secw::DocumentIndex byName(secw::DocumentIndex::Key::NAME);
+    byName.insert(createEntry("1", "by name"));
+    CHECK(byName.contains(std::string_view("by name")));
+    CHECK_FALSE(byName.contains("1"));
+}
+
+TEST_CASE("Document index copies")
+{
+    // enough entries for several levels of chunks
+    secw::DocumentIndex original(secw::DocumentIndex::Key::ID);
+    for (size_t id = 0; id < 5000; id++) {
+        original.insert(createEntry(std::to_string(id), "name " + std::to_string(id)));
+    }
+
+    const secw::DocumentEntryPtr first = *original.find("0");
+
+    // the copy shares the entries and is modified on its own
+    secw::DocumentIndex copy = original;
+    CHECK(copy.find("0") == original.find("0"));
+
+    for (size_t id = 0; id < 5000; id += 2) {
+        CHECK(copy.erase(std::to_string(id)));
+    }
+    copy.insert(createEntry("1", "replaced"));
+    copy.insert(createEntry("new", "new"));
+
+    CHECK(copy.size() == 2501);
+    CHECK_FALSE(copy.contains("0"));
+    CHECK((*copy.find("1"))->getName() == "replaced");
+
+    REQUIRE(original.size() == 5000);
+    CHECK(*original.find("0") == first);
+    CHECK((*original.find("1"))->getName() == "name 1");
+    CHECK_FALSE(original.contains("new"));
+
+    // the original is still modified in place after the copy, without changing the copy
+    secw::DocumentIndex second = copy;
+    original.insert(createEntry("new", "in original"));
+    for (size_t id = 1; id < 5000; id += 2) {
+        CHECK(original.erase(std::to_string(id)));
+    }
+
+    CHECK(original.size() == 2501);
+    CHECK((*copy.find("new"))->getName() == "new");
+    CHECK((*second.find("3"))->getName() == "name 3");
+    CHECK(copy.size() == 2501);
+
+    size_t nbIterated = 0;
+    for (const secw::DocumentEntryPtr& entry : copy) {
+        CHECK(copy.find(entry->getId()) != nullptr);
+        nbIterated++;
+    }
+    CHECK(nbIterated == copy.size());
+}
+
+TEST_CASE("Document order")
+{
+    secw::DocumentOrder                           order;
+    std::map<std::string, secw::DocumentEntryPtr> reference;
+
+    // enough entries to split and merge the branches
+    std::mt19937 random(42);
+
+    for (size_t operation = 0; operation < 50000; operation++) {
+        std::string id = std::to_string(random() % 10000);
+
+        if (random() % 3 == 0) {
+            CHECK(order.erase(secw::DocumentId(id)) == (reference.erase(id) > 0));
+        } else {
+            secw::DocumentEntryPtr entry = createEntry(id, "name " + id);
+            order.insert(entry);
+            reference[id] = entry;
+        }
+    }
+
+    REQUIRE(order.size() == reference.size());
+
+    // the ids are ordered as their text
+    std::vector<secw::DocumentEntryPtr> expected;
+    for (const auto& it : reference) {
+        expected.push_back(it.second);
+    }
+
+    auto listEntries = [](const secw::DocumentOrder& ordered) {
+        std::vector<secw::DocumentEntryPtr> entries;
+        for (const secw::DocumentEntryPtr& entry : ordered) {
+            entries.push_back(entry);
+        }
+        return entries;
+    };
+    CHECK(listEntries(order) == expected);
+
+    // seek after an id, present or not
+    for (const std::string& id : {"", "0", "5000", "50000", "9999", "a"}) {
+        auto it     = reference.upper_bound(id);
+        auto sought = order.upperBound(secw::DocumentId(id));
+
+        if (it == reference.end()) {
+            CHECK(sought == order.end());
+        } else {
+            REQUIRE(sought != order.end());
+            CHECK(*sought == it->second);
+        }
+    }
+
+    // the copy is modified on its own
+    secw::DocumentOrder copy = order;
+    while (!copy.empty()) {
+        CHECK(copy.erase((*copy.begin())->getId()));
+    }
+    CHECK(copy.begin() == copy.end());
+    CHECK(order.size() == reference.size());
+    CHECK(listEntries(order) == expected);
+}
+
+TEST_CASE("Document id")
+{
+    // the text of an id is kept whatever its form
+    for (const std::string& text : {"c2bb7ab4-1a35-4a8f-9b4e-0123456789ab", "C2BB7AB4-1A35-4A8F-9B4E-0123456789AB",
+             "c2bb7ab4-1a35-4a8f-9b4e-0123456789a", "c2bb7ab4+1a35-4a8f-9b4e-0123456789ab", "42", ""}) {
+        CHECK(secw::DocumentId(text).toString() == text);
+        CHECK(secw::DocumentId(text) == secw::DocumentId(text));
+        CHECK(secw::DocumentId(text).hash() == secw::DocumentId(text).hash());
+    }
+
+    CHECK(secw::DocumentId("").empty());
+    CHECK(secw::DocumentId() == secw::DocumentId(""));
+
+    secw::DocumentId compact("c2bb7ab4-1a35-4a8f-9b4e-0123456789ab");
+    CHECK(sizeof(compact) == 16);
+    CHECK(compact.isCompact());
+    CHECK(compact != secw::DocumentId("c2bb7ab4-1a35-4a8f-9b4e-0123456789ac"));
+    CHECK(compact != secw::DocumentId("C2BB7AB4-1A35-4A8F-9B4E-0123456789AB"));
+
+    // only the variant 1 is compact, the other UUIDs are kept as text
+    secw::DocumentId other("c2bb7ab4-1a35-4a8f-1b4e-0123456789ab");
+    CHECK_FALSE(other.isCompact());
+    CHECK(other.getText() == "c2bb7ab4-1a35-4a8f-1b4e-0123456789ab");
+
+    // the copies share the text
+    secw::DocumentId copy = other;
+    CHECK(copy.getText().data() == other.getText().data());
+    CHECK(copy == other);
+
+    // compact ids and texts are ordered by text
+    CHECK(other < compact);
+    CHECK(compact < secw::DocumentId("c2bb7ab4-1a35-4a8f-9b4e-0123456789ab0"));
+    CHECK_FALSE(secw::DocumentId("c2bb7ab4-1a35-4a8f-9b4e-0123456789ab0") < compact);
+    CHECK(secw::DocumentId("42") < compact);
+
+    std::set<std::string> generated;
+    for (size_t index = 0; index < 1000; index++) {
+        std::string text = secw::DocumentId::generate().toString();
+
+        CHECK(text.size() == 36);
+        CHECK(text[14] == '4');
+        CHECK(std::string("89ab").find(text[19]) != std::string::npos);
+        CHECK(secw::DocumentId(text).toString() == text);
+
+        generated.insert(text);
+    }
+    CHECK(generated.size() == 1000);
+
+    // legacy and compact ids in the same index
+    secw::DocumentIndex index(secw::DocumentIndex::Key::ID);
+    index.insert(createEntry("42", "legacy"));
+    index.insert(createEntry("c2bb7ab4-1a35-4a8f-9b4e-0123456789ab", "compact"));
+
+    CHECK(index.contains("42"));
+    CHECK(index.contains(compact));
+    CHECK(index.contains("c2bb7ab4-1a35-4a8f-9b4e-0123456789ab"));
+    CHECK_FALSE(index.contains("C2BB7AB4-1A35-4A8F-9B4E-0123456789AB"));
+    CHECK_FALSE(index.contains(""));
+}
+
+TEST_CASE("Portfolio usage index")
+{
+    secw::Portfolio portfolio("default");
+
+    auto addDocument = [&](const std::string& name, const std::set<secw::UsageId>& usages) {
+        auto doc = std::make_shared<secw::UserAndPassword>(name, "user", "password");
+        for (const secw::UsageId& usage : usages) {
+            doc->addUsage(usage);
+        }
+        return portfolio.add(doc);
+    };
+
+    auto listNames = [&](const std::set<secw::UsageId>& usages) {
+        std::set<std::string> names;
+        for (const secw::ConstDocumentPtr& doc : portfolio.getListDocuments(usages)) {
+            CHECK(names.insert(doc->getName()).second);
+        }
+        return names;
+    };
+
+    secw::Id first  = addDocument("first", {"a", "b"});
+    secw::Id second = addDocument("second", {"b"});
+    addDocument("third", {"c"});
+
+    CHECK(listNames({"a"}) == std::set<std::string>{"first"});
+    CHECK(listNames({"a", "b"}) == std::set<std::string>{"first", "second"});
+    CHECK(listNames({"unknown"}).empty());
+
+    // the document is not returned without a common usage
+    CHECK(portfolio.getDocument(first, {"c"}) == nullptr);
+    REQUIRE(portfolio.getDocument(first, {"c", "a"}) != nullptr);
+    CHECK(portfolio.getDocumentByName("second", {"b"})->getId() == second);
+    CHECK_THROWS(portfolio.getDocument("missing", {"a"}));
+
+    // the postings follow the modifications
+    secw::DocumentPtr doc = portfolio.getDocument(second)->clone();
+    doc->removeUsage("b");
+    doc->addUsage("c");
+    portfolio.update(doc);
+    portfolio.remove(first);
+
+    CHECK(listNames({"a", "b"}).empty());
+    CHECK(listNames({"c"}) == std::set<std::string>{"second", "third"});
+    CHECK(portfolio.getDocumentByName("second", {"b"}) == nullptr);
+
+    // the usages beyond the bits of the mask are compared by name
+    for (size_t index = 0; index < 80; index++) {
+        addDocument("usage " + std::to_string(index), {"usage " + std::to_string(index)});
+    }
+
+    CHECK(listNames({"usage 70"}) == std::set<std::string>{"usage 70"});
+    CHECK(listNames({"usage 70", "usage 75", "c"}) == std::set<std::string>{"usage 70", "usage 75", "second", "third"});
+    CHECK(portfolio.getDocumentByName("usage 70", {"usage 71"}) == nullptr);
+    CHECK(portfolio.getDocumentByName("usage 70", {"usage 70"}) != nullptr);
+}
+
+TEST_CASE("Document index benchmark", "[.benchmark]")
+{
+    using namespace std::chrono;
+
+    printf("documents  index  insert (ns)  lookup (ns)\n");
+
+    for (size_t nbDocuments : {100, 1000, 10000, 100000}) {
+        std::vector<secw::DocumentEntryPtr> entries;
+        for (size_t index = 0; index < nbDocuments; index++) {
+            entries.push_back(createEntry("c2bb7ab4-1a35-4a8f-9b4e-" + std::to_string(100000000000 + index),
+                "document " + std::to_string(index)));
+        }
+
+        // the lookups are done in another order than the insertions
+        std::vector<std::string>      keys;
+        std::vector<secw::DocumentId> ids;
+        for (size_t index = 0; index < nbDocuments; index++) {
+            ids.push_back(entries[(index * 7919) % nbDocuments]->getId());
+            keys.push_back(ids.back().toString());
+        }
+
+        static const size_t NB_LOOKUPS = 1000000;
+
+        // former index
+        {
+            auto start = steady_clock::now();
+
+            std::map<secw::Id, secw::DocumentEntryPtr> map;
+            for (const secw::DocumentEntryPtr& entry : entries) {
+                map[entry->getId().toString()] = entry;
+            }
+
+            auto insertDuration = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+            size_t found = 0;
+            start        = steady_clock::now();
+            for (size_t lookup = 0; lookup < NB_LOOKUPS; lookup++) {
+                found += map.count(keys[lookup % nbDocuments]);
+            }
+            auto lookupDuration = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+            REQUIRE(found == NB_LOOKUPS);
+            printf("%9zu  %-5s  %11.1f  %11.1f\n", nbDocuments, "map", double(insertDuration.count()) / nbDocuments,
+                double(lookupDuration.count()) / NB_LOOKUPS);
+        }
+
+        {
+            auto start = steady_clock::now();
+
+            secw::DocumentIndex index(secw::DocumentIndex::Key::ID);
+            for (const secw::DocumentEntryPtr& entry : entries) {
+                index.insert(entry);
+            }
+
+            auto insertDuration = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+            size_t found = 0;
+            start        = steady_clock::now();
+            for (size_t lookup = 0; lookup < NB_LOOKUPS; lookup++) {
+                found += index.contains(ids[lookup % nbDocuments]) ? 1 : 0;
+            }
+            auto lookupDuration = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+            REQUIRE(found == NB_LOOKUPS);
+            printf("%9zu  %-5s  %11.1f  %11.1f\n", nbDocuments, "hash", double(insertDuration.count()) / nbDocuments,
+                double(lookupDuration.count()) / NB_LOOKUPS);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#include <catch2/catch.hpp>
+#include <fstream>
+#include <src/secw_helpers.h>
+#include <src/secw_json_writer.h>
+#include <src/secw_storage_format.h>
+#include <sstream>
+
+TEST_CASE("JSON writer")
+{
+    SECTION("Compact output with separators and escaping")
+    {
+        std::ostringstream output;
+        {
+            secw::JsonWriter writer(output);
+
+            writer.beginObject();
+            writer.key("name").value("with \"quotes\", \\ and \n\x01");
+            writer.key("count").value(uint64_t(3));
+            writer.key("offset").value(int64_t(-2));
+            writer.key("list").beginArray().value(true).null().beginObject().endObject().endArray();
+            writer.endObject();
+            writer.flush();
+        }
+
+        CHECK(output.str() ==
+              "{\"name\":\"with \\\"quotes\\\", \\\\ and \\n\\u0001\",\"count\":3,\"offset\":-2,"
+              "\"list\":[true,null,{}]}");
+    }
+
+    SECTION("The content is read back by the JSON deserializer")
+    {
+        std::ifstream               input("tests/selftest-ro/data.json", std::ios::binary);
+        cxxtools::SerializationInfo rootSi = secw::readStorage(input);
+
+        std::ostringstream output;
+        {
+            secw::JsonWriter writer(output);
+            writer.value(rootSi);
+            writer.flush();
+        }
+
+        CHECK(secw::serialize(secw::deserialize(output.str())) == secw::serialize(rootSi));
+    }
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <src/secw_persistence_worker.h>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Persistence worker - sync durability")
+{
+    std::atomic<int> nbSaves{0};
+
+    secw::StorageOptions options;
+    options.durability = secw::DurabilityPolicy::SYNC;
+
+    secw::PersistenceWorker worker(
+        [&nbSaves]() {
+            std::this_thread::sleep_for(5ms);
+            nbSaves++;
+        },
+        options);
+
+    SECTION("A save is done before the acknowledge")
+    {
+        uint64_t ticket = worker.requestSave();
+        worker.waitForSave(ticket);
+        CHECK(nbSaves == 1);
+    }
+
+    SECTION("Concurrent modifications share the same write")
+    {
+        std::vector<std::thread> writers;
+
+        for (int index = 0; index < 8; index++) {
+            writers.emplace_back([&worker]() {
+                for (int count = 0; count < 20; count++) {
+                    worker.waitForSave(worker.requestSave());
+                }
+            });
+        }
+
+        for (auto& writer : writers) {
+            writer.join();
+        }
+
+        CHECK(worker.getSaveCount() == uint64_t(nbSaves));
+        CHECK(nbSaves < 8 * 20);
+    }
+}
+
+TEST_CASE("Persistence worker - async durability")
+{
+    std::atomic<int> nbSaves{0};
+
+    secw::StorageOptions options;
+    options.durability = secw::DurabilityPolicy::ASYNC;
+    options.maxDelay   = 200ms;
+
+    {
+        secw::PersistenceWorker worker(
+            [&nbSaves]() {
+                nbSaves++;
+            },
+            options);
+
+        uint64_t ticket = 0;
+        for (int index = 0; index < 100; index++) {
+            ticket = worker.requestSave();
+            worker.waitForSave(ticket);
+        }
+
+        // acknowledged before being written
+        CHECK(nbSaves == 0);
+
+        worker.flush(ticket);
+        CHECK(nbSaves == 1);
+
+        worker.requestSave();
+    }
+
+    // pending modifications are written on stop
+    CHECK(nbSaves == 2);
+}
+
+TEST_CASE("Persistence worker - errors")
+{
+    std::atomic<bool> fail{true};
+
+    secw::PersistenceWorker worker([&fail]() {
+        if (fail) {
+            throw std::runtime_error("disk full");
+        }
+    });
+
+    CHECK_THROWS_WITH(worker.waitForSave(worker.requestSave()), Catch::Contains("disk full"));
+
+    fail = false;
+    CHECK_NOTHROW(worker.waitForSave(worker.requestSave()));
+
+    CHECK(secw::StorageOptions::durabilityFromString("async") == secw::DurabilityPolicy::ASYNC);
+    CHECK_THROWS(secw::StorageOptions::durabilityFromString("never"));
+}
@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <secw_exception.h>
+#include <secw_user_and_password.h>
+#include <src/secw_helpers.h>
+#include <src/secw_portfolio.h>
+#include <src/secw_string_pool.h>
+
+namespace {
+
+// allocations of the thread while counting
+thread_local bool   t_counting    = false;
+thread_local size_t t_allocations = 0;
+
+size_t countAllocations(const std::function<void()>& fct)
+{
+    t_allocations = 0;
+    t_counting    = true;
+    fct();
+    t_counting = false;
+
+    return t_allocations;
+}
+
+} // namespace
+
+// the allocations of the whole test program go through these operators
+void* operator new(size_t size)
+{
+    if (t_counting) {
+        t_allocations++;
+    }
+
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+TEST_CASE("Portfolio shared documents")
+{
+    secw::Portfolio portfolio("default");
+
+    auto doc = std::make_shared<secw::UserAndPassword>("shared", "user", "password");
+    doc->addUsage("discovery_monitoring");
+
+    const secw::Id                id     = portfolio.add(doc);
+    const std::string             name   = "shared";
+    const std::set<secw::UsageId> usages = {"discovery_monitoring"};
+
+    auto usernameOf = [](const secw::ConstDocumentPtr& document) {
+        return std::dynamic_pointer_cast<const secw::UserAndPassword>(document)->getUsername();
+    };
+
+    // the caller keeps its own document
+    doc->setUsername("modified");
+    CHECK(usernameOf(portfolio.getDocument(id)) == "user");
+
+    // the readers share the stored document
+    secw::ConstDocumentPtr first;
+    secw::ConstDocumentPtr second;
+    secw::ConstDocumentPtr byName;
+
+    CHECK(countAllocations([&]() {
+        first  = portfolio.getDocument(id);
+        second = portfolio.getDocument(id, usages);
+        byName = portfolio.getDocumentByName(name, usages);
+    }) == 0);
+
+    CHECK(first == second);
+    CHECK(first == byName);
+
+    // an update stores a new version, the former one is unchanged for its readers
+    secw::DocumentPtr updated = first->clone();
+    secw::UserAndPassword::tryToCast(updated)->setUsername("updated");
+    portfolio.update(updated);
+
+    CHECK(usernameOf(first) == "user");
+    CHECK(portfolio.getDocument(id) != first);
+    CHECK(usernameOf(portfolio.getDocument(id)) == "updated");
+}
+
+TEST_CASE("Interned tags and usages")
+{
+    size_t initialSize = secw::StringPool::size();
+
+    secw::UserAndPassword doc("interned", "user", "password");
+    doc.addTag("tag b");
+    doc.addTag("tag a");
+    doc.addTag("tag b");
+    doc.addUsage("interned usage");
+
+    CHECK(doc.getTags() == std::set<secw::Tag>{"tag a", "tag b"});
+    CHECK(doc.getUsageIds() == std::set<secw::UsageId>{"interned usage"});
+    CHECK(secw::StringPool::size() == initialSize + 3);
+
+    // the copies share the strings
+    secw::DocumentPtr copy = doc.clone();
+    CHECK(copy->getInternedTags()[0] == doc.getInternedTags()[0]);
+    CHECK(secw::StringPool::intern("tag a") == doc.getInternedTags()[0]);
+
+    // same serialization as the former sets
+    cxxtools::SerializationInfo si;
+    doc.fillSerializationInfoWithoutSecret(si);
+
+    std::set<secw::Tag> tags;
+    si.getMember(secw::DOC_TAGS_ENTRY) >>= tags;
+    CHECK(tags == doc.getTags());
+
+    secw::DocumentPtr decoded;
+    si.findMember(secw::DOC_ID_ENTRY)->setValue("42");
+    si >>= decoded;
+    CHECK(decoded->getInternedUsageIds()[0] == doc.getInternedUsageIds()[0]);
+
+    doc.removeTag("tag a");
+    doc.removeTag("unknown");
+    CHECK(doc.getTags() == std::set<secw::Tag>{"tag b"});
+
+    // the values no longer used leave the table
+    copy.reset();
+    decoded.reset();
+    CHECK(secw::StringPool::size() == initialSize + 2);
+}
+
+TEST_CASE("Portfolio pages")
+{
+    secw::Portfolio portfolio("default");
+
+    std::set<secw::Id> ids;
+    for (int index = 0; index < 10; index++) {
+        auto doc = std::make_shared<secw::UserAndPassword>("doc " + std::to_string(index), "user", "password");
+        doc->addUsage((index % 2) ? "odd" : "even");
+        ids.insert(portfolio.add(doc));
+    }
+
+    // with usages
+    secw::DocumentPage oddPage = portfolio.getPageDocuments({"odd"}, "", 100);
+    CHECK(oddPage.documents.size() == 5);
+    CHECK(oddPage.nextCursor.empty());
+
+    std::vector<secw::Id> paged;
+    std::string           cursor;
+    secw::Id              added;
+    do {
+        secw::DocumentPage page = portfolio.getPageDocuments(cursor, 3);
+        CHECK(page.documents.size() <= 3);
+
+        for (const secw::ConstDocumentPtr& doc : page.documents) {
+            paged.push_back(doc->getId());
+        }
+
+        // the cursor is opaque
+        if (!page.nextCursor.empty()) {
+            CHECK(page.nextCursor != paged.back());
+        }
+
+        // the cursor stays valid when the portfolio is modified between two pages
+        if (added.empty()) {
+            portfolio.remove(*ids.rbegin());
+            ids.erase(*ids.rbegin());
+            added = portfolio.add(std::make_shared<secw::UserAndPassword>("added", "user", "password"));
+        }
+
+        cursor = page.nextCursor;
+    } while (!cursor.empty());
+
+    // ordered by id, no duplicate, the added document is returned when it is after the first page
+    CHECK(std::is_sorted(paged.begin(), paged.end()));
+    CHECK(std::adjacent_find(paged.begin(), paged.end()) == paged.end());
+    ids.insert(added);
+    for (const secw::Id& id : paged) {
+        CHECK(ids.count(id) == 1);
+    }
+    CHECK(paged.size() >= ids.size() - 1);
+
+    // the complete list has the order of the pages, whatever the insertions
+    std::vector<secw::Id> listed;
+    for (const secw::ConstDocumentPtr& doc : portfolio.getListDocuments()) {
+        listed.push_back(doc->getId());
+    }
+    CHECK(std::is_sorted(listed.begin(), listed.end()));
+    CHECK(listed.size() == ids.size());
+
+    // the pages of several usages are merged by id, a document having both usages is returned once
+    auto both = std::make_shared<secw::UserAndPassword>("both", "user", "password");
+    both->addUsage("odd");
+    both->addUsage("even");
+    secw::Id bothId = portfolio.add(both);
+
+    std::vector<secw::Id> merged;
+    cursor.clear();
+    do {
+        secw::DocumentPage page = portfolio.getPageDocuments({"odd", "even", "unknown"}, cursor, 2);
+        CHECK(page.documents.size() <= 2);
+
+        for (const secw::ConstDocumentPtr& doc : page.documents) {
+            merged.push_back(doc->getId());
+        }
+
+        cursor = page.nextCursor;
+    } while (!cursor.empty());
+
+    CHECK(std::is_sorted(merged.begin(), merged.end()));
+    CHECK(std::adjacent_find(merged.begin(), merged.end()) == merged.end());
+    CHECK(std::count(merged.begin(), merged.end(), bothId) == 1);
+
+    // the complete list of several usages has the order of the pages
+    std::vector<secw::Id> unpaged;
+    for (const secw::ConstDocumentPtr& doc : portfolio.getListDocuments({"odd", "even", "unknown"})) {
+        unpaged.push_back(doc->getId());
+    }
+    CHECK(unpaged == merged);
+
+    // only the cursors of the previous pages are accepted
+    CHECK_THROWS_AS(portfolio.getPageDocuments(*ids.begin(), 3), secw::SecwBadCommandArgumentException);
+    CHECK_THROWS_AS(portfolio.getPageDocuments({"odd"}, "not a cursor", 3), secw::SecwBadCommandArgumentException);
+}
+
+TEST_CASE("Document projection")
+{
+    CHECK(secw::Projection().toString() == "");
+    CHECK(secw::Projection::fromString("").toString() == "");
+    CHECK(secw::Projection::header().toString() == "name,tags,usages");
+    CHECK(secw::Projection::fromString("header,public").toString() == "name,tags,usages,public");
+    CHECK(secw::Projection::fromString("public,usages").toString() == "usages,public");
+    CHECK_THROWS_AS(secw::Projection::fromString("name,pem"), secw::SecwBadCommandArgumentException);
+    CHECK_THROWS_AS(secw::Projection::fromString("name,"), secw::SecwBadCommandArgumentException);
+
+    secw::UserAndPassword doc("projected", "user", "password");
+    doc.addTag("tag");
+    doc.addUsage("usage");
+
+    // full projection: same serialization as with secret
+    cxxtools::SerializationInfo full;
+    cxxtools::SerializationInfo withSecret;
+    doc.fillSerializationInfo(full, secw::Projection());
+    doc.fillSerializationInfoWithSecret(withSecret);
+    CHECK(secw::serialize(full) == secw::serialize(withSecret));
+
+    cxxtools::SerializationInfo si;
+    doc.fillSerializationInfo(si, secw::Projection::fromString("usages"));
+    CHECK(si.findMember(secw::DOC_NAME_ENTRY) == nullptr);
+    CHECK(si.findMember(secw::DOC_PUBLIC_ENTRY) == nullptr);
+    CHECK(si.findMember(secw::DOC_PRIVATE_ENTRY) == nullptr);
+
+    si.findMember(secw::DOC_ID_ENTRY)->setValue("42");
+
+    secw::DocumentPtr decoded;
+    si >>= decoded;
+    CHECK(decoded->isPartial());
+    CHECK_FALSE(decoded->isContainingPrivateData());
+    CHECK(decoded->getName().empty());
+    CHECK(decoded->getUsageIds() == doc.getUsageIds());
+    CHECK(decoded->getTags().empty());
+
+    // a partial document says so in all its serializations
+    cxxtools::SerializationInfo again;
+    decoded->fillSerializationInfoWithSecret(again);
+    CHECK(again.findMember(secw::DOC_PARTIAL_ENTRY) != nullptr);
+
+    // the parts are mandatory without the partial flag
+    si.findMember(secw::DOC_PARTIAL_ENTRY)->setValue(false);
+    secw::DocumentPtr invalid;
+    CHECK_THROWS_AS(si >>= invalid, secw::SecwException);
+}
+
+TEST_CASE("Portfolio changes since a generation")
+{
+    secw::Portfolio portfolio("default");
+
+    auto newDocument = [](const std::string& name) {
+        return std::make_shared<secw::UserAndPassword>(name, "user", "password");
+    };
+
+    // unknown generation => full resync
+    secw::DocumentChanges changes = portfolio.getChangesSince("");
+    CHECK(changes.fullResync);
+
+    const std::string initial = changes.generation;
+    CHECK(initial == portfolio.getGeneration());
+
+    const secw::Id    first    = portfolio.add(newDocument("first"));
+    const secw::Id    second   = portfolio.add(newDocument("second"));
+    const std::string afterAdd = portfolio.getGeneration();
+
+    changes = portfolio.getChangesSince(initial);
+    CHECK_FALSE(changes.fullResync);
+    CHECK(changes.generation == afterAdd);
+    CHECK(changes.created.size() == 2);
+    CHECK(changes.updated.empty());
+    CHECK(changes.deleted.empty());
+
+    secw::DocumentPtr updated = portfolio.getDocument(first)->clone();
+    updated->setName("first updated");
+    portfolio.update(updated);
+    portfolio.remove(second);
+
+    // last action of each document since the generation
+    changes = portfolio.getChangesSince(afterAdd);
+    CHECK(changes.created.empty());
+    CHECK(changes.updated == std::vector<secw::Id>{first});
+    CHECK(changes.deleted == std::vector<secw::Id>{second});
+
+    // created and deleted since the generation => unknown by the client
+    changes = portfolio.getChangesSince(initial);
+    CHECK(changes.created == std::vector<secw::Id>{first});
+    CHECK(changes.updated.empty());
+    CHECK(changes.deleted.empty());
+
+    // nothing since the current generation
+    changes = portfolio.getChangesSince(portfolio.getGeneration());
+    CHECK_FALSE(changes.fullResync);
+    CHECK(changes.created.empty());
+    CHECK(changes.updated.empty());
+    CHECK(changes.deleted.empty());
+
+    // a copy has the same generations
+    secw::Portfolio copy(portfolio);
+    CHECK(copy.getChangesSince(afterAdd).updated == std::vector<secw::Id>{first});
+
+    // generation of another instance or from the future
+    CHECK(secw::Portfolio("default").getChangesSince(afterAdd).fullResync);
+    CHECK(portfolio.getChangesSince(initial.substr(0, initial.rfind(':')) + ":1000").fullResync);
+    CHECK_THROWS_AS(portfolio.getChangesSince("bad"), secw::SecwBadCommandArgumentException);
+
+    // the oldest changes are forgotten
+    for (size_t index = 0; index < secw::Portfolio::CHANGE_LOG_SIZE; index++) {
+        portfolio.update(portfolio.getDocument(first)->clone());
+    }
+
+    CHECK(portfolio.getChangesSince(initial).fullResync);
+    CHECK(portfolio.getChangesSince(afterAdd).fullResync);
+
+    // the whole content is replaced by a load
+    const std::string beforeLoad = portfolio.getGeneration();
+    cxxtools::SerializationInfo si;
+    portfolio.serializePortfolio(si);
+    portfolio.loadPortfolio(si);
+    CHECK(portfolio.getChangesSince(beforeLoad).fullResync);
+    CHECK_FALSE(portfolio.getChangesSince(portfolio.getGeneration()).fullResync);
+}
+
+TEST_CASE("Portfolio batch modifications")
+{
+    secw::Portfolio portfolio("default");
+
+    auto newDocument = [](const std::string& name) {
+        return std::make_shared<secw::UserAndPassword>(name, "user", "password");
+    };
+
+    const std::string     initial = portfolio.getGeneration();
+    std::vector<secw::Id> ids     = portfolio.addDocuments({newDocument("first"), newDocument("second")});
+
+    CHECK(ids.size() == 2);
+    CHECK(portfolio.getDocument(ids[1])->getName() == "second");
+
+    // one generation for the whole list
+    const std::string afterAdd = portfolio.getGeneration();
+    CHECK(initial.substr(initial.rfind(':') + 1) == "0");
+    CHECK(afterAdd.substr(afterAdd.rfind(':') + 1) == "1");
+    CHECK(portfolio.getChangesSince(initial).created.size() == 2);
+
+    // each document is checked with the previous ones of the list, nothing is applied on error
+    CHECK_THROWS_AS(portfolio.addDocuments({newDocument("third"), newDocument("third")}),
+        secw::SecwNameAlreadyExistsException);
+    CHECK_THROWS_AS(portfolio.getDocumentByName("third"), secw::SecwNameDoesNotExistException);
+
+    secw::DocumentPtr renamed = portfolio.getDocument(ids[0])->clone();
+    renamed->setName("renamed");
+    secw::DocumentPtr taken = portfolio.getDocument(ids[1])->clone();
+    taken->setName("first");
+
+    // the former name is free once the previous document of the list is renamed
+    portfolio.updateDocuments({renamed, taken});
+    CHECK(portfolio.getDocumentByName("first")->getId() == ids[1]);
+    CHECK(portfolio.getDocument(ids[1])->getVersion() == 2);
+
+    CHECK_THROWS_AS(portfolio.removeDocuments({ids[0], ids[0]}), secw::SecwDocumentDoNotExistException);
+    CHECK(portfolio.getListDocuments().size() == 2);
+
+    const std::string beforeRemove = portfolio.getGeneration();
+    portfolio.removeDocuments(ids);
+    CHECK(portfolio.getListDocuments().empty());
+    CHECK(portfolio.getChangesSince(beforeRemove).deleted.size() == 2);
+
+    // an empty list is not a modification
+    portfolio.addDocuments({});
+    CHECK(portfolio.getChangesSince(beforeRemove).generation == portfolio.getGeneration());
+    CHECK(portfolio.getGeneration().substr(portfolio.getGeneration().rfind(':') + 1) == "3");
+}
+
+TEST_CASE("Portfolio documents by ids")
+{
+    secw::Portfolio portfolio("default");
+
+    auto doc = std::make_shared<secw::UserAndPassword>("by ids", "user", "password");
+    doc->addUsage("discovery_monitoring");
+    const secw::Id id = portfolio.add(doc);
+
+    std::vector<secw::DocumentStatus> statuses;
+
+    std::vector<secw::ConstDocumentPtr> documents = portfolio.getDocuments({"unknown", id}, statuses);
+    CHECK(statuses ==
+          std::vector<secw::DocumentStatus>{secw::DocumentStatus::DOES_NOT_EXIST, secw::DocumentStatus::FOUND});
+    REQUIRE(documents.size() == 1);
+    CHECK(documents[0] == portfolio.getDocument(id));
+
+    // the document without the usages is not returned
+    documents = portfolio.getDocuments({id, id}, {"other usage"}, statuses);
+    CHECK(documents.empty());
+    CHECK(statuses == std::vector<secw::DocumentStatus>(2, secw::DocumentStatus::ILLEGAL_ACCESS));
+
+    documents = portfolio.getDocuments({id}, {"discovery_monitoring"}, statuses);
+    CHECK(documents.size() == 1);
+    CHECK(statuses == std::vector<secw::DocumentStatus>{secw::DocumentStatus::FOUND});
+}
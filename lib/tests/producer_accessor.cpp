@@ -3,6 +3,8 @@
 #include <fty_security_wallet.h>
 #include <catch2/catch.hpp>
 #include <mutex>
+#include <algorithm>
+#include <set>
 #include <condition_variable>
 
 using namespace std::placeholders;
@@ -172,6 +174,123 @@ void secwProducerAccessorTest(fty::SocketSyncClient& syncClient, mlm::MlmStreamC
         }
     }
 
+    // test 3.4 => getPageDocumentsWithoutPrivateData by pages of 1 document
+    {
+        secw::ProducerAccessor producerAccessor(syncClient, streamClient);
+        try {
+            std::set<secw::Id> all;
+            for (const secw::DocumentPtr& doc : producerAccessor.getListDocumentsWithoutPrivateData("default")) {
+                all.insert(doc->getId());
+            }
+
+            std::vector<secw::Id> paged;
+            std::string           cursor;
+            do {
+                std::vector<secw::DocumentPtr> docs =
+                    producerAccessor.getPageDocumentsWithoutPrivateData("default", "", 1, cursor);
+
+                if (docs.size() != 1) {
+                    throw std::runtime_error("Bad number of documents in the page");
+                }
+
+                paged.push_back(docs[0]->getId());
+            } while (!cursor.empty());
+
+            if ((paged.size() != all.size()) || (std::set<secw::Id>(paged.begin(), paged.end()) != all)) {
+                throw std::runtime_error("The pages are not the list of documents");
+            }
+
+            if (!std::is_sorted(paged.begin(), paged.end())) {
+                throw std::runtime_error("The pages are not ordered by id");
+            }
+
+            if (producerAccessor.getListDocumentsWithoutPrivateData("default", "", 3).size() != all.size()) {
+                throw std::runtime_error("Bad number of documents with a page size");
+            }
+        } catch (const std::exception& e) {
+            FAIL(e.what());
+        }
+    }
+
+    // test 3.5 => getListDocumentsWithoutPrivateData with the header only
+    {
+        secw::ProducerAccessor producerAccessor(syncClient, streamClient);
+        try {
+            std::vector<secw::DocumentPtr> docs =
+                producerAccessor.getListDocumentsWithoutPrivateData("default", "", secw::Projection::header());
+
+            if (docs.size() != 4) {
+                throw std::runtime_error(
+                    "Not the good number of documents: expected 4, received " + std::to_string(docs.size()));
+            }
+
+            for (const secw::DocumentPtr& doc : docs) {
+                if (!doc->isPartial() || doc->getName().empty() || doc->getId().empty()) {
+                    throw std::runtime_error("Bad partial document " + doc->getId());
+                }
+            }
+
+            secw::DocumentPtr doc = producerAccessor.getDocumentWithoutPrivateData(
+                "default", "id_readable", secw::Projection::fromString("usages"));
+
+            if (!doc->isPartial() || !doc->getName().empty() || doc->getUsageIds().empty()) {
+                throw std::runtime_error("Bad projection of the document");
+            }
+
+            // a partial document cannot be stored
+            try {
+                producerAccessor.updateDocument("default", doc);
+                throw std::runtime_error("Partial document updated");
+            } catch (const secw::SecwInvalidDocumentFormatException&) {
+            }
+        } catch (const std::exception& e) {
+            FAIL(e.what());
+        }
+    }
+
+    // test 3.6 => getChangesSince
+    {
+        secw::ProducerAccessor producerAccessor(syncClient, streamClient);
+        try {
+            secw::DocumentChanges changes = producerAccessor.getChangesSince("default", "");
+
+            if (!changes.fullResync || changes.generation.empty()) {
+                throw std::runtime_error("Full resync expected without generation");
+            }
+
+            changes = producerAccessor.getChangesSince("default", changes.generation);
+
+            if (changes.fullResync || !changes.created.empty() || !changes.updated.empty() ||
+                !changes.deleted.empty()) {
+                throw std::runtime_error("No change expected since the current generation");
+            }
+        } catch (const std::exception& e) {
+            FAIL(e.what());
+        }
+    }
+
+    // test 3.7 => getDocumentsWithoutPrivateData with list of id
+    {
+        secw::ProducerAccessor producerAccessor(syncClient, streamClient);
+        try {
+            std::vector<secw::Id> ids  = {"id_notReadable", "XXXXX-XXXXXXXXX", "id_readable"};
+            secw::DocumentsByIds  docs = producerAccessor.getDocumentsWithoutPrivateData(
+                "default", ids, secw::Projection::header());
+
+            std::vector<secw::DocumentStatus> statuses = {secw::DocumentStatus::FOUND,
+                secw::DocumentStatus::DOES_NOT_EXIST, secw::DocumentStatus::FOUND};
+
+            if (docs.statuses != statuses)
+                throw std::runtime_error("Bad statuses returned");
+            if ((docs.documents.size() != 2) || (docs.documents.at(1)->getId() != "id_readable"))
+                throw std::runtime_error("Bad documents returned");
+            if (!docs.documents.at(0)->isPartial() || docs.documents.at(0)->isContainingPrivateData())
+                throw std::runtime_error("Bad parts of the documents returned");
+        } catch (const std::exception& e) {
+            FAIL(e.what());
+        }
+    }
+
     // test 4.1 => getDocumentWithoutPrivateData
     {
         secw::ProducerAccessor producerAccessor(syncClient, streamClient);
@@ -581,6 +700,34 @@ void secwProducerAccessorTest(fty::SocketSyncClient& syncClient, mlm::MlmStreamC
         }
     }
 
+    // test 6.5 => getDocumentWithPrivateData with a cached document
+    {
+        secw::ConsumerAccessor consumerAccessor(syncClient, streamClient);
+        try {
+            secw::DocumentPtr cached = consumerAccessor.getDocumentWithPrivateData("default", id);
+
+            if (cached->getVersion() != 2)
+                throw std::runtime_error("Bad version: expected 2, received " + std::to_string(cached->getVersion()));
+
+            // current version => the cached document is returned
+            if (consumerAccessor.getDocumentWithPrivateData("default", id, cached) != cached)
+                throw std::runtime_error("Current document received again");
+            if (consumerAccessor.getDocumentWithPrivateDataByName("default", "Test update username", cached) != cached)
+                throw std::runtime_error("Current document received again by name");
+
+            // no version without the private part => the document is received
+            secw::ProducerAccessor producerAccessor(syncClient);
+
+            secw::DocumentPtr withoutPrivate = producerAccessor.getDocumentWithoutPrivateData("default", id);
+            secw::DocumentPtr received = consumerAccessor.getDocumentWithPrivateData("default", id, withoutPrivate);
+
+            if ((received == withoutPrivate) || !received->isContainingPrivateData())
+                throw std::runtime_error("Document not received");
+        } catch (const std::exception& e) {
+            FAIL(e.what());
+        }
+    }
+
     // test 6.6 => updateDocument User and Password -> retrieve data
     {
         secw::ProducerAccessor producerAccessor(syncClient, streamClient);
@@ -712,6 +859,70 @@ void secwProducerAccessorTest(fty::SocketSyncClient& syncClient, mlm::MlmStreamC
         }
     }
 
+    // test 6.12 => insertNewDocuments, updateDocuments and deleteDocuments User and Password
+    {
+        secw::ProducerAccessor producerAccessor(syncClient, streamClient);
+        try {
+            auto newDocument = [](const std::string& name) {
+                secw::UserAndPasswordPtr doc = std::make_shared<secw::UserAndPassword>(name, "username", "password");
+                doc->addUsage("discovery_monitoring");
+                return std::dynamic_pointer_cast<secw::Document>(doc);
+            };
+
+            std::vector<secw::Id> ids = producerAccessor.insertNewDocuments(
+                "default", {newDocument("Test bulk 1"), newDocument("Test bulk 2")});
+
+            if (ids.size() != 2)
+                throw std::runtime_error("Bad number of ids: " + std::to_string(ids.size()));
+            if (producerAccessor.getListDocumentsWithoutPrivateData("default", ids).size() != 2)
+                throw std::runtime_error("Documents are not inserted");
+
+            // all or nothing: the first document is not inserted
+            try {
+                producerAccessor.insertNewDocuments(
+                    "default", {newDocument("Test bulk 3"), newDocument("Test bulk 1")});
+                throw std::runtime_error("Documents have been added");
+            } catch (const secw::SecwNameAlreadyExistsException& e) {
+                CHECK(e.getName() == "Test bulk 1");
+            }
+
+            try {
+                producerAccessor.getDocumentWithoutPrivateDataByName("default", "Test bulk 3");
+                throw std::runtime_error("Document of the refused list is inserted");
+            } catch (const secw::SecwNameDoesNotExistException&) {
+            }
+
+            std::vector<secw::DocumentPtr> docs = producerAccessor.getListDocumentsWithoutPrivateData("default", ids);
+            for (secw::DocumentPtr& doc : docs) {
+                secw::UserAndPassword::tryToCast(doc)->setUsername("bulk_username");
+            }
+
+            producerAccessor.updateDocuments("default", docs);
+
+            for (const secw::DocumentPtr& doc : producerAccessor.getListDocumentsWithoutPrivateData("default", ids)) {
+                if (secw::UserAndPassword::tryToCast(doc)->getUsername() != "bulk_username")
+                    throw std::runtime_error("Document is not updated");
+            }
+
+            // all or nothing: the existing document is not removed
+            try {
+                producerAccessor.deleteDocuments("default", {ids.at(0), "XXXXX-XXXXXXXXX"});
+                throw std::runtime_error("Documents have been removed");
+            } catch (const secw::SecwDocumentDoNotExistException&) {
+            }
+
+            if (producerAccessor.getListDocumentsWithoutPrivateData("default", ids).size() != 2)
+                throw std::runtime_error("Document of the refused list is removed");
+
+            producerAccessor.deleteDocuments("default", ids);
+
+            if (producerAccessor.getListDocumentsWithoutPrivateData("default", ids).size() != 0)
+                throw std::runtime_error("Documents are not removed");
+        } catch (const std::exception& e) {
+            FAIL(e.what());
+        }
+    }
+
     // test 7.1 => insertNewDocument Snmpv1
     {
         secw::ProducerAccessor producerAccessor(syncClient, streamClient);
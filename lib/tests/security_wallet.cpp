@@ -0,0 +1,259 @@
+#include <catch2/catch.hpp>
+#include <cxxtools/jsondeserializer.h>
+#include <fstream>
+#include <iterator>
+#include <secw_user_and_password.h>
+#include <src/secw_security_wallet.h>
+#include <sys/stat.h>
+#include <thread>
+
+namespace {
+
+void copyFile(const std::string& sourcePath, const std::string& destPath)
+{
+    std::ifstream source(sourcePath, std::ios::binary);
+    std::ofstream dest(destPath, std::ios::binary | std::ofstream::trunc);
+    dest << source.rdbuf();
+}
+
+size_t fileSize(const std::string& path)
+{
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+    return input ? size_t(input.tellg()) : 0;
+}
+
+uint8_t databaseVersion(const std::string& path)
+{
+    std::ifstream               input(path);
+    cxxtools::SerializationInfo si;
+    cxxtools::JsonDeserializer  deserializer(input);
+    deserializer.deserialize(si);
+
+    uint8_t version = 0;
+    si.getMember("version") >>= version;
+    return version;
+}
+
+ino_t fileInode(const std::string& path)
+{
+    struct stat buffer;
+    return (stat(path.c_str(), &buffer) == 0) ? buffer.st_ino : 0;
+}
+
+// configuration with a second portfolio "other", copy of the first one
+void writeTwoPortfoliosConfiguration(const std::string& sourcePath, const std::string& destPath)
+{
+    std::ifstream source(sourcePath);
+    std::string   content((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+
+    std::string portfolio = content.substr(content.find('{'), content.rfind('}') - content.find('{') + 1);
+    std::string other     = portfolio;
+    other.replace(other.find("\"default\""), 9, "\"other\"");
+
+    std::ofstream dest(destPath, std::ofstream::trunc);
+    dest << "[" << portfolio << "," << other << "]";
+}
+
+secw::Id addDocument(secw::SecurityWallet& wallet, const std::string& name)
+{
+    secw::UserAndPasswordPtr doc = std::make_shared<secw::UserAndPassword>(name, "user", "password");
+    doc->addUsage("discovery_monitoring");
+
+    secw::Id id = wallet.getPortfolio("default")->add(doc);
+    wallet.waitForSave(wallet.requestSave());
+    return id;
+}
+
+} // namespace
+
+TEST_CASE("Security wallet storage")
+{
+    static const std::string configuration = "storage-configuration.json";
+    static const std::string database      = "storage-data.json";
+    static const std::string journal       = database + ".journal";
+
+    const std::string defaultFile = secw::SecurityWallet::getPortfolioPath(database, "default");
+
+    copyFile("tests/selftest-ro/configuration.json", configuration);
+    copyFile("tests/selftest-ro/data.json", database);
+    std::remove(journal.c_str());
+
+    SECTION("Modifications are appended to the journal and replayed")
+    {
+        secw::Id createdId;
+        secw::Id deletedId;
+
+        {
+            secw::SecurityWallet wallet(configuration, database);
+
+            // version 1 is migrated at startup
+            CHECK(databaseVersion(database) == secw::SecurityWallet::SECW_VERSION);
+            CHECK(fileSize(journal) == 0);
+
+            size_t databaseSize = fileSize(defaultFile);
+
+            createdId = addDocument(wallet, "journal created");
+            deletedId = addDocument(wallet, "journal deleted");
+
+            wallet.getPortfolio("default")->remove(deletedId);
+            wallet.waitForSave(wallet.requestSave());
+
+            // only the journal is written
+            CHECK(fileSize(defaultFile) == databaseSize);
+            CHECK(fileSize(journal) > 0);
+        }
+
+        // a crash while writing a record
+        {
+            std::ofstream output(journal, std::ios::binary | std::ios::app);
+            output << "{\"sequence\":99,\"action\":\"CRE";
+        }
+
+        secw::SecurityWallet wallet(configuration, database);
+
+        CHECK(wallet.getPortfolio("default")->getDocument(createdId)->getName() == "journal created");
+        CHECK_THROWS(wallet.getPortfolio("default")->getDocument(deletedId));
+        CHECK(wallet.getPortfolio("default")->getDocumentByName("journal created")->getId() == createdId);
+    }
+
+    SECTION("The journal is merged in the database when it is too big")
+    {
+        secw::StorageOptions options;
+        options.journalMaxSize = 1;
+
+        secw::Id createdId;
+
+        {
+            secw::SecurityWallet wallet(configuration, database, options);
+
+            createdId = addDocument(wallet, "compacted");
+
+            CHECK(fileSize(journal) == 0);
+        }
+
+        secw::SecurityWallet wallet(configuration, database);
+        CHECK(wallet.getPortfolio("default")->getDocument(createdId)->getName() == "compacted");
+    }
+
+    SECTION("The database can be written in binary format")
+    {
+        secw::StorageOptions options;
+        options.format = secw::StorageFormat::BINARY;
+
+        secw::Id createdId;
+
+        {
+            secw::SecurityWallet wallet(configuration, database, options);
+            createdId = addDocument(wallet, "binary");
+            wallet.save();
+
+            std::ifstream input(defaultFile, std::ios::binary);
+            CHECK(secw::detectStorageFormat(input) == secw::StorageFormat::BINARY);
+
+            // the manifest stays in JSON
+            CHECK(databaseVersion(database) == secw::SecurityWallet::SECW_VERSION);
+        }
+
+        // the format is detected at load
+        secw::SecurityWallet wallet(configuration, database);
+        CHECK(wallet.getPortfolio("default")->getDocument(createdId)->getName() == "binary");
+    }
+
+    SECTION("A mapped database is decoded on first access")
+    {
+        secw::StorageOptions options;
+        options.format   = secw::StorageFormat::BINARY;
+        options.lazyLoad = true;
+
+        secw::Id createdId;
+
+        {
+            secw::SecurityWallet wallet(configuration, database, options);
+            createdId = addDocument(wallet, "mapped");
+            wallet.save();
+        }
+
+        ino_t inode = fileInode(defaultFile);
+        REQUIRE(inode != 0);
+
+        {
+            secw::SecurityWallet wallet(configuration, database, options);
+
+            // up to date => not written again at startup
+            CHECK(fileInode(defaultFile) == inode);
+
+            secw::PortfolioPtr portfolio = wallet.getPortfolio("default");
+
+            CHECK(portfolio->getDocument(createdId)->getName() == "mapped");
+            CHECK(portfolio->getDocumentByName("mapped")->getId() == createdId);
+            CHECK(portfolio->getListDocuments({"unknown_usage"}).empty());
+            CHECK(portfolio->getListDocuments({"discovery_monitoring"}).size() > 0);
+
+            // the documents not decoded are written from the mapped file
+            addDocument(wallet, "after mapping");
+            wallet.save();
+        }
+
+        secw::SecurityWallet wallet(configuration, database);
+        CHECK(wallet.getPortfolio("default")->getDocument(createdId)->getName() == "mapped");
+        CHECK_NOTHROW(wallet.getPortfolio("default")->getDocumentByName("after mapping"));
+    }
+
+    SECTION("Only the modified portfolios are written")
+    {
+        writeTwoPortfoliosConfiguration("tests/selftest-ro/configuration.json", configuration);
+
+        const std::string otherFile = secw::SecurityWallet::getPortfolioPath(database, "other");
+
+        {
+            secw::SecurityWallet wallet(configuration, database);
+
+            ino_t defaultInode = fileInode(defaultFile);
+            ino_t otherInode   = fileInode(otherFile);
+            REQUIRE(otherInode != 0);
+
+            addDocument(wallet, "default only");
+            wallet.save();
+
+            CHECK(fileInode(defaultFile) != defaultInode);
+            CHECK(fileInode(otherFile) == otherInode);
+        }
+
+        secw::SecurityWallet wallet(configuration, database);
+        CHECK_NOTHROW(wallet.getPortfolio("default")->getDocumentByName("default only"));
+        CHECK(wallet.getPortfolio("other")->getListDocuments().empty());
+    }
+
+    SECTION("The configuration is reloaded when its file is modified")
+    {
+        secw::StorageOptions options;
+        options.watchConfiguration = true;
+
+        secw::SecurityWallet wallet(configuration, database, options);
+
+        secw::PortfolioPtr         portfolio = wallet.getPortfolio("default");
+        secw::PortfolioSnapshotPtr snapshot  = portfolio->getSnapshot();
+
+        writeTwoPortfoliosConfiguration("tests/selftest-ro/configuration.json", configuration);
+
+        for (int retry = 0; (retry < 100) && (wallet.getPortfolioNames().size() < 2); retry++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+
+        CHECK(wallet.getPortfolioNames().size() == 2);
+        CHECK_NOTHROW(wallet.getConfiguration("other"));
+        CHECK(wallet.getPortfolio("other")->getListDocuments().empty());
+
+        // the documents are untouched
+        CHECK(wallet.getPortfolio("default") == portfolio);
+        CHECK(portfolio->getSnapshot() == snapshot);
+
+        // an invalid file keeps the current configuration
+        {
+            std::ofstream output(configuration, std::ofstream::trunc);
+            output << "[";
+        }
+        CHECK_THROWS(wallet.reloadConfiguration());
+        CHECK(wallet.getPortfolioNames().size() == 2);
+    }
+}
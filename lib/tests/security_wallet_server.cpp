@@ -0,0 +1,341 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <future>
+#include <fty_common_client.h>
+#include <map>
+#include <secw_user_and_password.h>
+#include <src/secw_security_wallet_server.h>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+class NullStreamPublisher : public fty::StreamPublisher
+{
+public:
+    void publish(const std::vector<std::string>& /*payload*/) override
+    {
+    }
+};
+
+void copyFile(const std::string& sourcePath, const std::string& destPath)
+{
+    std::ifstream source(sourcePath, std::ios::binary);
+    std::ofstream dest(destPath, std::ios::binary | std::ofstream::trunc);
+    dest << source.rdbuf();
+}
+
+struct ReadResult
+{
+    double   requestsPerSecond = 0;
+    uint64_t errors            = 0;
+};
+
+ReadResult measureReadThroughput(secw::SecurityWalletServer& server, size_t nbThreads, std::chrono::milliseconds duration)
+{
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<bool>     start{false};
+
+    std::vector<std::thread> readers;
+
+    for (size_t index = 0; index < nbThreads; index++) {
+        readers.emplace_back([&]() {
+            while (!start) {
+                std::this_thread::yield();
+            }
+
+            const auto deadline = std::chrono::steady_clock::now() + duration;
+            uint64_t   count    = 0;
+
+            while (std::chrono::steady_clock::now() < deadline) {
+                std::vector<std::string> reply = server.handleRequest(
+                    "contention-test", {secw::SecurityWalletServer::GET_WITH_SECRET, "default", "id_readable"});
+
+                if (reply.empty() || reply.at(0) == "ERROR") {
+                    errors++;
+                }
+                count++;
+            }
+
+            requests += count;
+        });
+    }
+
+    start = true;
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    ReadResult result;
+    result.requestsPerSecond = double(requests) * 1000.0 / double(duration.count());
+    result.errors            = errors;
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("Security wallet server concurrent readers")
+{
+    copyFile("tests/selftest-ro/data.json", "contention-data.json");
+    copyFile("tests/selftest-ro/configuration.json", "contention-configuration.json");
+
+    NullStreamPublisher        publisher;
+    secw::SecurityWalletServer server("contention-configuration.json", "contention-data.json", publisher);
+
+    // readers never wait for the writers
+    {
+        std::future<std::vector<std::string>> writer;
+        std::unique_lock<std::mutex>          writerLock(server.m_lock);
+
+        auto reader = std::async(std::launch::async, [&server]() {
+            return server.handleRequest(
+                "contention-test", {secw::SecurityWalletServer::GET_WITH_SECRET, "default", "id_readable"});
+        });
+
+        REQUIRE(reader.wait_for(5s) == std::future_status::ready);
+        CHECK(reader.get().at(0) != "ERROR");
+
+        writer = std::async(std::launch::async, [&server]() {
+            return server.handleRequest(
+                "contention-test", {secw::SecurityWalletServer::DELETE, "default", "id_notReadable"});
+        });
+
+        CHECK(writer.wait_for(200ms) == std::future_status::timeout);
+
+        // the document is still visible until the writer publishes its snapshot
+        CHECK(server.handleRequest("contention-test",
+                  {secw::SecurityWalletServer::GET_WITHOUT_SECRET, "default", "id_notReadable"})
+                  .at(0) != "ERROR");
+
+        writerLock.unlock();
+
+        REQUIRE(writer.wait_for(5s) == std::future_status::ready);
+        CHECK(writer.get().at(0) == "OK");
+
+        CHECK(server.handleRequest("contention-test",
+                  {secw::SecurityWalletServer::GET_WITHOUT_SECRET, "default", "id_notReadable"})
+                  .at(0) == "ERROR");
+    }
+
+    // concurrent readers all get the document
+    {
+        ReadResult result = measureReadThroughput(server, 4, 100ms);
+
+        CHECK(result.requestsPerSecond > 0);
+        CHECK(result.errors == 0);
+    }
+
+    // several readers all complete their requests while a writer holds the lock
+    {
+        const size_t   nbReaders  = 4;
+        const uint64_t nbRequests = 100;
+
+        std::unique_lock<std::mutex> writerLock(server.m_lock);
+
+        std::atomic<size_t>     arrived{0};
+        std::atomic<uint64_t>   errors{0};
+        std::mutex              latchLock;
+        std::condition_variable latchReleased;
+        size_t                  pending = nbReaders;
+
+        std::vector<std::thread> readers;
+
+        for (size_t index = 0; index < nbReaders; index++) {
+            readers.emplace_back([&]() {
+                // all the readers are running before the first request
+                arrived++;
+                while (arrived < nbReaders) {
+                    std::this_thread::yield();
+                }
+
+                for (uint64_t request = 0; request < nbRequests; request++) {
+                    std::vector<std::string> reply = server.handleRequest(
+                        "contention-test", {secw::SecurityWalletServer::GET_WITH_SECRET, "default", "id_readable"});
+
+                    if (reply.empty() || reply.at(0) == "ERROR") {
+                        errors++;
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(latchLock);
+                if (--pending == 0) {
+                    latchReleased.notify_all();
+                }
+            });
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(latchLock);
+            CHECK(latchReleased.wait_for(lock, 10s, [&pending]() {
+                return pending == 0;
+            }));
+        }
+
+        CHECK(errors == 0);
+
+        // released before joining, the readers would be blocked forever if they needed the lock
+        writerLock.unlock();
+
+        for (auto& reader : readers) {
+            reader.join();
+        }
+    }
+}
+
+TEST_CASE("Security wallet server read benchmark", "[.benchmark]")
+{
+    copyFile("tests/selftest-ro/data.json", "contention-data.json");
+    copyFile("tests/selftest-ro/configuration.json", "contention-configuration.json");
+
+    NullStreamPublisher        publisher;
+    secw::SecurityWalletServer server("contention-configuration.json", "contention-data.json", publisher);
+
+    // read throughput with an increasing number of readers
+    std::map<size_t, ReadResult> results;
+
+    for (size_t nbThreads : {1, 2, 4, 8}) {
+        results[nbThreads] = measureReadThroughput(server, nbThreads, 300ms);
+
+        printf(" *=>  %zu reader(s): %.0f GET_WITH_SECRET/s\n", nbThreads, results[nbThreads].requestsPerSecond);
+        CHECK(results[nbThreads].errors == 0);
+    }
+
+    // the readers do not serialize on a lock: with enough cores, 4 readers do more than 1
+    if (std::thread::hardware_concurrency() >= 4) {
+        CHECK(results[4].requestsPerSecond > 1.2 * results[1].requestsPerSecond);
+    }
+}
+
+TEST_CASE("Security wallet server conditional get")
+{
+    using Server = secw::SecurityWalletServer;
+
+    copyFile("tests/selftest-ro/data.json", "conditional-data.json");
+    copyFile("tests/selftest-ro/configuration.json", "conditional-configuration.json");
+
+    NullStreamPublisher publisher;
+    Server              server("conditional-configuration.json", "conditional-data.json", publisher);
+
+    secw::UserAndPassword doc("conditional", "user", "password");
+    doc.addUsage("discovery_monitoring");
+
+    std::string json;
+    json <<= doc;
+
+    std::vector<std::string> reply = server.handleRequest("conditional-test", {Server::CREATE, "default", json});
+    REQUIRE(reply.at(0) != "ERROR");
+    const secw::Id id = reply.at(0);
+
+    auto getVersion = [&server, &id]() {
+        secw::DocumentPtr current;
+        server.handleRequest("conditional-test", {Server::GET_WITH_SECRET, "default", id}).at(0) >>= current;
+        return current;
+    };
+
+    secw::DocumentPtr created = getVersion();
+    CHECK(created->getVersion() == 1);
+
+    // current version => nothing is sent
+    CHECK(server.handleRequest("conditional-test", {Server::GET_WITH_SECRET, "default", id, "", "1"}).at(0) ==
+          Server::NOT_MODIFIED);
+    CHECK(server.handleRequest("conditional-test", {Server::GET_WITHOUT_SECRET, "default", id, "", "1"}).at(0) ==
+          Server::NOT_MODIFIED);
+    CHECK(server.handleRequest("conditional-test",
+                  {Server::GET_WITH_SECRET_BY_NAME, "default", "conditional", "", "1", id})
+              .at(0) == Server::NOT_MODIFIED);
+
+    // by name, the version is compared only for the known document
+    CHECK(server.handleRequest("conditional-test",
+                  {Server::GET_WITH_SECRET_BY_NAME, "default", "conditional", "", "1", "other id"})
+              .at(0) != Server::NOT_MODIFIED);
+    CHECK(server.handleRequest("conditional-test", {Server::GET_WITH_SECRET, "default", id, "", "x"}).at(0) ==
+          "ERROR");
+
+    // the version given by the client is ignored by the update
+    secw::UserAndPassword::tryToCast(created)->setPassword("new password");
+    json <<= *created;
+    REQUIRE(server.handleRequest("conditional-test", {Server::UPDATE, "default", json}).at(0) == "OK");
+
+    secw::DocumentPtr updated = getVersion();
+    CHECK(updated->getVersion() == 2);
+    CHECK(secw::UserAndPassword::tryToCast(updated)->getPassword() == "new password");
+
+    CHECK(server.handleRequest("conditional-test", {Server::GET_WITH_SECRET, "default", id, "", "1"}).at(0) !=
+          Server::NOT_MODIFIED);
+
+    // the versions are kept by the database
+    Server reloaded("conditional-configuration.json", "conditional-data.json", publisher);
+    CHECK(reloaded.handleRequest("conditional-test", {Server::GET_WITH_SECRET, "default", id, "", "2"}).at(0) ==
+          Server::NOT_MODIFIED);
+}
+
+TEST_CASE("Security wallet server batch")
+{
+    using Server = secw::SecurityWalletServer;
+
+    copyFile("tests/selftest-ro/data.json", "batch-data.json");
+    copyFile("tests/selftest-ro/configuration.json", "batch-configuration.json");
+
+    NullStreamPublisher publisher;
+    Server              server("batch-configuration.json", "batch-data.json", publisher);
+
+    secw::UserAndPassword doc("batch", "user", "password");
+    doc.addUsage("discovery_monitoring");
+
+    std::string json;
+    json <<= doc;
+
+    // each command and each reply is preceded by its number of frames
+    std::vector<std::string> reply = server.handleRequest("batch-test",
+        {Server::BATCH, "3", Server::CREATE, "default", json, "3", Server::GET_WITHOUT_SECRET_BY_NAME, "default",
+            "batch", "1", "UNKNOWN", "2", Server::BATCH, "0"});
+
+    REQUIRE(reply.size() == 10);
+    CHECK(reply.at(0) == "1");
+
+    // the commands see the modifications of the previous ones
+    secw::DocumentPtr created;
+    CHECK(reply.at(2) == "1");
+    reply.at(3) >>= created;
+    CHECK(created->getId() == reply.at(1));
+
+    // an error by failing command, a batch is not a command of a batch
+    CHECK(reply.at(4) == "2");
+    CHECK(reply.at(5) == "ERROR");
+    CHECK(reply.at(7) == "2");
+    CHECK(reply.at(8) == "ERROR");
+
+    // bad frames => the whole batch fails
+    CHECK(server.handleRequest("batch-test", {Server::BATCH, "3", Server::GET_PORTFOLIO_LIST}).at(0) == "ERROR");
+    CHECK(server.handleRequest("batch-test", {Server::BATCH, "x", Server::GET_PORTFOLIO_LIST}).at(0) == "ERROR");
+
+    // the read only batches do not wait for the writers
+    {
+        std::unique_lock<std::mutex> writerLock(server.m_lock);
+
+        auto reader = std::async(std::launch::async, [&server]() {
+            return server.handleRequest("batch-test", {Server::BATCH, "1", Server::GET_PORTFOLIO_LIST, "3",
+                                                          Server::GET_WITH_SECRET, "default", "id_readable"});
+        });
+
+        auto writer = std::async(std::launch::async, [&server]() {
+            return server.handleRequest("batch-test",
+                {Server::BATCH, "1", Server::GET_PORTFOLIO_LIST, "3", Server::DELETE, "default", "id_readable"});
+        });
+
+        REQUIRE(reader.wait_for(5s) == std::future_status::ready);
+        CHECK(reader.get().size() == 4);
+        CHECK(writer.wait_for(200ms) == std::future_status::timeout);
+
+        writerLock.unlock();
+
+        REQUIRE(writer.wait_for(5s) == std::future_status::ready);
+        CHECK(writer.get().at(3) == "OK");
+    }
+}
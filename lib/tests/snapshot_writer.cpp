@@ -0,0 +1,128 @@
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <fstream>
+#include <src/secw_snapshot_writer.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+std::string readFile(const std::string& path)
+{
+    std::ifstream     input(path, std::ios::binary);
+    std::stringstream content;
+    content << input.rdbuf();
+    return content.str();
+}
+
+} // namespace
+
+TEST_CASE("Snapshot writer")
+{
+    static const std::string path = "snapshot-writer-test.json";
+
+    {
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        output << "former content";
+    }
+    chmod(path.c_str(), 0600);
+
+    SECTION("The content is replaced and the rights are kept")
+    {
+        secw::SnapshotWriter writer(path);
+
+        writer.write([](std::ostream& output) {
+            output << "new content";
+        });
+
+        CHECK(readFile(path) == "new content");
+        CHECK(access((path + ".tmp").c_str(), F_OK) != 0);
+
+        struct stat buffer;
+        REQUIRE(stat(path.c_str(), &buffer) == 0);
+        CHECK((buffer.st_mode & 0777) == 0600);
+
+        CHECK(writer.getStatistics().nbWrites == 1);
+        CHECK(writer.getStatistics().nbSyncs == 1);
+    }
+
+    SECTION("An error keeps the former content")
+    {
+        secw::SnapshotWriter writer(path);
+
+        CHECK_THROWS(writer.write([](std::ostream& output) {
+            output << "partial";
+            throw std::runtime_error("serialization error");
+        }));
+
+        CHECK(readFile(path) == "former content");
+        CHECK(access((path + ".tmp").c_str(), F_OK) != 0);
+    }
+
+    SECTION("Fsync policies")
+    {
+        secw::SnapshotWriter never(path, secw::FsyncPolicy(secw::FsyncPolicy::Mode::NEVER));
+        secw::SnapshotWriter periodic(
+            path, secw::FsyncPolicy(secw::FsyncPolicy::Mode::PERIODIC, std::chrono::milliseconds(3600 * 1000)));
+
+        for (int index = 0; index < 3; index++) {
+            never.write([](std::ostream& output) {
+                output << "never";
+            });
+            periodic.write([](std::ostream& output) {
+                output << "periodic";
+            });
+        }
+
+        // the content is always synchronized before the rename, whatever the policy
+        CHECK(never.getStatistics().nbWrites == 3);
+        CHECK(never.getStatistics().nbSyncs == 3);
+        CHECK(periodic.getStatistics().nbWrites == 3);
+        CHECK(periodic.getStatistics().nbSyncs == 3);
+
+        // the renames of the period are synchronized once by the timer
+        periodic.syncPending();
+        CHECK(periodic.getStatistics().nbSyncs == 4);
+        periodic.syncPending();
+        never.syncPending();
+        CHECK(periodic.getStatistics().nbSyncs == 4);
+        CHECK(never.getStatistics().nbSyncs == 3);
+
+        // only the first write is in a new period, the other ones stay pending
+        secw::FsyncPolicy policy(secw::FsyncPolicy::Mode::PERIODIC, std::chrono::milliseconds(3600 * 1000));
+        CHECK(policy.isSyncNeeded());
+        CHECK_FALSE(policy.hasPendingSync());
+        CHECK_FALSE(policy.isSyncNeeded());
+        CHECK(policy.hasPendingSync());
+        policy.setSynced();
+        CHECK_FALSE(policy.hasPendingSync());
+
+        CHECK(secw::FsyncPolicy::modeFromString("periodic") == secw::FsyncPolicy::Mode::PERIODIC);
+        CHECK_THROWS(secw::FsyncPolicy::modeFromString("sometimes"));
+    }
+
+    SECTION("Fsync timer")
+    {
+        std::atomic<int> nbCalls(0);
+
+        {
+            secw::FsyncTimer timer(secw::FsyncPolicy(secw::FsyncPolicy::Mode::PERIODIC, std::chrono::milliseconds(10)),
+                [&nbCalls]() {
+                    nbCalls++;
+                });
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            CHECK(nbCalls > 0);
+        }
+
+        // no thread for the other policies
+        {
+            secw::FsyncTimer timer(secw::FsyncPolicy(secw::FsyncPolicy::Mode::ALWAYS), [&nbCalls]() {
+                nbCalls = -1000;
+            });
+        }
+        CHECK(nbCalls > 0);
+    }
+}
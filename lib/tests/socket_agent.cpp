@@ -7,6 +7,7 @@
 #include <map>
 #include <mlm_server.h>
 #include <src/secw_security_wallet_server.h>
+#include <src/secw_socket_worker_pool_server.h>
 #include "consumer_accessor.h"
 #include "producer_accessor.h"
 
@@ -59,8 +60,8 @@ TEST_CASE("Security wallet socket agent test")
         secw::SecurityWalletServer serverSecw(
             paramsSecw.at("STORAGE_CONFIGURATION_PATH"), paramsSecw.at("STORAGE_DATABASE_PATH"), notificationStream);
 
-        fty::SocketBasicServer agentSecw(serverSecw, "secw-test.socket");
-        std::thread            agentSecwThread(&fty::SocketBasicServer::run, &agentSecw);
+        secw::SocketWorkerPoolServer agentSecw(serverSecw, "secw-test.socket", 4);
+        std::thread                  agentSecwThread(&secw::SocketWorkerPoolServer::run, &agentSecw);
 
         // create the 2 Clients
         fty::SocketSyncClient syncClient("secw-test.socket");
@@ -0,0 +1,177 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <cstring>
+#include <fty_common_socket.h>
+#include <src/secw_socket_worker_pool_server.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// Echo the payload after waiting the number of milliseconds given in the first frame
+class SlowEchoServer : public fty::SyncServer
+{
+public:
+    std::atomic<int> m_current{0};
+    std::atomic<int> m_maxConcurrent{0};
+
+    std::vector<std::string> handleRequest(const std::string& /*sender*/, const std::vector<std::string>& payload) override
+    {
+        int current = ++m_current;
+
+        int maxConcurrent = m_maxConcurrent;
+        while (current > maxConcurrent && !m_maxConcurrent.compare_exchange_weak(maxConcurrent, current)) {
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::stoi(payload.at(0))));
+
+        m_current--;
+        return payload;
+    }
+};
+
+int connectTo(const std::string& socketPath)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    int clientSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(clientSocket != -1);
+    REQUIRE(connect(clientSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    return clientSocket;
+}
+
+} // namespace
+
+TEST_CASE("Socket worker pool server")
+{
+    static const std::string socketPath = "secw-worker-pool-test.socket";
+
+    SlowEchoServer               echoServer;
+    secw::SocketWorkerPoolServer server(echoServer, socketPath, 4);
+    std::thread                  serverThread(&secw::SocketWorkerPoolServer::run, &server);
+
+    SECTION("Replies keep the order of the requests on a connection")
+    {
+        int clientSocket = connectTo(socketPath);
+
+        // the first requests are the slowest ones
+        for (int index = 0; index < 8; index++) {
+            fty::Payload::sendFrames(clientSocket, {std::to_string((8 - index) * 5), std::to_string(index)});
+        }
+
+        for (int index = 0; index < 8; index++) {
+            std::vector<std::string> reply = fty::Payload::recvFrames(clientSocket);
+            REQUIRE(reply.size() == 2);
+            CHECK(reply.at(1) == std::to_string(index));
+        }
+
+        close(clientSocket);
+
+        // one connection => one request at a time
+        CHECK(echoServer.m_maxConcurrent == 1);
+    }
+
+    SECTION("Requests of different connections are executed concurrently")
+    {
+        std::vector<std::thread> clients;
+        std::atomic<int>         errors{0};
+
+        for (int index = 0; index < 4; index++) {
+            clients.emplace_back([&errors, index]() {
+                try {
+                    fty::SocketSyncClient    syncClient(socketPath);
+                    std::vector<std::string> reply = syncClient.syncRequestWithReply({"200", std::to_string(index)});
+
+                    if (reply.size() != 2 || reply.at(1) != std::to_string(index)) {
+                        errors++;
+                    }
+                } catch (const std::exception&) {
+                    errors++;
+                }
+            });
+        }
+
+        for (auto& client : clients) {
+            client.join();
+        }
+
+        CHECK(errors == 0);
+        CHECK(echoServer.m_maxConcurrent > 1);
+        CHECK(echoServer.m_maxConcurrent <= 4);
+    }
+
+    server.requestStop();
+    serverThread.join();
+}
+
+TEST_CASE("Socket worker pool server limits")
+{
+    static const std::string socketPath = "secw-worker-pool-limits-test.socket";
+
+    // one worker, two clients, short timeout
+    SlowEchoServer               echoServer;
+    secw::SocketWorkerPoolServer server(echoServer, socketPath, 1, 2, std::chrono::milliseconds(100));
+    std::thread                  serverThread(&secw::SocketWorkerPoolServer::run, &server);
+
+    // the test fails instead of hanging if a reply never comes
+    auto connectWithTimeout = [](const std::string& path) {
+        int     clientSocket = connectTo(path);
+        timeval timeout{5, 0};
+        setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return clientSocket;
+    };
+
+    SECTION("A client sending part of a request does not pin the worker")
+    {
+        int stalledSocket = connectWithTimeout(socketPath);
+        REQUIRE(write(stalledSocket, "\x02\x00", 2) == 2);
+
+        // let the only worker wait for the rest of the request
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        int clientSocket = connectWithTimeout(socketPath);
+        fty::Payload::sendFrames(clientSocket, {"0", "served"});
+
+        std::vector<std::string> reply;
+        CHECK_NOTHROW(reply = fty::Payload::recvFrames(clientSocket));
+        CHECK(reply == std::vector<std::string>({"0", "served"}));
+
+        // the stalled connection is closed by the server
+        char buffer;
+        CHECK(read(stalledSocket, &buffer, 1) == 0);
+
+        close(clientSocket);
+        close(stalledSocket);
+    }
+
+    SECTION("The connections being served count in the limit")
+    {
+        int first  = connectWithTimeout(socketPath);
+        int second = connectWithTimeout(socketPath);
+        fty::Payload::sendFrames(first, {"300", "first"});
+        fty::Payload::sendFrames(second, {"300", "second"});
+
+        // one request executed, one waiting for the worker: no idle connection
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        int  refused = connectWithTimeout(socketPath);
+        char buffer;
+        CHECK(read(refused, &buffer, 1) == 0);
+        close(refused);
+
+        CHECK(fty::Payload::recvFrames(first).at(1) == "first");
+        CHECK(fty::Payload::recvFrames(second).at(1) == "second");
+
+        close(first);
+        close(second);
+    }
+
+    server.requestStop();
+    serverThread.join();
+}
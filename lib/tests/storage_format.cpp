@@ -0,0 +1,318 @@
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <secw_user_and_password.h>
+#include <src/secw_helpers.h>
+#include <src/secw_json_writer.h>
+#include <src/secw_portfolio.h>
+#include <src/secw_storage_format.h>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+size_t fileSize(const std::string& path)
+{
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+    return input ? size_t(input.tellg()) : 0;
+}
+
+cxxtools::SerializationInfo readFile(const std::string& path)
+{
+    std::ifstream input(path, std::ios::binary);
+    return secw::readStorage(input);
+}
+
+std::string encode(const cxxtools::SerializationInfo& si, secw::StorageFormat format)
+{
+    std::ostringstream output;
+    secw::writeStorage(output, si, format);
+    return output.str();
+}
+
+cxxtools::SerializationInfo decode(const std::string& content)
+{
+    std::istringstream input(content);
+    return secw::readStorage(input);
+}
+
+// database with one portfolio of nbDocuments
+cxxtools::SerializationInfo createDatabase(size_t nbDocuments)
+{
+    cxxtools::SerializationInfo rootSi;
+    rootSi.addMember("version") <<= uint8_t(2);
+    rootSi.addMember("journal_sequence") <<= uint64_t(0);
+
+    cxxtools::SerializationInfo& portfoliosSi = rootSi.addMember("portfolios");
+    cxxtools::SerializationInfo& portfolioSi  = portfoliosSi.addMember("");
+    portfolioSi.addMember("version") <<= uint8_t(1);
+    portfolioSi.addMember("name") <<= std::string("default");
+
+    cxxtools::SerializationInfo& documentsSi = portfolioSi.addMember("documents");
+
+    for (size_t index = 0; index < nbDocuments; index++) {
+        secw::UserAndPassword doc("document " + std::to_string(index), "user", "password");
+        doc.addUsage("discovery_monitoring");
+        doc.addTag("benchmark");
+
+        cxxtools::SerializationInfo& docSi = documentsSi.addMember("");
+        docSi <<= doc;
+        docSi.findMember(secw::DOC_ID_ENTRY)->setValue(std::to_string(index));
+    }
+
+    documentsSi.setCategory(cxxtools::SerializationInfo::Array);
+    portfoliosSi.setCategory(cxxtools::SerializationInfo::Array);
+    return rootSi;
+}
+
+} // namespace
+
+TEST_CASE("Storage format")
+{
+    SECTION("Every kind of value is kept")
+    {
+        cxxtools::SerializationInfo rootSi;
+        rootSi.addMember("string") <<= std::string("with \"quotes\", \xc3\xa9 and \n");
+        rootSi.addMember("true") <<= true;
+        rootSi.addMember("negative") <<= int64_t(-1234567890123);
+        rootSi.addMember("big") <<= uint64_t(18446744073709551615ULL);
+        rootSi.addMember("float").setValue(1.5);
+        rootSi.addMember("null").setNull();
+        rootSi.addMember("empty_object").setCategory(cxxtools::SerializationInfo::Object);
+        rootSi.addMember("empty_array").setCategory(cxxtools::SerializationInfo::Array);
+
+        cxxtools::SerializationInfo& arraySi = rootSi.addMember("array");
+        arraySi.addMember("").addMember("nested") <<= std::string("value");
+        arraySi.addMember("") <<= uint8_t(42);
+        arraySi.setCategory(cxxtools::SerializationInfo::Array);
+
+        std::string binary = encode(rootSi, secw::StorageFormat::BINARY);
+
+        CHECK(binary.compare(0, 7, "SECWBIN") == 0);
+        CHECK(secw::serialize(decode(binary)) == secw::serialize(rootSi));
+    }
+
+    SECTION("Database and mapping files are converted back and forth")
+    {
+        for (const char* path : {"tests/selftest-ro/data.json", "tests/selftest-ro/mapping.json"}) {
+            secw::convertStorageFile(path, "storage-format.bin", secw::StorageFormat::BINARY);
+            secw::convertStorageFile("storage-format.bin", "storage-format.json", secw::StorageFormat::JSON);
+
+            std::ifstream binary("storage-format.bin", std::ios::binary);
+            CHECK(secw::detectStorageFormat(binary) == secw::StorageFormat::BINARY);
+
+            CHECK(fileSize("storage-format.bin") < fileSize(path));
+            CHECK(secw::serialize(readFile("storage-format.json")) == secw::serialize(readFile(path)));
+        }
+    }
+
+    SECTION("A corrupted content is rejected")
+    {
+        std::string binary = encode(readFile("tests/selftest-ro/data.json"), secw::StorageFormat::BINARY);
+
+        CHECK_THROWS(decode(binary.substr(0, binary.size() - 1)));
+        CHECK_THROWS(decode(binary.substr(0, 20)));
+
+        cxxtools::SerializationInfo arraySi;
+        arraySi.setCategory(cxxtools::SerializationInfo::Array);
+        CHECK_THROWS(encode(arraySi, secw::StorageFormat::BINARY));
+
+        CHECK(secw::storageFormatFromString("binary") == secw::StorageFormat::BINARY);
+        CHECK_THROWS(secw::storageFormatFromString("xml"));
+    }
+}
+
+TEST_CASE("Portfolio parallel load")
+{
+    cxxtools::SerializationInfo portfolioSi = createDatabase(1000).getMember("portfolios").getMember(0u);
+
+    // an invalid document is skipped, the last document of a duplicated name wins
+    size_t index = 0;
+    for (cxxtools::SerializationInfo& docSi : *portfolioSi.findMember("documents")) {
+        if (index == 10) {
+            docSi.findMember(secw::DOC_TYPE_ENTRY)->setValue("Unknown");
+        } else if (index == 20) {
+            docSi.findMember(secw::DOC_NAME_ENTRY)->setValue("document 999");
+        }
+        index++;
+    }
+
+    secw::PortfolioLoadOptions options;
+
+    secw::Portfolio sequential;
+    options.nbThreads = 1;
+    sequential.loadPortfolio(portfolioSi, options);
+
+    secw::Portfolio parallel;
+    options.nbThreads = 4;
+    parallel.loadPortfolio(portfolioSi, options);
+
+    cxxtools::SerializationInfo sequentialSi;
+    cxxtools::SerializationInfo parallelSi;
+    sequentialSi <<= sequential;
+    parallelSi <<= parallel;
+
+    CHECK(parallel.getSnapshot()->documents.size() == 999);
+    CHECK(parallel.getDocumentByName("document 999")->getId() == "999");
+    CHECK(secw::serialize(parallelSi) == secw::serialize(sequentialSi));
+}
+
+TEST_CASE("Portfolio mapped load")
+{
+    // the public part of the first document cannot be decoded
+    std::string       binary      = encode(createDatabase(3), secw::StorageFormat::BINARY);
+    const std::string publicEntry = secw::DOC_PUBLIC_ENTRY;
+    size_t            position    = binary.find(publicEntry);
+
+    REQUIRE(position != std::string::npos);
+    binary[position + publicEntry.size()] = char(0x7F);
+
+    {
+        std::ofstream output("mapped-load.bin", std::ios::binary | std::ios::trunc);
+        output << binary;
+    }
+
+    auto storage = std::make_shared<secw::MappedStorage>("mapped-load.bin");
+
+    // only the headers are read at load: the body of the first document is not
+    secw::Portfolio portfolio;
+    portfolio.loadPortfolio(storage->getRecord("portfolios").getMembers().at(0).second, storage);
+
+    REQUIRE(portfolio.getSnapshot()->documents.size() == 3);
+    CHECK_THROWS(portfolio.getDocument("0"));
+    CHECK(portfolio.getDocument("1")->getName() == "document 1");
+
+    // its header is given in place of the document, which can still be deleted
+    secw::ConstDocumentPtr header = portfolio.getDocumentOrHeader("0");
+    CHECK(header->isPartial());
+    CHECK(header->getName() == "document 0");
+    CHECK(header->getUsageIds() == std::set<secw::UsageId>{"discovery_monitoring"});
+
+    portfolio.remove("0");
+    CHECK(portfolio.getSnapshot()->documents.size() == 2);
+
+    // its name is available again
+    CHECK_NOTHROW(portfolio.add(std::make_shared<secw::UserAndPassword>("document 0", "user", "password")));
+}
+
+TEST_CASE("Portfolio load benchmark", "[.benchmark]")
+{
+    using namespace std::chrono;
+
+    printf("documents  threads  load (ms)\n");
+
+    for (size_t nbDocuments : {10000, 100000}) {
+        cxxtools::SerializationInfo portfolioSi = createDatabase(nbDocuments).getMember("portfolios").getMember(0u);
+
+        // 0: one per core
+        for (size_t nbThreads : {1, 2, 4, 0}) {
+            secw::PortfolioLoadOptions options;
+            options.nbThreads = nbThreads;
+
+            auto start = steady_clock::now();
+            {
+                secw::Portfolio loaded;
+                loaded.loadPortfolio(portfolioSi, options);
+                REQUIRE(loaded.getSnapshot()->documents.size() == nbDocuments);
+            }
+            auto loadDuration = duration_cast<milliseconds>(steady_clock::now() - start);
+
+            size_t nbUsedThreads = nbThreads ? nbThreads : size_t(std::thread::hardware_concurrency());
+            printf("%9zu  %7zu  %9lld\n", nbDocuments, nbUsedThreads, (long long)loadDuration.count());
+        }
+    }
+}
+
+TEST_CASE("Storage format benchmark", "[.benchmark]")
+{
+    using namespace std::chrono;
+
+    static const std::string path = "storage-format-benchmark";
+
+    printf("documents  format   save (ms)  load (ms)  size (bytes)\n");
+
+    for (size_t nbDocuments : {1000, 10000, 100000}) {
+        cxxtools::SerializationInfo databaseSi = createDatabase(nbDocuments);
+
+        for (secw::StorageFormat format : {secw::StorageFormat::JSON, secw::StorageFormat::BINARY}) {
+            // save: as done by the wallet, from the portfolio to the file
+            secw::Portfolio portfolio;
+            databaseSi.getMember("portfolios").getMember(0u) >>= portfolio;
+
+            auto start = steady_clock::now();
+            {
+                cxxtools::SerializationInfo  rootSi;
+                cxxtools::SerializationInfo& portfoliosSi = rootSi.addMember("portfolios");
+                portfoliosSi.addMember("") <<= portfolio;
+                portfoliosSi.setCategory(cxxtools::SerializationInfo::Array);
+
+                std::ofstream output(path, std::ios::binary | std::ios::trunc);
+                secw::writeStorage(output, rootSi, format);
+            }
+            auto saveDuration = duration_cast<milliseconds>(steady_clock::now() - start);
+
+            // load: from the file to the portfolio
+            start = steady_clock::now();
+            {
+                cxxtools::SerializationInfo rootSi = readFile(path);
+
+                secw::Portfolio loaded;
+                rootSi.getMember("portfolios").getMember(0u) >>= loaded;
+                REQUIRE(loaded.getSnapshot()->documents.size() == nbDocuments);
+            }
+            auto loadDuration = duration_cast<milliseconds>(steady_clock::now() - start);
+
+            printf("%9zu  %-6s  %10lld  %9lld  %12zu\n", nbDocuments,
+                (format == secw::StorageFormat::JSON) ? "json" : "binary", (long long)saveDuration.count(),
+                (long long)loadDuration.count(), fileSize(path));
+        }
+
+        // mapped: only the headers of the documents are decoded
+        auto start = steady_clock::now();
+        {
+            auto storage = std::make_shared<secw::MappedStorage>(path);
+
+            secw::Portfolio loaded;
+            loaded.loadPortfolio(storage->getRecord("portfolios").getMembers().at(0).second, storage);
+            REQUIRE(loaded.getSnapshot()->documents.size() == nbDocuments);
+        }
+        auto mappedDuration = duration_cast<milliseconds>(steady_clock::now() - start);
+
+        printf("%9zu  %-6s  %10s  %9lld  %12zu\n", nbDocuments, "mapped", "-", (long long)mappedDuration.count(),
+            fileSize(path));
+
+        // streamed: compact JSON without the tree of the whole database
+        secw::Portfolio portfolio;
+        databaseSi.getMember("portfolios").getMember(0u) >>= portfolio;
+
+        start = steady_clock::now();
+        {
+            std::ofstream    output(path, std::ios::binary | std::ios::trunc);
+            secw::JsonWriter writer(output);
+
+            writer.beginObject();
+            writer.key("portfolios").beginArray();
+            portfolio.serializePortfolio(writer);
+            writer.endArray();
+            writer.endObject();
+            writer.flush();
+        }
+        auto streamDuration = duration_cast<milliseconds>(steady_clock::now() - start);
+
+        start = steady_clock::now();
+        {
+            cxxtools::SerializationInfo rootSi = readFile(path);
+
+            secw::Portfolio loaded;
+            rootSi.getMember("portfolios").getMember(0u) >>= loaded;
+            REQUIRE(loaded.getSnapshot()->documents.size() == nbDocuments);
+        }
+        auto streamLoadDuration = duration_cast<milliseconds>(steady_clock::now() - start);
+
+        printf("%9zu  %-6s  %10lld  %9lld  %12zu\n", nbDocuments, "stream", (long long)streamDuration.count(),
+            (long long)streamLoadDuration.count(), fileSize(path));
+    }
+
+    std::remove(path.c_str());
+}
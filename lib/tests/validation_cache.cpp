@@ -0,0 +1,117 @@
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <secw_external_certificate.h>
+#include <secw_user_and_password.h>
+#include <src/secw_portfolio.h>
+#include <src/secw_validation_cache.h>
+
+namespace {
+
+const std::string certificate =
+    "-----BEGIN CERTIFICATE-----\n"
+    "MIIB2zCCAYWgAwIBAgIUN/HvX8YlwCFba7U0qW0BPgwcAHMwDQYJKoZIhvcNAQEL\n"
+    "BQAwQjELMAkGA1UEBhMCRlIxFTATBgNVBAcMDERlZmF1bHQgQ2l0eTEcMBoGA1UE\n"
+    "CgwTRGVmYXVsdCBDb21wYW55IEx0ZDAeFw0xOTEyMDMxODE1NDJaFw0yMDEyMDIx\n"
+    "ODE1NDJaMEIxCzAJBgNVBAYTAkZSMRUwEwYDVQQHDAxEZWZhdWx0IENpdHkxHDAa\n"
+    "BgNVBAoME0RlZmF1bHQgQ29tcGFueSBMdGQwXDANBgkqhkiG9w0BAQEFAANLADBI\n"
+    "AkEA1/UeazUNyuF0drHPcyzE17GIkuK2U5GkEQlpB3OcL1ngfvLUD014Wbzhn47G\n"
+    "wKTggcqerU85veFJntMNEmZYpQIDAQABo1MwUTAdBgNVHQ4EFgQUcZ2Mbx7cybRC\n"
+    "dyp9TK5YmZcstJ4wHwYDVR0jBBgwFoAUcZ2Mbx7cybRCdyp9TK5YmZcstJ4wDwYD\n"
+    "VR0TAQH/BAUwAwEB/zANBgkqhkiG9w0BAQsFAANBAJ+Dl5PvMKBAkZ3ozMjbi01O\n"
+    "7ARuj9IBQLsZ+AI9FpqJpc2GQxL+T6KK8Tdyra9V/ogcNZNsSoUsPI421dPKFp0=\n"
+    "-----END CERTIFICATE-----\n";
+
+} // namespace
+
+TEST_CASE("Validation cache")
+{
+    static const std::string path = "validation-cache.json";
+    std::remove(path.c_str());
+
+    secw::ExternalCertificate valid("cached certificate", certificate);
+    secw::ExternalCertificate invalid("invalid certificate", "not a certificate");
+
+    {
+        secw::ValidationCache cache;
+        cache.load(path);
+
+        cache.validate(valid);
+        cache.validate(valid);
+        CHECK_THROWS(cache.validate(invalid));
+        CHECK_THROWS(cache.validate(invalid));
+
+        // a password is always validated, without the digest
+        CHECK_NOTHROW(cache.validate(secw::UserAndPassword("password", "user", "password")));
+
+        CHECK(cache.getStatistics().hits == 1);
+        CHECK(cache.getStatistics().misses == 3);
+
+        cache.save(path);
+    }
+
+    SECTION("The cache is kept between the starts, a modified document is validated again")
+    {
+        secw::ValidationCache cache;
+        cache.load(path);
+
+        cache.validate(valid);
+
+        secw::ExternalCertificate renamed(valid);
+        renamed.setName("renamed certificate");
+        cache.validate(renamed);
+
+        CHECK(cache.getStatistics().hits == 1);
+        CHECK(cache.getStatistics().misses == 1);
+    }
+
+    SECTION("The cache is dropped when the validation rules change")
+    {
+        {
+            std::ifstream input(path);
+            std::string   content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+            input.close();
+
+            content.replace(content.find("\"rules_version\":1"), 17, "\"rules_version\":0");
+
+            std::ofstream output(path, std::ofstream::trunc);
+            output << content;
+        }
+
+        secw::ValidationCache cache;
+        cache.load(path);
+
+        cache.validate(valid);
+
+        CHECK(cache.getStatistics().hits == 0);
+        CHECK(cache.getStatistics().misses == 1);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Validation cache per load")
+{
+    secw::Portfolio portfolio("default");
+    portfolio.add(std::make_shared<secw::ExternalCertificate>("cached certificate", certificate));
+
+    cxxtools::SerializationInfo portfolioSi;
+    portfolioSi <<= portfolio;
+
+    // two wallets of the same process: each load validates through its own cache only
+    secw::PortfolioLoadOptions first;
+    secw::PortfolioLoadOptions second;
+    first.validationCache  = std::make_shared<secw::ValidationCache>();
+    second.validationCache = std::make_shared<secw::ValidationCache>();
+
+    secw::Portfolio loaded;
+    loaded.loadPortfolio(portfolioSi, first);
+    loaded.loadPortfolio(portfolioSi, first);
+    loaded.loadPortfolio(portfolioSi, second);
+
+    CHECK(first.validationCache->getStatistics().hits == 1);
+    CHECK(first.validationCache->getStatistics().misses == 1);
+    CHECK(second.validationCache->getStatistics().hits == 0);
+    CHECK(second.validationCache->getStatistics().misses == 1);
+}